@@ -168,6 +168,54 @@ run_part_a3() {
     read -p "Press Enter to continue..."
 }
 
+# ============================================================================
+# PART A4: Discard Receiver (calibration baseline)
+# ============================================================================
+run_part_a4() {
+    print_banner
+    echo -e "${BOLD}PART A4: Discard Receiver (recv with MSG_TRUNC)${NC}"
+    echo ""
+    echo "The client drops received data in the kernel without copying it."
+    echo "Pair it with any server to measure the sender without the receive copy."
+    echo ""
+
+    read -p "Server to calibrate (1=A1, 2=A2, 3=A3) [1]: " server_choice
+    server_choice=${server_choice:-1}
+    case $server_choice in
+        2|3) ;;
+        *) server_choice=1 ;;
+    esac
+
+    get_params
+
+    mkdir -p results
+
+    echo -e "${YELLOW}[1/3] Starting A${server_choice} Server with PERF (sender) in background...${NC}"
+    ip netns exec server_ns perf stat -e cycles,cache-misses,cache-references,context-switches \
+        ./MT25033_Part_A${server_choice}_Server -p $PORT -s $msg_size -d $duration > results/a4_server.txt 2>&1 &
+    SERVER_PID=$!
+    sleep 2
+
+    echo -e "${YELLOW}[2/3] Starting Discard Client (receiver)...${NC}"
+    echo ""
+    ip netns exec client_ns ./MT25033_Part_A4_Client -i $SERVER_IP -p $PORT -s $msg_size -t $threads -d $duration 2>&1 | tee results/a4_client.txt
+
+    echo ""
+    echo -e "${YELLOW}[3/3] Waiting for server to finish...${NC}"
+    wait $SERVER_PID 2>/dev/null
+
+    echo ""
+    echo -e "${GREEN}════════════════════════════════════════════════${NC}"
+    echo -e "${GREEN}PART A4 COMPLETE - Results saved to results/${NC}"
+    echo -e "${GREEN}════════════════════════════════════════════════${NC}"
+    echo ""
+    echo -e "${CYAN}Server perf output:${NC}"
+    cat results/a4_server.txt | grep -E "cycles|instructions|cache|context"
+    echo ""
+
+    read -p "Press Enter to continue..."
+}
+
 # ============================================================================
 # PART B: Run All Experiments and Generate CSV
 # ============================================================================
@@ -179,10 +227,16 @@ run_part_b() {
     echo "Creates CSV files for analysis."
     echo ""
 
-    # Message sizes (1KB to 16MB)
-    MSG_SIZES=(1024 4096 65536 1048576 4194304 16777216)
-    THREAD_COUNTS=(1 2 4 8)
-    DURATION=10
+    # Message sizes (1KB to 16MB), thread counts and duration: the "menu"
+    # profile of the sweep spec (MT25033_Part_C_Spec.json)
+    MSG_SIZES=($(python3 MT25033_Part_C_Runner.py values size --profile menu))
+    THREAD_COUNTS=($(python3 MT25033_Part_C_Runner.py values threads --profile menu))
+    DURATION=$(python3 MT25033_Part_C_Runner.py values duration --profile menu)
+    if [ ${#MSG_SIZES[@]} -eq 0 ] || [ ${#THREAD_COUNTS[@]} -eq 0 ] || [ -z "$DURATION" ]; then
+        echo -e "${RED}Cannot read MT25033_Part_C_Spec.json${NC}"
+        read -p "Press Enter to continue..."
+        return
+    fi
 
     mkdir -p results
 
@@ -411,6 +465,7 @@ main_menu() {
         echo "  │  1) Part A1: Two-Copy (send/recv)               │"
         echo "  │  2) Part A2: One-Copy (sendmsg/iovec)           │"
         echo "  │  3) Part A3: Zero-Copy (MSG_ZEROCOPY)           │"
+        echo "  │  4) Part A4: Discard Receiver (MSG_TRUNC)       │"
         echo "  ├─────────────────────────────────────────────────┤"
         echo "  │  B) Part B: Profile All (generates CSV)         │"
         echo "  │  D) Part D: Generate Plots                      │"
@@ -425,6 +480,7 @@ main_menu() {
             1) run_part_a1 ;;
             2) run_part_a2 ;;
             3) run_part_a3 ;;
+            4) run_part_a4 ;;
             b|B) run_part_b ;;
             d|D) run_part_d ;;
             v|V) view_results ;;
@@ -18,25 +18,120 @@
  */
 
 #include "MT25033_Part_A_Common.h"
+#include "MT25033_Part_A_Mux.h"
+#include "MT25033_Part_A_Stripe.h"
+#include "MT25033_Part_A_Steer.h"
+#include "MT25033_Part_A_Qdepth.h"
 #include <sys/uio.h>
 #include <signal.h>
 #include <getopt.h>
 
-/* Global flag for graceful shutdown */
-static volatile int running = 1;
-
-/* Signal handler for graceful termination */
+/* Signal handler for graceful termination: wakes every thread through the run eventfd */
 void signal_handler(int signum) {
     (void)signum;
-    running = 0;
+    run_stop();
 }
 
-/* Alarm handler to stop server after duration */
-void alarm_handler(int signum) {
-    (void)signum;
-    running = 0;
+/*
+ * Lazy mode send hook: non-blocking sendmsg() over the pooled message's fields
+ */
+static ssize_t lazy_send(int fd, PooledMessage *pm, size_t field_size,
+                         size_t offset, size_t len, void *ctx) {
+    struct iovec iov[NUM_FIELDS];
+    struct msghdr mh;
+    (void)len;
+    (void)ctx;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov;
+    mh.msg_iovlen = message_iov(pm->msg, field_size, offset, iov);
+    return sendmsg(fd, &mh, MSG_DONTWAIT);
+}
+
+/* Queue-depth mode send hook: one sendmsg() over the whole batch's fields */
+static ssize_t qdepth_send(int fd, struct msghdr *mh, int flags, void *ctx) {
+    (void)ctx;
+    return sendmsg(fd, mh, flags);
+}
+
+/* State of one connection's plain send loop */
+struct SendCtx {
+    int fd;
+    Message *msg;
+    struct msghdr *mh;             /* All fields of one message */
+    size_t field_size;
+    CreditState credit;
+    RunWindow win;
+};
+
+/*
+ * Plain send loop, specialised per flags (LOOP_CREDIT, LOOP_INSTR)
+ * Sends messages continuously until the measurement window closes
+ */
+LOOP_INLINE void send_loop(ServerThreadArgs *args, struct SendCtx *ctx, const unsigned flags) {
+    int client_fd = ctx->fd;
+    size_t total_msg_size = NUM_FIELDS * ctx->field_size;
+    size_t offset = 0;             /* Bytes of the current message already sent */
+    struct iovec rest_iov[NUM_FIELDS];
+    struct msghdr rest;            /* Remainder of a partially sent message */
+    memset(&rest, 0, sizeof(rest));
+    rest.msg_iov = rest_iov;
+
+    while (window_live(&ctx->win)) {
+        /* In credit mode, wait until the client has granted room for a full message */
+        if ((flags & LOOP_CREDIT) && offset == 0 &&
+            credit_acquire(client_fd, &ctx->credit, total_msg_size, &ctx->win) < 0) {
+            break;
+        }
+
+        struct msghdr *out = ctx->mh;
+        if (offset > 0) {
+            rest.msg_iovlen = message_iov(ctx->msg, ctx->field_size, offset, rest_iov);
+            out = &rest;
+        }
+
+        /*
+         * ONE-COPY sendmsg():
+         * The kernel gathers data from multiple iovec buffers directly
+         * without requiring a contiguous user-space copy first.
+         * Data flows: User buffers -> Kernel -> NIC
+         * MSG_DONTWAIT: a full socket buffer is waited out in run_wait()
+         */
+        uint64_t t0 = (flags & LOOP_INSTR) ? get_time_ns() : 0;
+        ssize_t sent = sendmsg(client_fd, out, MSG_DONTWAIT);
+        if (flags & LOOP_INSTR) {
+            loop_stats_call(&args->loop_stats, t0, sent, total_msg_size - offset);
+        }
+
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (flags & LOOP_INSTR) args->loop_stats.waits++;
+                if (run_wait(client_fd, POLLOUT, &ctx->win, -1) < 0) break;
+                continue;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EPIPE || errno == ECONNRESET) {
+                printf("[Thread %d] Client disconnected\n", args->thread_id);
+                break;
+            }
+            perror("sendmsg failed");
+            break;
+        }
+
+        args->bytes_sent += sent;
+        core_account(sent);
+        offset += sent;
+        if (offset == total_msg_size) {
+            offset = 0;
+            args->messages_sent++;
+        }
+        if (flags & LOOP_CREDIT) {
+            credit_consume(&ctx->credit, sent);
+        }
+    }
 }
 
+SPECIALIZE_SEND_LOOP(send_loop);
+
 /*
  * Thread function to handle a single client connection
  * Uses sendmsg() with iovec for scatter-gather I/O
@@ -46,6 +141,46 @@ void* handle_client(void *arg) {
     int client_fd = args->client_fd;
     size_t field_size = args->msg_size / NUM_FIELDS;
 
+    /* Multiplexed mode: several framed streams share this connection */
+    if (args->mux) {
+        args->bytes_sent = 0;
+        args->messages_sent = 0;
+        RunWindow win;
+        window_open(&win, args->window_end);
+        mux_serve(args, client_fd, args->mux, 0, 0, &win);
+        args->elapsed_time = window_elapsed(&win);
+        printf("[Thread %d] Finished: sent %lu bytes (%lu messages) in %.2f seconds\n",
+               args->thread_id, args->bytes_sent, args->messages_sent, args->elapsed_time);
+        close(client_fd);
+        return NULL;
+    }
+
+    /* Striped mode: this connection carries part of one client stream's chunks */
+    if (args->stripe_chunk) {
+        args->bytes_sent = 0;
+        args->messages_sent = 0;
+        RunWindow win;
+        window_open(&win, args->window_end);
+        stripe_serve(args, client_fd, 0, 0, &win);
+        args->elapsed_time = window_elapsed(&win);
+        printf("[Thread %d] Finished: sent %lu bytes (%lu messages) in %.2f seconds\n",
+               args->thread_id, args->bytes_sent, args->messages_sent, args->elapsed_time);
+        close(client_fd);
+        return NULL;
+    }
+
+    /* Lazy mode: a buffer from the shared pool only while the socket accepts data */
+    if (args->pool) {
+        RunWindow win;
+        window_open(&win, args->window_end);
+        lazy_serve(args, client_fd, lazy_send, NULL, NULL, &win);
+        args->elapsed_time = window_elapsed(&win);
+        printf("[Thread %d] Finished: sent %lu bytes (%lu messages) in %.2f seconds\n",
+               args->thread_id, args->bytes_sent, args->messages_sent, args->elapsed_time);
+        close(client_fd);
+        return NULL;
+    }
+
     /* Create message with heap-allocated fields */
     Message *msg = create_message(field_size);
     if (!msg) {
@@ -77,42 +212,44 @@ void* handle_client(void *arg) {
     size_t total_msg_size = NUM_FIELDS * field_size;
     args->bytes_sent = 0;
     args->messages_sent = 0;
+    args->credit_stalls = 0;
 
-    double start_time = get_time_sec();
-    double end_time = start_time + args->duration;
+    struct SendCtx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.fd = client_fd;
+    ctx.msg = msg;
+    ctx.mh = &mh;
+    ctx.field_size = field_size;
+    window_open(&ctx.win, args->window_end);
 
     printf("[Thread %d] Starting to send messages using sendmsg() (size=%zu bytes)\n",
            args->thread_id, total_msg_size);
 
-    /* Send messages continuously until duration expires */
-    while (running && get_time_sec() < end_time) {
-        /*
-         * ONE-COPY sendmsg():
-         * The kernel gathers data from multiple iovec buffers directly
-         * without requiring a contiguous user-space copy first.
-         * Data flows: User buffers -> Kernel -> NIC
-         */
-        ssize_t sent = sendmsg(client_fd, &mh, 0);
-
-        if (sent < 0) {
-            if (errno == EPIPE || errno == ECONNRESET) {
-                printf("[Thread %d] Client disconnected\n", args->thread_id);
-                break;
-            }
-            perror("sendmsg failed");
-            break;
-        }
-
-        args->bytes_sent += sent;
-        args->messages_sent++;
+    if (args->qdepth) {
+        /* Queue-depth mode: batches sized to keep the send queue near the target */
+        qdepth_serve(args, client_fd, iov, NUM_FIELDS, qdepth_send, NULL, NULL, &ctx.win);
+    } else {
+        /* Loop specialised for this connection's options */
+        send_loop_variants[loop_flags(args->use_credit, args->instrument, 0)](args, &ctx);
     }
 
-    args->elapsed_time = get_time_sec() - start_time;
+    args->elapsed_time = window_elapsed(&ctx.win);
+    args->credit_stalls = ctx.credit.stalls;
 
     printf("[Thread %d] Finished: sent %lu bytes (%lu messages) in %.2f seconds\n",
            args->thread_id, args->bytes_sent, args->messages_sent, args->elapsed_time);
     printf("[Thread %d] Throughput: %.4f Gbps\n",
            args->thread_id, calc_throughput_gbps(args->bytes_sent, args->elapsed_time));
+    if (args->use_credit) {
+        printf("[Thread %d] Credit stalls: %lu\n", args->thread_id, args->credit_stalls);
+    }
+    if (args->instrument) {
+        loop_stats_print(args->thread_id, "Send", &args->loop_stats);
+    }
+
+    if (args->use_credit) {
+        credit_drain(client_fd, &ctx.credit);
+    }
 
     /* Cleanup */
     free_message(msg);
@@ -125,10 +262,30 @@ int main(int argc, char *argv[]) {
     int port = DEFAULT_PORT;
     size_t msg_size = DEFAULT_MSG_SIZE;
     int duration = DEFAULT_DURATION;
+    int use_credit = 0;
+    const char *mux_spec = NULL;
+    int priority = -1;
+    int family = FAMILY_INET;
+    int snapshot_interval = 0;
+    int workers = 1;
+    int reuseport = 0;
+    int max_conns = 100;
+    size_t stack_kb = 0;
+    int lazy = 0;
+    int stripe = 0;
+    int steer = STEER_OFF;
+    int instrument = 0;
+    int topdown = 0;
+    int kstats = 0;
+    size_t qdepth = 0;
+    const char *placement_spec = NULL;
+    CorePlacement placement;
+    MuxConfig mux_cfg;
+    memset(&mux_cfg, 0, sizeof(mux_cfg));
     int opt;
 
     /* Parse command line arguments */
-    while ((opt = getopt(argc, argv, "p:s:d:h")) != -1) {
+    while ((opt = getopt(argc, argv, "p:s:d:cm:k:r:O:P:S:f:Rn:T:LI:U:K:Q:A:GF:C:h")) != -1) {
         switch (opt) {
             case 'p':
                 port = atoi(optarg);
@@ -139,6 +296,74 @@ int main(int argc, char *argv[]) {
             case 'd':
                 duration = atoi(optarg);
                 break;
+            case 'c':
+                use_credit = 1;
+                break;
+            case 'm':
+                mux_spec = optarg;
+                break;
+            case 'k':
+                mux_cfg.chunk = atoi(optarg);
+                break;
+            case 'r':
+                mux_cfg.drr = strcmp(optarg, "drr") == 0;
+                break;
+            case 'O':
+                mux_cfg.rate = atof(optarg);
+                break;
+            case 'G':
+                stripe = 1;
+                break;
+            case 'F':
+                family = parse_family(optarg);
+                if (family < 0) {
+                    fprintf(stderr, "Invalid family '%s' (4, 6 or 46)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'C':
+                steer = parse_steer_mode(optarg);
+                if (steer < 0) {
+                    fprintf(stderr, "Invalid steering mode '%s' (incoming, cbpf or random)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'P':
+                priority = atoi(optarg);
+                break;
+            case 'S':
+                snapshot_interval = atoi(optarg);
+                break;
+            case 'f':
+                workers = atoi(optarg);
+                break;
+            case 'R':
+                reuseport = 1;
+                break;
+            case 'n':
+                max_conns = atoi(optarg);
+                break;
+            case 'T':
+                stack_kb = strtoul(optarg, NULL, 10);
+                break;
+            case 'L':
+                lazy = 1;
+                break;
+            case 'I':
+                instrument = atoi(optarg);
+                break;
+            case 'U':
+                topdown = atoi(optarg);
+                break;
+            case 'K':
+                kstats = atoi(optarg);
+                break;
+            case 'Q':
+                qdepth = strtoul(optarg, NULL, 10);
+                break;
+            case 'A':
+                placement_spec = optarg;
+                break;
             case 'h':
             default:
                 print_usage(argv[0], 1);
@@ -146,136 +371,363 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    /* Set up signal handler for graceful shutdown */
-    signal(SIGINT, signal_handler);
-    signal(SIGPIPE, SIG_IGN);
-    signal(SIGALRM, alarm_handler);
-
-    /* Set alarm to stop server after duration + buffer time */
-    alarm(duration + 5);
-
-    /* Create server socket */
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd < 0) {
-        perror("socket creation failed");
+    /* Open loop without -m: one stream of the message size */
+    char rate_spec[32];
+    if (mux_cfg.rate > 0 && !mux_spec) {
+        snprintf(rate_spec, sizeof(rate_spec), "%zu", msg_size);
+        mux_spec = rate_spec;
+    }
+    if (mux_spec && parse_mux_spec(mux_spec, &mux_cfg) < 0) {
+        fprintf(stderr, "Invalid stream spec '%s' (expected sizes[:weight],...)\n", mux_spec);
         exit(EXIT_FAILURE);
     }
 
-    /* Allow address reuse */
-    int reuse = 1;
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
-        perror("setsockopt SO_REUSEADDR failed");
-        close(server_fd);
+    /* The links of a stripe share a counter, so they must reach one process */
+    size_t stripe_chunk = 0;
+    if (stripe) {
+        if (mux_spec || workers > 1 || lazy || qdepth) {
+            fprintf(stderr, "-G cannot be combined with -m, -O, -f, -L or -Q\n");
+            exit(EXIT_FAILURE);
+        }
+        stripe_chunk = mux_cfg.chunk ? mux_cfg.chunk : STRIPE_DEFAULT_CHUNK;
+        if (stripe_chunk > STRIPE_MAX_CHUNK) {
+            fprintf(stderr, "Striped chunks are at most %lu bytes\n", STRIPE_MAX_CHUNK);
+            exit(EXIT_FAILURE);
+        }
+    }
+    /* cbpf needs one listener per worker */
+    if (steer == STEER_CBPF && !(workers > 1 && reuseport)) {
+        fprintf(stderr, "-C cbpf needs -f <workers> -R\n");
+        exit(EXIT_FAILURE);
+    }
+    if (steer == STEER_CBPF && workers > STEER_MAX_LISTENERS) {
+        fprintf(stderr, "-C cbpf supports at most %d workers\n", STEER_MAX_LISTENERS);
+        exit(EXIT_FAILURE);
+    }
+    if (placement_spec && parse_core_placement(placement_spec, &placement) < 0) {
+        fprintf(stderr, "Invalid placement '%s' (core, atom, any or a CPU list "
+                "of this machine)\n", placement_spec);
+        exit(EXIT_FAILURE);
+    }
+    /* Steering pins connection threads itself; -A may only count (any) */
+    if (steer && placement_spec && placement.pin) {
+        fprintf(stderr, "-C cannot be combined with a pinning -A placement\n");
         exit(EXIT_FAILURE);
     }
 
-    /* Set accept timeout so server doesn't block forever */
-    struct timeval timeout;
-    timeout.tv_sec = 2;
-    timeout.tv_usec = 0;
-    setsockopt(server_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-
-    /* Bind to address */
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(port);
+    /* Set up signal handler for graceful shutdown */
+    signal(SIGINT, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
 
-    if (bind(server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        perror("bind failed");
-        close(server_fd);
+    /* Multi-process mode: workers share this listener unless each binds its own */
+    WorkerStats *worker_stats = NULL;
+    int worker_id = -1;
+    if (workers > 1 && !(worker_stats = worker_stats_alloc(workers))) {
         exit(EXIT_FAILURE);
     }
 
-    /* Listen for connections */
-    if (listen(server_fd, 10) < 0) {
-        perror("listen failed");
-        close(server_fd);
-        exit(EXIT_FAILURE);
+    /* Create server socket */
+    int server_fd = (workers > 1 && reuseport) ? -1 : create_listen_socket(port, 0, family);
+    int steer_fds[STEER_MAX_LISTENERS];
+    if (steer == STEER_CBPF) {
+        steer_open_listeners(steer_fds, workers, port, family);
     }
 
     printf("=== One-Copy Server (sendmsg with iovec) ===\n");
+    printf("Build variant: %s\n", BUILD_VARIANT);
     printf("Listening on port %d\n", port);
+    if (family != FAMILY_INET) {
+        printf("Address family: %s\n", family_name(family));
+    }
     printf("Message size: %zu bytes, Duration: %d seconds\n", msg_size, duration);
+    if (use_credit) {
+        printf("Credit mode: sending only within client-granted credit\n");
+    }
+    if (priority >= 0) {
+        printf("Socket priority: %d\n", priority);
+    }
+    if (mux_spec) {
+        printf("Multiplexed: %d streams, %zu-byte chunks, %s scheduling\n",
+               mux_cfg.count, mux_cfg.chunk, mux_cfg.drr ? "weighted DRR" : "round-robin");
+    }
+    if (mux_cfg.rate > 0) {
+        printf("Open loop: %.0f messages/s per connection, latency from the scheduled start\n",
+               mux_cfg.rate);
+    }
+    if (stripe) {
+        printf("Striped: the links of one client stream share %zu-byte chunks\n", stripe_chunk);
+    }
     printf("Using scatter-gather I/O to eliminate one copy\n");
+    if (lazy) {
+        printf("Lazy buffers: pooled, held only while the socket accepts data\n");
+    }
+    if (instrument) {
+        printf("Instrumented send loop: syscall timing and counts\n");
+    }
+    if (topdown) {
+        printf("Top-down and cache counters per connection (perf_event_open)\n");
+    }
+    if (kstats) {
+        printf("Kernel counter deltas over the window (snmp, netstat, softnet, vmstat)\n");
+    }
+    if (placement_spec) {
+        core_placement_print(&placement);
+    }
+    if (steer) {
+        printf("CPU steering: %s\n", steer_name(steer));
+    }
+    if (qdepth) {
+        printf("Queue-depth batching: keep %zu not-sent bytes queued (SIOCOUTQNSD)\n", qdepth);
+    }
+    if (stack_kb > 0) {
+        printf("Thread stack: %zu KB, max connections: %d\n", stack_kb, max_conns);
+    }
+    if (workers > 1) {
+        printf("Worker processes: %d (%s)\n", workers,
+               reuseport ? "SO_REUSEPORT listener each" : "shared listener");
+    }
     printf("Waiting for clients...\n\n");
 
+    /* Package/DRAM energy (RAPL) over the measurement window */
+    EnergyMeter energy;
+    energy_open(&energy);
+    CpuMeter cpu;
+    memset(&cpu, 0, sizeof(cpu));
+    KstatSnap kstat_before = {0, NULL}, kstat_after = {0, NULL};
+
+    if (workers > 1) {
+        /* The parent drops the steered listeners, so a worker's exit closes its own */
+        worker_id = fork_workers(worker_stats, workers, steer_fds,
+                                 steer == STEER_CBPF ? workers : 0);
+        if (worker_id < 0) {
+            /* Parent: meter from the first worker window opening to the last one closing */
+            int metering = 0, all_closed = 0;
+            while (!all_closed) {
+                if (workers_poll(worker_stats, workers, &all_closed) && !metering) {
+                    energy_start(&energy);
+                    cpu_start(&cpu);
+                    if (kstats) kstat_take(&kstat_before);
+                    metering = 1;
+                }
+                energy_sample(&energy);
+                if (!all_closed) usleep(WORKER_POLL_MS * 1000);
+            }
+            energy_stop(&energy);
+            cpu_stop(&cpu);
+            if (metering && kstats) kstat_take(&kstat_after);
+            workers_wait();
+            workers_cpu(worker_stats, workers, &cpu);
+            unsigned long worker_bytes = 0;
+            for (int i = 0; i < workers; i++) worker_bytes += worker_stats[i].bytes;
+            report_workers(worker_stats, workers, reuseport, use_credit,
+                           placement_spec ? &placement : NULL);
+            if (steer) {
+                unsigned long steered = 0, on_incoming = 0;
+                for (int i = 0; i < workers; i++) {
+                    steered += worker_stats[i].steered;
+                    on_incoming += worker_stats[i].on_incoming;
+                }
+                steer_report(steer, steered, on_incoming);
+            }
+            energy_report(&energy, worker_bytes);
+            cpu_report("server", &cpu);
+            kstat_report("server", &kstat_before, &kstat_after);
+            kstat_free(&kstat_before);
+            kstat_free(&kstat_after);
+            worker_stats_free(worker_stats, workers);
+            if (server_fd >= 0) close(server_fd);
+            return 0;
+        }
+        energy.running = 0;        /* Only the parent measures */
+        kstats = 0;
+        kstat_free(&kstat_before);
+        if (steer == STEER_CBPF) {
+            server_fd = steer_take_listener(steer_fds, workers, worker_id);
+        } else if (reuseport) {
+            server_fd = create_listen_socket(port, 1, family);
+        }
+    }
+
+    /* Shutdown eventfd and run timer (per worker after a fork) */
+    run_init();
+    int run_timer = run_timer_create();
+    RunWindow run_window;
+    run_timer_arm(run_timer, &run_window, duration + RUN_CONNECT_GRACE);
+
     int thread_id = 0;
-    pthread_t *threads = NULL;
-    ServerThreadArgs *thread_args = NULL;
-    int num_threads = 0;
-    int max_threads = 100;
+    unsigned int steer_seed = (unsigned int)getpid();
+    ConnTable conns;
+
+    /* Per-connection footprint: thread stack size and (lazy) shared buffers */
+    pthread_attr_t attr;
+    pthread_attr_t *conn_attr = conn_thread_attr(&attr, stack_kb);
+    MessagePool pool;
+    if (lazy) {
+        pool_init(&pool, msg_size / NUM_FIELDS, 0);
+    }
 
-    threads = (pthread_t*)malloc(max_threads * sizeof(pthread_t));
-    thread_args = (ServerThreadArgs*)malloc(max_threads * sizeof(ServerThreadArgs));
+    if (conn_table_init(&conns, max_conns) < 0) {
+        perror("Failed to allocate thread resources");
+        close(server_fd);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Optional resource snapshots for soak runs */
+    pthread_t snap_tid;
+    SnapshotArgs snap_args = { &conns, snapshot_interval };
+    int snap_started = snapshot_interval > 0 &&
+                       pthread_create(&snap_tid, NULL, snapshot_thread, &snap_args) == 0;
 
     /* Accept clients and spawn threads */
-    while (running) {
-        struct sockaddr_in client_addr;
+    int measuring = 0;
+    while (run_active()) {
+        /* Join finished connections so their slots can be reused */
+        conn_table_reap(&conns, 0);
+        energy_sample(&energy);
+
+        int ready = run_accept_wait(server_fd, run_timer);
+        if (ready < 0) break;
+        if (ready == 0) continue;
+
+        struct sockaddr_storage client_addr;
         socklen_t client_len = sizeof(client_addr);
 
         int client_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
         if (client_fd < 0) {
-            if (errno == EINTR) continue;
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
             perror("accept failed");
             continue;
         }
 
-        printf("Client connected from %s:%d\n",
-               inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-
-        if (num_threads >= max_threads) {
-            printf("Maximum threads reached, rejecting client\n");
-            close(client_fd);
-            continue;
+        char peer[PEER_STRLEN];
+        printf("Client connected from %s\n",
+               format_peer(&client_addr, peer, sizeof(peer)));
+
+        /* The measurement window opens with the first client */
+        if (!measuring) {
+            run_timer_arm(run_timer, &run_window, duration);
+            if (worker_id < 0) {
+                energy_start(&energy);
+            } else {
+                worker_window_mark(&worker_stats[worker_id], 0);
+            }
+            cpu_start(&cpu);
+            if (kstats) kstat_take(&kstat_before);
+            measuring = 1;
         }
 
+        /* Traffic class for the prio qdisc (mixed latency/bulk runs) */
+        set_socket_priority(client_fd, priority);
+
         /* Set up thread arguments */
-        thread_args[num_threads].client_fd = client_fd;
-        thread_args[num_threads].thread_id = thread_id++;
-        thread_args[num_threads].msg_size = msg_size;
-        thread_args[num_threads].duration = duration;
-
-        /* Create thread to handle client */
-        if (pthread_create(&threads[num_threads], NULL, handle_client,
-                          &thread_args[num_threads]) != 0) {
-            perror("pthread_create failed");
+        ServerThreadArgs targs;
+        memset(&targs, 0, sizeof(targs));
+        targs.client_fd = client_fd;
+        targs.thread_id = thread_id++;
+        targs.msg_size = msg_size;
+        targs.duration = duration;
+        targs.window_end = run_window.end;
+        targs.use_credit = use_credit;
+        targs.instrument = instrument;
+        targs.topdown = topdown;
+        targs.qdepth = qdepth;
+        targs.placement = placement_spec ? &placement : NULL;
+        if (steer) {
+            steer_connection(&targs, steer, &steer_seed);
+        }
+        targs.mux = mux_spec ? &mux_cfg : NULL;
+        targs.stripe_chunk = stripe_chunk;
+        targs.pool = lazy ? &pool : NULL;
+
+        /* Create thread to handle client (slot is freed again on failure) */
+        if (conn_table_start(&conns, &targs, handle_client, conn_attr) < 0) {
             close(client_fd);
             continue;
         }
+    }
 
-        num_threads++;
+    /* The window has closed (or the run was stopped) */
+    energy_stop(&energy);
+    cpu_stop(&cpu);
+    if (worker_id >= 0) {
+        worker_window_mark(&worker_stats[worker_id], 1);
     }
+    if (kstats && kstat_before.e) kstat_take(&kstat_after);
 
     /* Wait for all threads to complete */
     printf("\nShutting down, waiting for threads...\n");
-    for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+    conn_table_reap(&conns, 1);
+    if (snap_started) {
+        pthread_join(snap_tid, NULL);
     }
 
     /* Calculate total metrics */
-    unsigned long total_bytes = 0;
-    unsigned long total_messages = 0;
-    double max_time = 0;
-
-    for (int i = 0; i < num_threads; i++) {
-        total_bytes += thread_args[i].bytes_sent;
-        total_messages += thread_args[i].messages_sent;
-        if (thread_args[i].elapsed_time > max_time) {
-            max_time = thread_args[i].elapsed_time;
+    unsigned long total_bytes = conns.total_bytes;
+    unsigned long total_messages = conns.total_messages;
+    unsigned long total_stalls = conns.total_stalls;
+    double max_time = conns.max_time;
+
+    /* Worker process: hand the totals to the parent */
+    if (worker_id >= 0) {
+        worker_stats_store(&worker_stats[worker_id], &conns, &cpu);
+        printf("\n[Worker %d] %lu connections, %lu bytes sent\n",
+               worker_id, conns.finished, total_bytes);
+        printf("[Worker %d] ", worker_id);
+        bufpool_report("server");
+        if (instrument) {
+            printf("[Worker %d] ", worker_id);
+            loop_stats_print(-1, "Send", &conns.loop_stats);
         }
+        if (lazy) {
+            printf("[Worker %d] Buffer pool: %lu buffers created, peak %lu in use\n",
+                   worker_id, pool.created, pool.peak_in_use);
+        }
+        conn_table_free(&conns);
+        close(server_fd);
+        close(run_timer);
+        return 0;
     }
 
     printf("\n=== Final Statistics ===\n");
     printf("Total bytes sent: %lu\n", total_bytes);
     printf("Total messages sent: %lu\n", total_messages);
     printf("Aggregate throughput: %.4f Gbps\n", calc_throughput_gbps(total_bytes, max_time));
+    if (use_credit) {
+        printf("Credit stalls: %lu\n", total_stalls);
+    }
+    if (lazy) {
+        printf("Buffer pool: %lu buffers created, peak %lu in use\n",
+               pool.created, pool.peak_in_use);
+    }
+    if (instrument) {
+        loop_stats_print(-1, "Send", &conns.loop_stats);
+    }
+    if (topdown) {
+        tma_report("server", &conns.tma, total_bytes);
+    }
+    if (placement_spec) {
+        core_report("server", &placement, &conns.cores);
+    }
+    if (steer) {
+        steer_report(steer, conns.steered, conns.on_incoming);
+    }
+    energy_report(&energy, total_bytes);
+    cpu_report("server", &cpu);
+    kstat_report("server", &kstat_before, &kstat_after);
+    bufpool_report("server");
 
     /* Cleanup */
-    free(threads);
-    free(thread_args);
+    kstat_free(&kstat_before);
+    kstat_free(&kstat_after);
+    if (lazy) {
+        pool_destroy(&pool);
+    }
+    if (conn_attr) {
+        pthread_attr_destroy(conn_attr);
+    }
+    conn_table_free(&conns);
     close(server_fd);
+    close(run_timer);
 
     return 0;
 }
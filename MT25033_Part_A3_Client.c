@@ -12,6 +12,9 @@
  */
 
 #include "MT25033_Part_A_Common.h"
+#include "MT25033_Part_A_Qdepth.h"
+#include "MT25033_Part_A_Mux.h"
+#include "MT25033_Part_A_Stripe.h"
 #include <sys/uio.h>
 #include <signal.h>
 #include <getopt.h>
@@ -22,6 +25,9 @@ static volatile int running = 1;
 /* Global metrics protected by mutex */
 static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
 static Metrics global_metrics = {0};
+static TmaCounts global_tma;
+static CoreCounts global_cores;
+static LatencyHistogram global_hist;
 
 /* Signal handler for graceful termination */
 void signal_handler(int signum) {
@@ -29,35 +35,95 @@ void signal_handler(int signum) {
     running = 0;
 }
 
+/* State of one connection's plain receive loop */
+struct RecvCtx {
+    int fd;
+    struct msghdr *mh;             /* Page-aligned receive buffer */
+    size_t msg_size;
+    CreditGranter *granter;
+    double end_time;
+};
+
+/*
+ * Plain receive loop, specialised per flags (LOOP_CREDIT, LOOP_INSTR,
+ * LOOP_SLOW_READER)
+ */
+LOOP_INLINE void recv_loop(ClientThreadArgs *args, struct RecvCtx *ctx, const unsigned flags) {
+    int sock_fd = ctx->fd;
+    size_t msg_size = ctx->msg_size;
+
+    /* Receive messages continuously until duration expires */
+    while (running && get_time_sec() < ctx->end_time) {
+        uint64_t t0 = (flags & LOOP_INSTR) ? get_time_ns() : 0;
+
+        ssize_t received = recvmsg(sock_fd, ctx->mh, 0);
+
+        uint64_t recv_ns = (flags & LOOP_INSTR) ?
+                           loop_stats_call(&args->loop_stats, t0, received, msg_size) : 0;
+
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            perror("recvmsg failed");
+            break;
+        }
+
+        if (received == 0) {
+            printf("[Thread %d] Server closed connection\n", args->thread_id);
+            break;
+        }
+
+        args->bytes_received += received;
+        core_account(received);
+        args->messages_received++;
+        if (flags & LOOP_INSTR) {
+            args->total_latency += recv_ns / 1000.0;
+            lat_hist_add(&args->lat_hist, recv_ns / 1000.0);
+        }
+
+        /* Return credit for consumed bytes */
+        if ((flags & LOOP_CREDIT) && credit_return(sock_fd, ctx->granter, received) < 0) {
+            perror("credit grant failed");
+            break;
+        }
+
+        /* Slow reader: let the server's socket buffer fill up */
+        if (flags & LOOP_SLOW_READER) {
+            usleep(args->read_delay_us);
+        }
+    }
+}
+
+SPECIALIZE_RECV_LOOP(recv_loop);
+
 /*
  * Thread function for client connection
  * Receives data from zero-copy server
  */
 void* client_thread(void *arg) {
     ClientThreadArgs *args = (ClientThreadArgs*)arg;
+
+    /* Pin before connecting, so the whole window runs on the chosen core type */
+    core_pin_self(args->placement);
     size_t msg_size = args->msg_size;
 
-    /* Create socket */
-    int sock_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock_fd < 0) {
-        perror("socket creation failed");
+    /* Set up server address (IPv4 or IPv6, from its form) */
+    struct sockaddr_storage server_addr;
+    socklen_t addr_len = make_sockaddr(args->server_ip, args->server_port, &server_addr);
+    if (addr_len == 0) {
+        fprintf(stderr, "Invalid address '%s'\n", args->server_ip);
         pthread_exit(NULL);
     }
 
-    /* Set up server address */
-    struct sockaddr_in server_addr;
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(args->server_port);
-
-    if (inet_pton(AF_INET, args->server_ip, &server_addr.sin_addr) <= 0) {
-        perror("Invalid address");
-        close(sock_fd);
+    /* Create socket */
+    int sock_fd = socket(server_addr.ss_family, SOCK_STREAM, 0);
+    if (sock_fd < 0) {
+        perror("socket creation failed");
         pthread_exit(NULL);
     }
+    set_socket_priority(sock_fd, args->priority);
 
     /* Connect to server */
-    if (connect(sock_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (connect(sock_fd, (struct sockaddr*)&server_addr, addr_len) < 0) {
         perror("connect failed");
         close(sock_fd);
         pthread_exit(NULL);
@@ -65,15 +131,27 @@ void* client_thread(void *arg) {
 
     printf("[Thread %d] Connected to server %s:%d\n",
            args->thread_id, args->server_ip, args->server_port);
+    qdepth_publish(args, sock_fd);
+
+    /* In credit mode, open the initial window before the server may send */
+    CreditGranter granter;
+    credit_granter_init(&granter, args->credit_window, args->msg_size);
+    if (granter.window && credit_start(sock_fd, granter.window) < 0) {
+        perror("credit grant failed");
+        qdepth_close(args, sock_fd);
+        pthread_exit(NULL);
+    }
 
     /*
      * Allocate page-aligned receive buffer for better performance
      * Page alignment can help with potential future zero-copy receives
+     * (pooled buffers of a page or more are page aligned)
      */
-    char *recv_buffer;
-    if (posix_memalign((void**)&recv_buffer, 4096, msg_size) != 0) {
+    size_t buf_size = msg_size < BUFPOOL_PAGE ? BUFPOOL_PAGE : msg_size;
+    char *recv_buffer = (char*)bufpool_get(buf_size);
+    if (!recv_buffer) {
         perror("Failed to allocate aligned receive buffer");
-        close(sock_fd);
+        qdepth_close(args, sock_fd);
         pthread_exit(NULL);
     }
 
@@ -90,37 +168,48 @@ void* client_thread(void *arg) {
     args->bytes_received = 0;
     args->messages_received = 0;
     args->total_latency = 0;
+    memset(&args->lat_hist, 0, sizeof(args->lat_hist));
+
+    /* Top-down and cache counters cover this thread's receive window */
+    TmaProbe tma;
+    memset(&args->tma, 0, sizeof(args->tma));
+    int counting = args->topdown && tma_start(&tma) == 0;
+    CoreProbe cores;
+    memset(&args->cores, 0, sizeof(args->cores));
+    int core_counting = args->placement && core_probe_start(&cores) == 0;
 
     double start_time = get_time_sec();
     double end_time = start_time + args->duration;
 
     printf("[Thread %d] Starting to receive messages\n", args->thread_id);
 
-    /* Receive messages continuously until duration expires */
-    while (running && get_time_sec() < end_time) {
-        double msg_start = get_time_us();
-
-        ssize_t received = recvmsg(sock_fd, &mh, 0);
-
-        double msg_end = get_time_us();
-
-        if (received < 0) {
-            if (errno == EINTR) continue;
-            perror("recvmsg failed");
-            break;
-        }
-
-        if (received == 0) {
-            printf("[Thread %d] Server closed connection\n", args->thread_id);
-            break;
-        }
-
-        args->bytes_received += received;
-        args->messages_received++;
-        args->total_latency += (msg_end - msg_start);
+    if (args->mux) {
+        /* Multiplexed mode: parse framed chunks from several streams */
+        mux_receive(args, sock_fd, 0, &running, end_time, &granter);
+    } else if (args->stripe) {
+        /* Striped mode: this connection and args->stripe - 1 more carry one stream */
+        stripe_receive(args, sock_fd, 0, &running, end_time);
+    } else {
+        struct RecvCtx ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.fd = sock_fd;
+        ctx.mh = &mh;
+        ctx.msg_size = msg_size;
+        ctx.granter = &granter;
+        ctx.end_time = end_time;
+
+        /* Loop specialised for this connection's options */
+        recv_loop_variants[loop_flags(granter.window != 0, args->instrument,
+                                      args->read_delay_us != 0)](args, &ctx);
     }
 
     args->elapsed_time = get_time_sec() - start_time;
+    if (counting) {
+        tma_stop(&tma, &args->tma);
+    }
+    if (core_counting) {
+        core_probe_stop(&cores, &args->cores);
+    }
 
     /* Calculate thread metrics */
     double throughput = calc_throughput_gbps(args->bytes_received, args->elapsed_time);
@@ -131,18 +220,24 @@ void* client_thread(void *arg) {
            args->thread_id, args->bytes_received, args->messages_received, args->elapsed_time);
     printf("[Thread %d] Throughput: %.4f Gbps, Avg Latency: %.2f µs\n",
            args->thread_id, throughput, avg_latency);
+    if (args->instrument && !args->mux && !args->stripe) {
+        loop_stats_print(args->thread_id, "Recv", &args->loop_stats);
+    }
 
     /* Update global metrics */
     pthread_mutex_lock(&metrics_mutex);
     global_metrics.total_bytes += args->bytes_received;
+    tma_add(&global_tma, &args->tma);
+    core_counts_add(&global_cores, &args->cores);
     global_metrics.total_messages += args->messages_received;
     global_metrics.total_time = args->elapsed_time;
     global_metrics.avg_latency_us += avg_latency;
+    lat_hist_merge(&global_hist, &args->lat_hist);
     pthread_mutex_unlock(&metrics_mutex);
 
     /* Cleanup */
-    free(recv_buffer);
-    close(sock_fd);
+    bufpool_put(recv_buffer, buf_size);
+    qdepth_close(args, sock_fd);
 
     return NULL;
 }
@@ -153,10 +248,21 @@ int main(int argc, char *argv[]) {
     size_t msg_size = DEFAULT_MSG_SIZE;
     int num_threads = DEFAULT_NUM_THREADS;
     int duration = DEFAULT_DURATION;
+    const char *credit_arg = NULL;
+    int mux = 0;
+    int stripe = 0;
+    int priority = -1;
+    unsigned int read_delay_us = 0;
+    int instrument = 1;
+    int topdown = 0;
+    int kstats = 0;
+    int qdepth = 0;
+    const char *placement_spec = NULL;
+    CorePlacement placement;
     int opt;
 
     /* Parse command line arguments */
-    while ((opt = getopt(argc, argv, "i:p:s:t:d:h")) != -1) {
+    while ((opt = getopt(argc, argv, "i:p:s:t:d:c:mP:W:I:U:K:Q:A:G:h")) != -1) {
         switch (opt) {
             case 'i':
                 server_ip = optarg;
@@ -173,6 +279,36 @@ int main(int argc, char *argv[]) {
             case 'd':
                 duration = atoi(optarg);
                 break;
+            case 'c':
+                credit_arg = optarg;
+                break;
+            case 'm':
+                mux = 1;
+                break;
+            case 'G':
+                stripe = atoi(optarg);
+                break;
+            case 'P':
+                priority = atoi(optarg);
+                break;
+            case 'W':
+                read_delay_us = strtoul(optarg, NULL, 10);
+                break;
+            case 'I':
+                instrument = atoi(optarg);
+                break;
+            case 'U':
+                topdown = atoi(optarg);
+                break;
+            case 'K':
+                kstats = atoi(optarg);
+                break;
+            case 'Q':
+                qdepth = atoi(optarg);
+                break;
+            case 'A':
+                placement_spec = optarg;
+                break;
             case 'h':
             default:
                 print_usage(argv[0], 0);
@@ -180,13 +316,51 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    unsigned long credit_window = credit_arg ? parse_credit_window(credit_arg, msg_size) : 0;
+
+    /* Striped: each thread's own connection goes to the first address */
+    char first_ip[INET6_ADDRSTRLEN];
+    const char *stripe_ips = server_ip;
+    if (stripe) {
+        if (stripe < 1 || stripe > STRIPE_MAX_LINKS || mux || credit_window) {
+            fprintf(stderr, "-G takes 1-%d links and cannot be combined with -m or -c\n",
+                    STRIPE_MAX_LINKS);
+            exit(EXIT_FAILURE);
+        }
+        server_ip = stripe_ip(stripe_ips, 0, first_ip, sizeof(first_ip));
+        if (!server_ip) {
+            fprintf(stderr, "Invalid address list '%s'\n", stripe_ips);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     /* Set up signal handler */
     signal(SIGINT, signal_handler);
 
+    if (placement_spec && parse_core_placement(placement_spec, &placement) < 0) {
+        fprintf(stderr, "Invalid placement '%s' (core, atom, any or a CPU list "
+                "of this machine)\n", placement_spec);
+        exit(EXIT_FAILURE);
+    }
+
     printf("=== Zero-Copy Client ===\n");
+    printf("Build variant: %s\n", BUILD_VARIANT);
     printf("Connecting to %s:%d\n", server_ip, server_port);
     printf("Message size: %zu bytes, Threads: %d, Duration: %d seconds\n",
            msg_size, num_threads, duration);
+    if (credit_window) {
+        printf("Credit window: %lu bytes per connection\n", credit_window);
+    }
+    if (placement_spec) {
+        core_placement_print(&placement);
+    }
+    if (mux) {
+        printf("Multiplexed: parsing framed streams (latency = message latency incl. HOL)\n");
+    }
+    if (stripe) {
+        printf("Striped: %d links per thread over %s, reassembled in order\n",
+               stripe, stripe_ips);
+    }
     printf("\n");
 
     /* Allocate thread resources */
@@ -198,6 +372,33 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
+    /* Kernel counters in the client namespace around the threads' windows */
+    KstatSnap kstat_before = {0, NULL}, kstat_after = {0, NULL};
+    if (kstats) kstat_take(&kstat_before);
+
+    /* CPU time of the whole client over the threads' windows */
+    CpuMeter cpu;
+    cpu_start(&cpu);
+
+    /* No socket published until each thread connects */
+    for (int i = 0; i < num_threads; i++) {
+        thread_args[i].sock_fd = -1;
+        pthread_mutex_init(&thread_args[i].sock_lock, NULL);
+    }
+
+    /* Receive queue depth of every connection, sampled from one thread */
+    QdepthSeries *qseries = qdepth ? (QdepthSeries*)calloc(num_threads, sizeof(QdepthSeries)) : NULL;
+    QdepthSampler sampler = { thread_args, qseries, 0, 0 };
+    pthread_t sampler_tid;
+    int sampling = 0;
+    if (qseries) {
+        for (int i = 0; i < num_threads; i++) {
+            qdepth_series_init(&qseries[i]);
+        }
+        sampler.count = num_threads;
+        sampling = pthread_create(&sampler_tid, NULL, qdepth_sampler_thread, &sampler) == 0;
+    }
+
     /* Create client threads */
     for (int i = 0; i < num_threads; i++) {
         thread_args[i].thread_id = i;
@@ -205,6 +406,15 @@ int main(int argc, char *argv[]) {
         thread_args[i].server_port = server_port;
         thread_args[i].msg_size = msg_size;
         thread_args[i].duration = duration;
+        thread_args[i].credit_window = credit_window;
+        thread_args[i].mux = mux;
+        thread_args[i].stripe = stripe;
+        thread_args[i].stripe_ips = stripe_ips;
+        thread_args[i].priority = priority;
+        thread_args[i].read_delay_us = read_delay_us;
+        thread_args[i].instrument = instrument;
+        thread_args[i].topdown = topdown;
+        thread_args[i].placement = placement_spec ? &placement : NULL;
 
         if (pthread_create(&threads[i], NULL, client_thread, &thread_args[i]) != 0) {
             perror("pthread_create failed");
@@ -217,6 +427,12 @@ int main(int argc, char *argv[]) {
     for (int i = 0; i < num_threads; i++) {
         pthread_join(threads[i], NULL);
     }
+    cpu_stop(&cpu);
+    if (kstats) kstat_take(&kstat_after);
+    if (sampling) {
+        sampler.stop = 1;
+        pthread_join(sampler_tid, NULL);
+    }
 
     /* Calculate final metrics */
     global_metrics.throughput_gbps = calc_throughput_gbps(global_metrics.total_bytes,
@@ -230,11 +446,35 @@ int main(int argc, char *argv[]) {
     printf("Average latency: %.2f µs\n", global_metrics.avg_latency_us);
 
     /* Output CSV-friendly line for scripting */
+    if (mux) {
+        mux_report("zero_copy", global_metrics.total_time);
+    }
+    if (stripe) {
+        stripe_report("zero_copy");
+    }
+
     printf("\nCSV: zero_copy,%zu,%d,%.4f,%.2f,%lu\n",
            msg_size, num_threads, global_metrics.throughput_gbps,
            global_metrics.avg_latency_us, global_metrics.total_bytes);
+    lat_hist_report("zero_copy", &global_hist);
+    cpu_report("client", &cpu);
+    bufpool_report("client");
+    if (topdown) {
+        tma_report("client", &global_tma, global_metrics.total_bytes);
+    }
+    if (placement_spec) {
+        core_report("client", &placement, &global_cores);
+    }
+    kstat_report("client", &kstat_before, &kstat_after);
+    for (int i = 0; qseries && i < sampler.count; i++) {
+        qdepth_print("client", i, &qseries[i]);
+        qdepth_series_free(&qseries[i]);
+    }
+    free(qseries);
 
     /* Cleanup */
+    kstat_free(&kstat_before);
+    kstat_free(&kstat_after);
     free(threads);
     free(thread_args);
 
@@ -0,0 +1,254 @@
+/*
+ * MT25033_Part_A5_Client.c
+ * Latency RPC Client Implementation (request/response ping-pong)
+ * Roll Number: MT25033
+ *
+ * Each thread keeps exactly one request outstanding: it sends a request,
+ * waits for the full response and records the round-trip time in a
+ * histogram. The client reports tail percentiles (p50/p99/p99.9/max), which
+ * is what matters for small RPCs sharing a link with bulk zero-copy streams.
+ */
+
+#include "MT25033_Part_A_Common.h"
+#include <signal.h>
+#include <getopt.h>
+
+/* Global flag for graceful shutdown */
+static volatile int running = 1;
+
+/* Global metrics protected by mutex */
+static pthread_mutex_t metrics_mutex = PTHREAD_MUTEX_INITIALIZER;
+static Metrics global_metrics = {0};
+static LatencyHistogram global_hist;
+
+/* Signal handler for graceful termination */
+void signal_handler(int signum) {
+    (void)signum;
+    running = 0;
+}
+
+/*
+ * Thread function for client connection
+ * Sends requests back to back and times each round trip
+ */
+void* client_thread(void *arg) {
+    ClientThreadArgs *args = (ClientThreadArgs*)arg;
+    size_t msg_size = args->msg_size;
+
+    /* Set up server address (IPv4 or IPv6, from its form) */
+    struct sockaddr_storage server_addr;
+    socklen_t addr_len = make_sockaddr(args->server_ip, args->server_port, &server_addr);
+    if (addr_len == 0) {
+        fprintf(stderr, "Invalid address '%s'\n", args->server_ip);
+        pthread_exit(NULL);
+    }
+
+    /* Create socket */
+    int sock_fd = socket(server_addr.ss_family, SOCK_STREAM, 0);
+    if (sock_fd < 0) {
+        perror("socket creation failed");
+        pthread_exit(NULL);
+    }
+    set_socket_priority(sock_fd, args->priority);
+
+    int one = 1;
+    setsockopt(sock_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    /* Connect to server */
+    if (connect(sock_fd, (struct sockaddr*)&server_addr, addr_len) < 0) {
+        perror("connect failed");
+        close(sock_fd);
+        pthread_exit(NULL);
+    }
+
+    printf("[Thread %d] Connected to server %s:%d\n",
+           args->thread_id, args->server_ip, args->server_port);
+
+    char *buffer = (char*)bufpool_get(msg_size);
+    LatencyHistogram *hist = (LatencyHistogram*)calloc(1, sizeof(LatencyHistogram));
+    if (!buffer || !hist) {
+        perror("Failed to allocate RPC buffers");
+        bufpool_put(buffer, msg_size);
+        free(hist);
+        close(sock_fd);
+        pthread_exit(NULL);
+    }
+    memset(buffer, 'Q', msg_size);
+
+    args->bytes_received = 0;
+    args->messages_received = 0;
+    args->total_latency = 0;
+
+    double start_time = get_time_sec();
+    double end_time = start_time + args->duration;
+
+    while (running && get_time_sec() < end_time) {
+        double rpc_start = get_time_us();
+
+        if (send(sock_fd, buffer, msg_size, 0) < 0) {
+            if (errno == EINTR) continue;
+            perror("send failed");
+            break;
+        }
+
+        /* Wait for the complete response */
+        size_t got = 0;
+        while (got < msg_size) {
+            ssize_t n = recv(sock_fd, buffer + got, msg_size - got, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            got += n;
+        }
+        if (got < msg_size) {
+            printf("[Thread %d] Server closed connection\n", args->thread_id);
+            break;
+        }
+
+        double rtt = get_time_us() - rpc_start;
+        lat_hist_add(hist, rtt);
+        args->bytes_received += got;
+        args->messages_received++;
+        args->total_latency += rtt;
+    }
+
+    args->elapsed_time = get_time_sec() - start_time;
+
+    double avg_latency = args->messages_received > 0 ?
+                         args->total_latency / args->messages_received : 0;
+
+    printf("[Thread %d] Finished: %lu RPCs in %.2f seconds, avg %.2f µs, p99 %.2f µs\n",
+           args->thread_id, args->messages_received, args->elapsed_time,
+           avg_latency, lat_hist_percentile(hist, 0.99));
+
+    /* Update global metrics */
+    pthread_mutex_lock(&metrics_mutex);
+    global_metrics.total_bytes += args->bytes_received;
+    global_metrics.total_messages += args->messages_received;
+    global_metrics.total_time = args->elapsed_time;
+    lat_hist_merge(&global_hist, hist);
+    pthread_mutex_unlock(&metrics_mutex);
+
+    /* Cleanup */
+    free(hist);
+    bufpool_put(buffer, msg_size);
+    close(sock_fd);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    const char *server_ip = "127.0.0.1";
+    int server_port = DEFAULT_PORT;
+    size_t msg_size = 64;
+    int num_threads = 1;
+    int duration = DEFAULT_DURATION;
+    int priority = -1;
+    int opt;
+
+    /* Parse command line arguments */
+    while ((opt = getopt(argc, argv, "i:p:s:t:d:P:h")) != -1) {
+        switch (opt) {
+            case 'i':
+                server_ip = optarg;
+                break;
+            case 'p':
+                server_port = atoi(optarg);
+                break;
+            case 's':
+                msg_size = atoi(optarg);
+                break;
+            case 't':
+                num_threads = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'P':
+                priority = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                printf("Usage: %s [options]\n", argv[0]);
+                printf("Options:\n");
+                printf("  -i <ip>        Server IPv4 or IPv6 address (default: 127.0.0.1)\n");
+                printf("  -p <port>      Server port (default: %d)\n", DEFAULT_PORT);
+                printf("  -s <size>      Request/response size in bytes (default: 64)\n");
+                printf("  -t <threads>   Concurrent RPC connections (default: 1)\n");
+                printf("  -d <duration>  Test duration in seconds (default: %d)\n", DEFAULT_DURATION);
+                printf("  -P <prio>      SO_PRIORITY for client sockets (0-6)\n");
+                printf("  -h             Show this help\n");
+                exit(EXIT_SUCCESS);
+        }
+    }
+
+    if (msg_size == 0) msg_size = 1;
+
+    /* Set up signal handler */
+    signal(SIGINT, signal_handler);
+
+    printf("=== Latency RPC Client (request/response) ===\n");
+    printf("Build variant: %s\n", BUILD_VARIANT);
+    printf("Connecting to %s:%d\n", server_ip, server_port);
+    printf("Request/response size: %zu bytes, Threads: %d, Duration: %d seconds\n",
+           msg_size, num_threads, duration);
+    if (priority >= 0) {
+        printf("Socket priority: %d\n", priority);
+    }
+    printf("\n");
+
+    /* Allocate thread resources */
+    pthread_t *threads = (pthread_t*)malloc(num_threads * sizeof(pthread_t));
+    ClientThreadArgs *thread_args = (ClientThreadArgs*)calloc(num_threads, sizeof(ClientThreadArgs));
+
+    if (!threads || !thread_args) {
+        perror("Failed to allocate thread resources");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Create client threads */
+    for (int i = 0; i < num_threads; i++) {
+        thread_args[i].thread_id = i;
+        thread_args[i].server_ip = server_ip;
+        thread_args[i].server_port = server_port;
+        thread_args[i].msg_size = msg_size;
+        thread_args[i].duration = duration;
+        thread_args[i].priority = priority;
+
+        if (pthread_create(&threads[i], NULL, client_thread, &thread_args[i]) != 0) {
+            perror("pthread_create failed");
+            num_threads = i;
+            break;
+        }
+    }
+
+    /* Wait for all threads to complete */
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double rate = global_metrics.total_time > 0 ?
+                  global_metrics.total_messages / global_metrics.total_time : 0;
+    double avg = global_hist.total > 0 ? global_hist.sum_us / global_hist.total : 0;
+
+    printf("\n=== Final Statistics ===\n");
+    printf("Total RPCs: %lu\n", global_metrics.total_messages);
+    printf("RPC rate: %.0f req/s\n", rate);
+    printf("Average latency: %.2f µs\n", avg);
+    printf("Latency p50: %.2f µs, p99: %.2f µs, p99.9: %.2f µs, max: %.2f µs\n",
+           lat_hist_percentile(&global_hist, 0.50), lat_hist_percentile(&global_hist, 0.99),
+           lat_hist_percentile(&global_hist, 0.999), global_hist.max_us);
+
+    /* Output CSV-friendly lines for scripting */
+    printf("\nCSV: rpc,%zu,%d,%.0f,%.2f,%lu\n",
+           msg_size, num_threads, rate, avg, global_metrics.total_bytes);
+    printf("LATCSV: rpc,%.2f,%.2f,%.2f,%.2f\n",
+           lat_hist_percentile(&global_hist, 0.50), lat_hist_percentile(&global_hist, 0.99),
+           lat_hist_percentile(&global_hist, 0.999), global_hist.max_us);
+    bufpool_report("client");
+
+    /* Cleanup */
+    free(threads);
+    free(thread_args);
+
+    return 0;
+}
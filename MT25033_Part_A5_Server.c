@@ -0,0 +1,267 @@
+/*
+ * MT25033_Part_A5_Server.c
+ * Latency RPC Server Implementation (request/response ping-pong)
+ * Roll Number: MT25033
+ *
+ * This is the latency-sensitive traffic class for mixed workloads. Unlike
+ * the A1-A3 servers, which stream bulk data as fast as possible, this
+ * server answers small fixed-size requests one at a time.
+ *
+ * The server:
+ * - Accepts multiple concurrent clients, one thread per client
+ * - Reads a request of msg_size bytes and sends a response of msg_size bytes
+ * - Disables Nagle so responses leave immediately
+ * - Optionally sets SO_PRIORITY so a prio qdisc can keep the RPCs ahead
+ *   of bulk A1-A3 streams on the same link
+ */
+
+#include "MT25033_Part_A_Common.h"
+#include <signal.h>
+#include <getopt.h>
+
+/* Signal handler for graceful termination: wakes every thread through the run eventfd */
+void signal_handler(int signum) {
+    (void)signum;
+    run_stop();
+}
+
+/*
+ * Thread function to handle a single client connection
+ * Answers requests until the client disconnects or the duration expires
+ */
+void* handle_client(void *arg) {
+    ServerThreadArgs *args = (ServerThreadArgs*)arg;
+    int client_fd = args->client_fd;
+    size_t msg_size = args->msg_size;
+
+    int one = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    char *buffer = (char*)bufpool_get(msg_size);
+    if (!buffer) {
+        perror("Failed to allocate RPC buffer");
+        close(client_fd);
+        pthread_exit(NULL);
+    }
+    memset(buffer, 'R', msg_size);
+
+    args->bytes_sent = 0;
+    args->messages_sent = 0;
+
+    RunWindow win;
+    window_open(&win, args->window_end);
+
+    printf("[Thread %d] Serving RPCs (request/response size=%zu bytes)\n",
+           args->thread_id, msg_size);
+
+    while (window_live(&win)) {
+        /* Read one complete request, waiting in run_wait() between segments */
+        size_t got = 0;
+        while (got < msg_size) {
+            ssize_t n = recv(client_fd, buffer + got, msg_size - got, MSG_DONTWAIT);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                if (run_wait(client_fd, POLLIN, &win, -1) < 0) break;
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                got = 0;
+                break;
+            }
+            got += n;
+        }
+        if (!window_live(&win)) {
+            break;
+        }
+        if (got < msg_size) {
+            printf("[Thread %d] Client disconnected\n", args->thread_id);
+            break;
+        }
+
+        /* Send the response (small enough to fit the socket buffer) */
+        ssize_t sent = send(client_fd, buffer, msg_size, 0);
+        if (sent < 0) {
+            if (errno == EPIPE || errno == ECONNRESET) {
+                printf("[Thread %d] Client disconnected\n", args->thread_id);
+                break;
+            }
+            perror("send failed");
+            break;
+        }
+
+        args->bytes_sent += sent;
+        args->messages_sent++;
+    }
+
+    args->elapsed_time = window_elapsed(&win);
+
+    printf("[Thread %d] Finished: answered %lu requests in %.2f seconds\n",
+           args->thread_id, args->messages_sent, args->elapsed_time);
+
+    /* Cleanup */
+    bufpool_put(buffer, msg_size);
+    close(client_fd);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    int port = DEFAULT_PORT;
+    size_t msg_size = 64;
+    int duration = DEFAULT_DURATION;
+    int priority = -1;
+    int family = FAMILY_INET;
+    int snapshot_interval = 0;
+    int opt;
+
+    /* Parse command line arguments */
+    while ((opt = getopt(argc, argv, "p:s:d:P:S:F:h")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 's':
+                msg_size = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            case 'F':
+                family = parse_family(optarg);
+                if (family < 0) {
+                    fprintf(stderr, "Invalid family '%s' (4, 6 or 46)\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'P':
+                priority = atoi(optarg);
+                break;
+            case 'S':
+                snapshot_interval = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                printf("Usage: %s [options]\n", argv[0]);
+                printf("Options:\n");
+                printf("  -p <port>      Port number (default: %d)\n", DEFAULT_PORT);
+                printf("  -s <size>      Request/response size in bytes (default: 64)\n");
+                printf("  -d <duration>  Test duration in seconds (default: %d)\n", DEFAULT_DURATION);
+                printf("  -F <family>    Listen on IPv4 (4), IPv6 only (6) or dual-stack (46) (default: 4)\n");
+                printf("  -P <prio>      SO_PRIORITY for accepted connections (0-6)\n");
+                printf("  -S <seconds>   Print resource snapshots (SNAP:) every interval\n");
+                printf("  -h             Show this help\n");
+                exit(EXIT_SUCCESS);
+        }
+    }
+
+    if (msg_size == 0) msg_size = 1;
+
+    /* Set up signal handler for graceful shutdown */
+    signal(SIGINT, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Shutdown eventfd and run timer */
+    run_init();
+    int run_timer = run_timer_create();
+    RunWindow run_window;
+    run_timer_arm(run_timer, &run_window, duration + RUN_CONNECT_GRACE);
+
+    /* Create server socket */
+    int server_fd = create_listen_socket(port, 0, family);
+
+    printf("=== Latency RPC Server (request/response) ===\n");
+    printf("Build variant: %s\n", BUILD_VARIANT);
+    printf("Listening on port %d\n", port);
+    if (family != FAMILY_INET) {
+        printf("Address family: %s\n", family_name(family));
+    }
+    printf("Request/response size: %zu bytes, Duration: %d seconds\n", msg_size, duration);
+    if (priority >= 0) {
+        printf("Socket priority: %d\n", priority);
+    }
+    printf("Waiting for clients...\n\n");
+
+    int thread_id = 0;
+    int max_threads = 100;
+    ConnTable conns;
+
+    if (conn_table_init(&conns, max_threads) < 0) {
+        perror("Failed to allocate thread resources");
+        close(server_fd);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Optional resource snapshots for soak runs */
+    pthread_t snap_tid;
+    SnapshotArgs snap_args = { &conns, snapshot_interval };
+    int snap_started = snapshot_interval > 0 &&
+                       pthread_create(&snap_tid, NULL, snapshot_thread, &snap_args) == 0;
+
+    /* Accept clients and spawn threads */
+    int measuring = 0;
+    while (run_active()) {
+        /* Join finished connections so their slots can be reused */
+        conn_table_reap(&conns, 0);
+
+        int ready = run_accept_wait(server_fd, run_timer);
+        if (ready < 0) break;
+        if (ready == 0) continue;
+
+        struct sockaddr_storage client_addr;
+        socklen_t client_len = sizeof(client_addr);
+
+        int client_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
+        if (client_fd < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+            perror("accept failed");
+            continue;
+        }
+
+        char peer[PEER_STRLEN];
+        printf("Client connected from %s\n",
+               format_peer(&client_addr, peer, sizeof(peer)));
+
+        /* The measurement window opens with the first client */
+        if (!measuring) {
+            run_timer_arm(run_timer, &run_window, duration);
+            measuring = 1;
+        }
+
+        set_socket_priority(client_fd, priority);
+
+        /* Set up thread arguments */
+        ServerThreadArgs targs;
+        memset(&targs, 0, sizeof(targs));
+        targs.client_fd = client_fd;
+        targs.thread_id = thread_id++;
+        targs.msg_size = msg_size;
+        targs.duration = duration;
+        targs.window_end = run_window.end;
+
+        /* Create thread to handle client (slot is freed again on failure) */
+        if (conn_table_start(&conns, &targs, handle_client, NULL) < 0) {
+            close(client_fd);
+            continue;
+        }
+    }
+
+    /* Wait for all threads to complete */
+    printf("\nShutting down, waiting for threads...\n");
+    conn_table_reap(&conns, 1);
+    if (snap_started) {
+        pthread_join(snap_tid, NULL);
+    }
+
+    unsigned long total_messages = conns.total_messages;
+
+    printf("\n=== Final Statistics ===\n");
+    printf("Total requests answered: %lu\n", total_messages);
+    bufpool_report("server");
+
+    /* Cleanup */
+    conn_table_free(&conns);
+    close(server_fd);
+    close(run_timer);
+
+    return 0;
+}
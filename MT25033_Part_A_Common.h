@@ -10,6 +10,10 @@
 #ifndef MT25033_PART_A_COMMON_H
 #define MT25033_PART_A_COMMON_H
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE                /* ppoll() */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,10 +22,46 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <time.h>
 #include <sys/time.h>
+#include <stdint.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/resource.h>
+#include <linux/errqueue.h>
+#include "MT25033_Part_A_Tma.h"
+#include "MT25033_Part_A_Hybrid.h"
+#include "MT25033_Part_A_Bufpool.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
 
 /* Default configuration values */
 #define DEFAULT_PORT 8080
@@ -30,12 +70,18 @@
 #define DEFAULT_NUM_THREADS 4
 #define NUM_FIELDS 8               /* Number of string fields in Message */
 
+/* Build variant (o2, o3, lto, pgo), set by the Makefile's BUILD option */
+#ifndef BUILD_VARIANT
+#define BUILD_VARIANT "custom"
+#endif
+
 /*
  * Message structure with 8 dynamically allocated string fields
- * Each field is heap-allocated using malloc()
+ * Each field is heap-allocated from the size-classed buffer pool
  * This structure is used to demonstrate data copy overhead
  */
 typedef struct {
+    size_t field_size;             /* Bytes per field (returned to the pool with it) */
     char *field1;
     char *field2;
     char *field3;
@@ -56,16 +102,67 @@ typedef struct {
     char data[];                   /* Flexible array member for data */
 } SerializedMessage;
 
-/* Thread argument structure for server threads */
+/* Multiplexed stream layout, defined in MT25033_Part_A_Mux.h */
+struct MuxConfig;
+
+/* Shared pool of message buffers for lazy mode, defined below */
+struct MessagePool;
+
+/* Counters kept by instrumented send/recv loops (-I 1) */
+typedef struct {
+    unsigned long calls;           /* send/recv syscalls made */
+    unsigned long partial;         /* Calls that moved less than asked */
+    unsigned long waits;           /* Times the loop waited for the socket */
+    unsigned long syscall_ns;      /* Time spent inside the syscalls */
+} LoopStats;
+
+/*
+ * Latency histogram with log-linear buckets (16 per power of two),
+ * good to about 6% from 1 ns to several minutes. Used where averages hide
+ * the tail, e.g. p99 of small RPCs running next to bulk transfers.
+ */
+#define LAT_SUB_BITS 4
+#define LAT_BUCKETS ((64 - LAT_SUB_BITS + 1) << LAT_SUB_BITS)
+
 typedef struct {
+    unsigned long counts[LAT_BUCKETS];
+    unsigned long total;
+    double sum_us;
+    double max_us;
+} LatencyHistogram;
+
+/* Thread argument structure for server threads */
+typedef struct ServerThreadArgs {
+    void *(*handler)(void *);      /* Connection handler run by the slot */
+    volatile int done;             /* Set when the handler has returned */
     int client_fd;
     int thread_id;
     size_t msg_size;
     int duration;
+    double window_end;             /* End of the measurement window (get_time_sec) */
+    int use_credit;                /* Send only within client-granted credit */
+    int instrument;                /* Use the instrumented send loop */
+    int topdown;                   /* Count top-down/cache events (-U 1) */
+    const struct MuxConfig *mux;   /* Multiplexed streams (NULL = off) */
+    size_t stripe_chunk;           /* Striped connections: chunk bytes (0 = off) */
+    struct MessagePool *pool;      /* Lazy buffers (NULL = one Message per thread) */
+    size_t qdepth;                 /* Target not-sent bytes for batching (0 = off) */
+    const CorePlacement *placement;  /* Core-type pinning and counters (-A, NULL = off) */
+    int steer;                     /* CPU steering mode (-C, 0 = off) */
+    int steer_cpu;                 /* Pin the connection thread here (-1 = no) */
+    int incoming_cpu;              /* SO_INCOMING_CPU after accept, then at the end (-1 = unknown) */
+    int steer_fd;                  /* Duplicate of client_fd to read it at the end (-1 = none) */
     /* Metrics */
     unsigned long bytes_sent;
     unsigned long messages_sent;
+    unsigned long credit_stalls;   /* Times the sender ran out of credit */
     double elapsed_time;
+    LoopStats loop_stats;
+    TmaProbe tma_probe;            /* Counters open while the handler runs */
+    TmaCounts tma;
+    CoreProbe core_probe;
+    CoreCounts cores;
+    int on_incoming;               /* Ran on the connection's final incoming CPU */
 } ServerThreadArgs;
 
 /* Thread argument structure for client threads */
@@ -75,11 +172,26 @@ typedef struct {
     int server_port;
     size_t msg_size;
     int duration;
+    unsigned long credit_window;   /* Bytes of credit to grant (0 = off) */
+    int mux;                       /* Parse multiplexed frames */
+    int stripe;                    /* Connections per striped stream (0 = off) */
+    const char *stripe_ips;        /* Addresses the stripe's links use in turn */
+    int priority;                  /* SO_PRIORITY (-1 = default) */
+    unsigned int read_delay_us;    /* Pause after every receive (slow reader) */
+    int instrument;                /* Time every receive (per-message latency) */
+    int topdown;                   /* Count top-down/cache events (-U 1) */
+    int sock_fd;                   /* Connected socket for SIOCINQ sampling (-1 = none) */
+    pthread_mutex_t sock_lock;     /* Held by the sampler across its ioctl and by close */
+    const CorePlacement *placement;  /* Core-type pinning and counters (-A, NULL = off) */
     /* Metrics */
     unsigned long bytes_received;
     unsigned long messages_received;
     double total_latency;
+    LatencyHistogram lat_hist;     /* Per-message latency (instrumented loop / mux) */
     double elapsed_time;
+    LoopStats loop_stats;
+    TmaCounts tma;
+    CoreCounts cores;
 } ClientThreadArgs;
 
 /* Global metrics structure */
@@ -91,34 +203,51 @@ typedef struct {
     double avg_latency_us;
 } Metrics;
 
+/*
+ * Free all memory associated with a Message
+ * The fields go back to the buffer pool
+ */
+static inline void free_message(Message *msg) {
+    if (msg) {
+        bufpool_put(msg->field1, msg->field_size);
+        bufpool_put(msg->field2, msg->field_size);
+        bufpool_put(msg->field3, msg->field_size);
+        bufpool_put(msg->field4, msg->field_size);
+        bufpool_put(msg->field5, msg->field_size);
+        bufpool_put(msg->field6, msg->field_size);
+        bufpool_put(msg->field7, msg->field_size);
+        bufpool_put(msg->field8, msg->field_size);
+        free(msg);
+    }
+}
+
 /*
  * Allocate and initialize a Message structure
  * Each field is allocated with the specified size and filled with data
  */
 static inline Message* create_message(size_t field_size) {
-    Message *msg = (Message*)malloc(sizeof(Message));
+    Message *msg = (Message*)calloc(1, sizeof(Message));
     if (!msg) {
         perror("Failed to allocate Message");
         return NULL;
     }
 
-    /* Allocate each field on the heap */
-    msg->field1 = (char*)malloc(field_size);
-    msg->field2 = (char*)malloc(field_size);
-    msg->field3 = (char*)malloc(field_size);
-    msg->field4 = (char*)malloc(field_size);
-    msg->field5 = (char*)malloc(field_size);
-    msg->field6 = (char*)malloc(field_size);
-    msg->field7 = (char*)malloc(field_size);
-    msg->field8 = (char*)malloc(field_size);
+    /* Allocate each field on the heap (pooled by size class) */
+    msg->field_size = field_size;
+    msg->field1 = (char*)bufpool_get(field_size);
+    msg->field2 = (char*)bufpool_get(field_size);
+    msg->field3 = (char*)bufpool_get(field_size);
+    msg->field4 = (char*)bufpool_get(field_size);
+    msg->field5 = (char*)bufpool_get(field_size);
+    msg->field6 = (char*)bufpool_get(field_size);
+    msg->field7 = (char*)bufpool_get(field_size);
+    msg->field8 = (char*)bufpool_get(field_size);
 
     /* Check allocations */
     if (!msg->field1 || !msg->field2 || !msg->field3 || !msg->field4 ||
         !msg->field5 || !msg->field6 || !msg->field7 || !msg->field8) {
         perror("Failed to allocate message fields");
-        free(msg->field1); free(msg->field2); free(msg->field3); free(msg->field4);
-        free(msg->field5); free(msg->field6); free(msg->field7); free(msg->field8);
-        free(msg);
+        free_message(msg);
         return NULL;
     }
 
@@ -135,23 +264,6 @@ static inline Message* create_message(size_t field_size) {
     return msg;
 }
 
-/*
- * Free all memory associated with a Message
- */
-static inline void free_message(Message *msg) {
-    if (msg) {
-        free(msg->field1);
-        free(msg->field2);
-        free(msg->field3);
-        free(msg->field4);
-        free(msg->field5);
-        free(msg->field6);
-        free(msg->field7);
-        free(msg->field8);
-        free(msg);
-    }
-}
-
 /*
  * Serialize a Message into a contiguous buffer for sending
  * Returns a newly allocated SerializedMessage
@@ -160,7 +272,7 @@ static inline SerializedMessage* serialize_message(Message *msg, size_t field_si
     size_t total_data_size = NUM_FIELDS * field_size;
     size_t total_size = sizeof(SerializedMessage) + total_data_size;
 
-    SerializedMessage *smsg = (SerializedMessage*)malloc(total_size);
+    SerializedMessage *smsg = (SerializedMessage*)bufpool_get(total_size);
     if (!smsg) {
         perror("Failed to allocate SerializedMessage");
         return NULL;
@@ -183,6 +295,12 @@ static inline SerializedMessage* serialize_message(Message *msg, size_t field_si
     return smsg;
 }
 
+static inline void free_serialized_message(SerializedMessage *smsg) {
+    if (smsg) {
+        bufpool_put(smsg, sizeof(SerializedMessage) + smsg->total_size);
+    }
+}
+
 /*
  * Get current time in microseconds
  */
@@ -201,6 +319,239 @@ static inline double get_time_sec(void) {
     return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
+/*
+ * Get current time in nanoseconds (monotonic)
+ */
+static inline uint64_t get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Run control for the servers
+ *
+ * Shutdown is an eventfd: run_stop() sets the stop flag and makes
+ * run_stop_fd readable, so every thread sleeping in run_wait() wakes at
+ * once. It only does an atomic store and a write(), so the SIGINT handler
+ * calls it directly. Threads that never block check run_active() between
+ * sends.
+ *
+ * A connection is measured over a RunWindow that ends when the server's
+ * measurement window does. Waits for socket space or credit sleep in
+ * ppoll() with the time left in the window, so a blocked thread wakes at
+ * the window end instead of after its send completes, and window_elapsed()
+ * stops at the end, so throughput is divided by exactly the measured time.
+ */
+#define RUN_CONNECT_GRACE 5        /* Seconds past the duration to wait for a first client */
+
+static int run_stop_fd = -1;
+static int run_stopping = 0;
+
+/* Create the shutdown eventfd (after fork, so each worker has its own) */
+static inline void run_init(void) {
+    run_stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (run_stop_fd < 0) {
+        perror("eventfd failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Async-signal-safe */
+static inline void run_stop(void) {
+    uint64_t one = 1;
+    __atomic_store_n(&run_stopping, 1, __ATOMIC_RELAXED);
+    if (run_stop_fd >= 0) {
+        ssize_t r = write(run_stop_fd, &one, sizeof(one));
+        (void)r;
+    }
+}
+
+static inline int run_active(void) {
+    return !__atomic_load_n(&run_stopping, __ATOMIC_RELAXED);
+}
+
+typedef struct {
+    double start;                  /* get_time_sec() when measuring began */
+    double end;                    /* Measuring stops here */
+} RunWindow;
+
+static inline void window_open(RunWindow *w, double end) {
+    w->start = get_time_sec();
+    w->end = end;
+}
+
+static inline int window_live(const RunWindow *w) {
+    return run_active() && get_time_sec() < w->end;
+}
+
+/* Time measured so far, never past the window end */
+static inline double window_elapsed(const RunWindow *w) {
+    double now = get_time_sec();
+    return (now < w->end ? now : w->end) - w->start;
+}
+
+/*
+ * Wait for events on fd (fd < 0: only wait) for at most timeout_ms
+ * (-1 = no limit) and never past the window end (w may be NULL).
+ * Returns fd's revents (> 0), 0 on timeout or EINTR, or -1 once the run
+ * is stopping or the window has closed.
+ */
+static inline int run_wait(int fd, short events, const RunWindow *w, int timeout_ms) {
+    struct pollfd pfd[2] = {
+        { .fd = fd, .events = events },
+        { .fd = run_stop_fd, .events = POLLIN },
+    };
+    double left = timeout_ms < 0 ? -1 : timeout_ms / 1000.0;
+    int window_limited = 0;
+
+    if (w) {
+        double window_left = w->end - get_time_sec();
+        if (window_left <= 0) return -1;
+        if (left < 0 || window_left < left) {
+            left = window_left;
+            window_limited = 1;
+        }
+    }
+
+    struct timespec ts, *tsp = NULL;
+    if (left >= 0) {
+        ts.tv_sec = (time_t)left;
+        ts.tv_nsec = (long)((left - ts.tv_sec) * 1000000000.0);
+        tsp = &ts;
+    }
+
+    int n = ppoll(pfd, 2, tsp, NULL);
+    if (!run_active() || pfd[1].revents) return -1;
+    if (n < 0) return errno == EINTR ? 0 : -1;
+    if (n == 0) return window_limited ? -1 : 0;
+    return pfd[0].revents;
+}
+
+/*
+ * Server run timer (timerfd on CLOCK_MONOTONIC, absolute expiry). It is
+ * first armed for the duration plus RUN_CONNECT_GRACE, then re-armed at the
+ * first accepted connection so the measurement window ends exactly
+ * duration seconds later; the accept loop polls it next to the listener.
+ */
+static inline int run_timer_create(void) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (tfd < 0) {
+        perror("timerfd_create failed");
+        exit(EXIT_FAILURE);
+    }
+    return tfd;
+}
+
+/* Open w for `seconds` from now and set the timer to fire at its end */
+static inline void run_timer_arm(int tfd, RunWindow *w, double seconds) {
+    window_open(w, get_time_sec() + seconds);
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = (time_t)w->end;
+    its.it_value.tv_nsec = (long)((w->end - its.it_value.tv_sec) * 1000000000.0);
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/*
+ * Wait until a connection is pending on the (non-blocking) listener.
+ * Wakes every second anyway so finished connections are reaped. Returns
+ * 1 when accept() may be called, 0 to just loop, -1 when the run is over
+ * (the timer fired or run_stop() was called).
+ */
+static inline int run_accept_wait(int server_fd, int tfd) {
+    struct pollfd pfd[3] = {
+        { .fd = server_fd, .events = POLLIN },
+        { .fd = run_stop_fd, .events = POLLIN },
+        { .fd = tfd, .events = POLLIN },
+    };
+    int n = poll(pfd, 3, 1000);
+    if (!run_active() || pfd[1].revents) return -1;
+    if (pfd[2].revents) {
+        run_stop();
+        return -1;
+    }
+    return (n > 0 && pfd[0].revents) ? 1 : 0;
+}
+
+/*
+ * Compile-time specialised send/recv loops
+ *
+ * Each engine writes its plain send (server) or receive (client) loop once,
+ * as a LOOP_INLINE function taking a constant flags mask. The SPECIALIZE_*
+ * macros stamp out one ordinary function per mask; in each copy the
+ * compiler folds the flags and drops the dead branches, so a run without
+ * credit or instrumentation pays nothing for them. The copy is picked from
+ * the variants table once, when the connection starts.
+ *
+ * Instrumentation (-I 1) times every syscall and counts partial transfers
+ * and waits; on the clients it is also the per-message latency, so they
+ * default to it. Compiled out, the loop makes no clock reads beyond the
+ * window check.
+ */
+#define LOOP_CREDIT       1U       /* Credit-based flow control */
+#define LOOP_INSTR        2U       /* Instrumented */
+#define LOOP_ZEROCOPY     4U       /* A3 server: MSG_ZEROCOPY */
+#define LOOP_SLOW_READER  4U       /* Clients: pause after every receive */
+#define LOOP_VARIANTS     8
+
+#define LOOP_INLINE static inline __attribute__((always_inline))
+
+/* engine_flag sets the engine's own bit (LOOP_ZEROCOPY / LOOP_SLOW_READER) */
+static inline unsigned loop_flags(int credit, int instr, int engine_flag) {
+    return (credit ? LOOP_CREDIT : 0) | (instr ? LOOP_INSTR : 0) |
+           (engine_flag ? LOOP_ZEROCOPY : 0);
+}
+
+struct SendCtx;
+struct RecvCtx;
+typedef void (*send_loop_fn)(ServerThreadArgs *args, struct SendCtx *ctx);
+typedef void (*recv_loop_fn)(ClientThreadArgs *args, struct RecvCtx *ctx);
+
+#define LOOP_VARIANT_(loop, args_t, ctx_t, f) \
+    static void loop##_##f(args_t *args, ctx_t *ctx) { loop(args, ctx, f); }
+
+#define LOOP_VARIANTS_(loop, args_t, ctx_t, fn_t) \
+    LOOP_VARIANT_(loop, args_t, ctx_t, 0) LOOP_VARIANT_(loop, args_t, ctx_t, 1) \
+    LOOP_VARIANT_(loop, args_t, ctx_t, 2) LOOP_VARIANT_(loop, args_t, ctx_t, 3) \
+    LOOP_VARIANT_(loop, args_t, ctx_t, 4) LOOP_VARIANT_(loop, args_t, ctx_t, 5) \
+    LOOP_VARIANT_(loop, args_t, ctx_t, 6) LOOP_VARIANT_(loop, args_t, ctx_t, 7) \
+    static const fn_t loop##_variants[LOOP_VARIANTS] = { \
+        loop##_0, loop##_1, loop##_2, loop##_3, loop##_4, loop##_5, loop##_6, loop##_7 \
+    }
+
+#define SPECIALIZE_SEND_LOOP(loop) \
+    LOOP_VARIANTS_(loop, ServerThreadArgs, struct SendCtx, send_loop_fn)
+#define SPECIALIZE_RECV_LOOP(loop) \
+    LOOP_VARIANTS_(loop, ClientThreadArgs, struct RecvCtx, recv_loop_fn)
+
+/* Account one syscall started at t0 that asked for `asked` bytes; returns its ns */
+static inline uint64_t loop_stats_call(LoopStats *ls, uint64_t t0, ssize_t ret, size_t asked) {
+    uint64_t ns = get_time_ns() - t0;
+    ls->calls++;
+    ls->syscall_ns += ns;
+    if (ret >= 0 && (size_t)ret < asked) ls->partial++;
+    return ns;
+}
+
+static inline void loop_stats_add(LoopStats *dst, const LoopStats *src) {
+    dst->calls += src->calls;
+    dst->partial += src->partial;
+    dst->waits += src->waits;
+    dst->syscall_ns += src->syscall_ns;
+}
+
+/* One line per thread (thread_id >= 0) or for the totals (-1) */
+static inline void loop_stats_print(int thread_id, const char *what, const LoopStats *ls) {
+    char prefix[32] = "";
+    if (thread_id >= 0) {
+        snprintf(prefix, sizeof(prefix), "[Thread %d] ", thread_id);
+    }
+    printf("%s%s loop: %lu calls, %lu partial, %lu waits, %.2f µs per call\n",
+           prefix, what, ls->calls, ls->partial, ls->waits,
+           ls->calls ? ls->syscall_ns / 1000.0 / ls->calls : 0.0);
+}
+
 /*
  * Calculate throughput in Gbps
  */
@@ -209,6 +560,1603 @@ static inline double calc_throughput_gbps(unsigned long bytes, double seconds) {
     return (bytes * 8.0) / (seconds * 1000000000.0);
 }
 
+/*
+ * Credit-based flow control (optional, enabled with -c on both sides)
+ *
+ * The client grants the server credit in bytes by writing 32-bit
+ * network-order integers on the same connection. The server only sends a
+ * message when it holds enough credit for all of it, so the bytes in flight
+ * (socket buffers plus pinned MSG_ZEROCOPY pages) never exceed the window,
+ * whatever the TCP buffer sizes are.
+ */
+typedef struct {
+    unsigned long available;       /* Granted and not yet used */
+    unsigned long stalls;          /* Times the sender had to wait */
+    unsigned char partial[4];      /* Grant split across two reads */
+    size_t partial_len;
+} CreditState;
+
+typedef struct {
+    unsigned long window;          /* Total credit the client keeps open */
+    unsigned long threshold;       /* Consumed bytes that trigger a grant */
+    unsigned long consumed;        /* Received since the last grant */
+} CreditGranter;
+
+/*
+ * Read whatever grants have arrived. Blocks for at most timeout_ms.
+ * Returns 0 on success, -1 if the peer closed or the read failed.
+ */
+static inline int credit_read(int fd, CreditState *cs, int timeout_ms) {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return 0;
+    }
+
+    unsigned char buf[256];
+    ssize_t n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n == 0) return -1;
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+
+    for (ssize_t i = 0; i < n; i++) {
+        cs->partial[cs->partial_len++] = buf[i];
+        if (cs->partial_len == sizeof(cs->partial)) {
+            uint32_t grant;
+            memcpy(&grant, cs->partial, sizeof(grant));
+            cs->available += ntohl(grant);
+            cs->partial_len = 0;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Wait until at least `need` bytes of credit are available.
+ * Returns 0 when the send may proceed, -1 if the run is over or the peer closed.
+ */
+static inline int credit_acquire(int fd, CreditState *cs, size_t need,
+                                 const RunWindow *w) {
+    if (cs->available >= need) return 0;
+
+    cs->stalls++;
+    while (cs->available < need) {
+        if (run_wait(fd, POLLIN, w, -1) < 0) return -1;
+        if (credit_read(fd, cs, 0) < 0) return -1;
+    }
+    return 0;
+}
+
+/* Charge a completed send against the available credit */
+static inline void credit_consume(CreditState *cs, size_t sent) {
+    cs->available = sent > cs->available ? 0 : cs->available - sent;
+}
+
+/*
+ * Finish a credit-mode connection: stop sending and read the remaining
+ * grants until the client closes, so close() does not reset the connection
+ * with unread grants still queued.
+ */
+static inline void credit_drain(int fd, CreditState *cs) {
+    shutdown(fd, SHUT_WR);
+    double deadline = get_time_sec() + 1.0;
+    while (get_time_sec() < deadline) {
+        if (credit_read(fd, cs, 100) < 0) break;
+    }
+}
+
+/* Send a single grant of `bytes` to the server */
+static inline int credit_grant(int fd, unsigned long bytes) {
+    uint32_t grant = htonl((uint32_t)bytes);
+    return send(fd, &grant, sizeof(grant), 0) == sizeof(grant) ? 0 : -1;
+}
+
+/*
+ * Enable credit mode on the client side of a connection. Grants are tiny
+ * writes, so Nagle is disabled to keep them from waiting on delayed ACKs.
+ */
+static inline int credit_start(int fd, unsigned long window) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return credit_grant(fd, window);
+}
+
+/*
+ * Set up the client side of a window. Credit is returned in batches of half
+ * the window, but never so late that the server is left with less than one
+ * message of credit while the client holds the rest back.
+ */
+static inline void credit_granter_init(CreditGranter *cg, unsigned long window,
+                                       size_t msg_size) {
+    cg->window = window;
+    cg->consumed = 0;
+    cg->threshold = window / 2;
+    if (window >= msg_size && window - msg_size + 1 < cg->threshold) {
+        cg->threshold = window - msg_size + 1;
+    }
+    if (cg->threshold == 0) {
+        cg->threshold = 1;
+    }
+}
+
+/* Account for received bytes and return credit once the threshold is reached */
+static inline int credit_return(int fd, CreditGranter *cg, size_t received) {
+    cg->consumed += received;
+    if (cg->consumed < cg->threshold) return 0;
+
+    unsigned long bytes = cg->consumed;
+    cg->consumed = 0;
+    return credit_grant(fd, bytes);
+}
+
+/*
+ * Parse a credit window: plain bytes, or a message count with an "msg"
+ * suffix (e.g. "16msg"). Windows smaller than one message would deadlock,
+ * so they are rounded up to msg_size. In multiplexed mode the window must
+ * also hold the server's largest frame (header plus chunk), which only the
+ * server knows; it refuses a connection whose window is smaller.
+ */
+static inline unsigned long parse_credit_window(const char *arg, size_t msg_size) {
+    char *end = NULL;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (end && strcmp(end, "msg") == 0) {
+        value *= msg_size;
+    }
+    if (value > 0 && value < msg_size) {
+        value = msg_size;
+    }
+    if (value > UINT32_MAX) {
+        value = UINT32_MAX;
+    }
+    return value;
+}
+
+/* Latency histogram operations (LatencyHistogram is defined above) */
+static inline int lat_bucket(uint64_t ns) {
+    if (ns < (1u << LAT_SUB_BITS)) return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int sub = (int)((ns >> (msb - LAT_SUB_BITS)) & ((1u << LAT_SUB_BITS) - 1));
+    return ((msb - LAT_SUB_BITS + 1) << LAT_SUB_BITS) + sub;
+}
+
+/* Lower bound of a bucket in nanoseconds */
+static inline uint64_t lat_bucket_floor(int idx) {
+    if (idx < (1 << LAT_SUB_BITS)) return (uint64_t)idx;
+    int msb = (idx >> LAT_SUB_BITS) + LAT_SUB_BITS - 1;
+    uint64_t sub = idx & ((1 << LAT_SUB_BITS) - 1);
+    return (1ULL << msb) | (sub << (msb - LAT_SUB_BITS));
+}
+
+static inline void lat_hist_add(LatencyHistogram *h, double us) {
+    uint64_t ns = us > 0 ? (uint64_t)(us * 1000.0) : 0;
+    h->counts[lat_bucket(ns)]++;
+    h->total++;
+    h->sum_us += us;
+    if (us > h->max_us) h->max_us = us;
+}
+
+static inline void lat_hist_merge(LatencyHistogram *dst, const LatencyHistogram *src) {
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->sum_us += src->sum_us;
+    if (src->max_us > dst->max_us) dst->max_us = src->max_us;
+}
+
+/* Value at quantile q (0..1) in microseconds */
+static inline double lat_hist_percentile(const LatencyHistogram *h, double q) {
+    if (h->total == 0) return 0.0;
+    unsigned long rank = (unsigned long)(q * (h->total - 1)) + 1;
+    unsigned long seen = 0;
+    for (int i = 0; i < LAT_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) return lat_bucket_floor(i) / 1000.0;
+    }
+    return h->max_us;
+}
+
+/*
+ * Tail of a histogram as
+ *   LATCSV: <name>,<p50>,<p99>,<p99.9>,<max>
+ * (fields empty when nothing was recorded)
+ */
+static inline void lat_hist_report(const char *name, const LatencyHistogram *h) {
+    if (h->total == 0) {
+        printf("LATCSV: %s,,,,\n", name);
+        return;
+    }
+    printf("Latency p50: %.2f µs, p99: %.2f µs, p99.9: %.2f µs, max: %.2f µs\n",
+           lat_hist_percentile(h, 0.50), lat_hist_percentile(h, 0.99),
+           lat_hist_percentile(h, 0.999), h->max_us);
+    printf("LATCSV: %s,%.2f,%.2f,%.2f,%.2f\n", name,
+           lat_hist_percentile(h, 0.50), lat_hist_percentile(h, 0.99),
+           lat_hist_percentile(h, 0.999), h->max_us);
+}
+
+/*
+ * Set SO_PRIORITY on a socket (-P). Priorities 0-6 need no privileges; the
+ * default prio qdisc priomap sends 6 (interactive) to band 0 and 2 (bulk)
+ * to band 2. A negative value leaves the socket untouched.
+ */
+static inline void set_socket_priority(int fd, int prio) {
+    if (prio < 0) return;
+    if (setsockopt(fd, SOL_SOCKET, SO_PRIORITY, &prio, sizeof(prio)) < 0) {
+        perror("setsockopt SO_PRIORITY failed");
+    }
+}
+
+/*
+ * Lazy message buffers (-L)
+ *
+ * Normally every connection thread owns a full Message for its whole life,
+ * even while its client is slow or idle and the socket buffer is full. In
+ * lazy mode the thread takes a buffer from a shared pool only while the
+ * socket accepts data and hands it back as soon as a non-blocking send
+ * would block, so buffer memory follows the number of connections that are
+ * actually sending, not the number that are open. All buffers hold the
+ * same bytes, so a partly sent message can be finished from any of them.
+ */
+typedef struct PooledMessage {
+    Message *msg;
+    SerializedMessage *smsg;       /* Contiguous copy (send() engine only) */
+    struct PooledMessage *next;
+} PooledMessage;
+
+typedef struct MessagePool {
+    pthread_mutex_t lock;
+    PooledMessage *free_list;
+    size_t field_size;
+    int serialized;
+    unsigned long created;
+    unsigned long in_use;
+    unsigned long peak_in_use;
+} MessagePool;
+
+static inline void pool_init(MessagePool *pool, size_t field_size, int serialized) {
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->field_size = field_size;
+    pool->serialized = serialized;
+}
+
+static inline PooledMessage* pool_get(MessagePool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    PooledMessage *pm = pool->free_list;
+    if (pm) {
+        pool->free_list = pm->next;
+    }
+    if (++pool->in_use > pool->peak_in_use) {
+        pool->peak_in_use = pool->in_use;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    if (pm) {
+        return pm;
+    }
+
+    /* Pool empty: build a new buffer outside the lock */
+    pm = (PooledMessage*)calloc(1, sizeof(PooledMessage));
+    if (pm) pm->msg = create_message(pool->field_size);
+    if (pm && pm->msg && pool->serialized) {
+        pm->smsg = serialize_message(pm->msg, pool->field_size);
+    }
+    if (!pm || !pm->msg || (pool->serialized && !pm->smsg)) {
+        if (pm) free_message(pm->msg);
+        free(pm);
+        pthread_mutex_lock(&pool->lock);
+        pool->in_use--;
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->created++;
+    pthread_mutex_unlock(&pool->lock);
+    return pm;
+}
+
+static inline void pool_put(MessagePool *pool, PooledMessage *pm) {
+    pthread_mutex_lock(&pool->lock);
+    pm->next = pool->free_list;
+    pool->free_list = pm;
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static inline void pool_destroy(MessagePool *pool) {
+    while (pool->free_list) {
+        PooledMessage *pm = pool->free_list;
+        pool->free_list = pm->next;
+        free_serialized_message(pm->smsg);
+        free_message(pm->msg);
+        free(pm);
+    }
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/* iovec over a message's fields starting at byte offset; returns the count */
+static inline int message_iov(const Message *msg, size_t field_size, size_t offset,
+                              struct iovec *iov) {
+    char *fields[NUM_FIELDS] = {
+        msg->field1, msg->field2, msg->field3, msg->field4,
+        msg->field5, msg->field6, msg->field7, msg->field8
+    };
+    int n = 0;
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        if (offset >= field_size) {
+            offset -= field_size;
+            continue;
+        }
+        iov[n].iov_base = fields[i] + offset;
+        iov[n].iov_len = field_size - offset;
+        offset = 0;
+        n++;
+    }
+    return n;
+}
+
+/*
+ * Engine hook for lazy_serve(): send up to len bytes of the message
+ * starting at offset, without blocking (MSG_DONTWAIT).
+ */
+typedef ssize_t (*lazy_send_fn)(int fd, PooledMessage *pm, size_t field_size,
+                                size_t offset, size_t len, void *ctx);
+
+/*
+ * Engine hook for lazy_serve(): give the buffer back. A3 hands a buffer
+ * that zero-copy sends may still read to pool_put_after() instead.
+ */
+typedef void (*lazy_release_fn)(int fd, MessagePool *pool, PooledMessage *pm, void *ctx);
+
+/*
+ * Lazy send loop for one connection. release (optional, default
+ * pool_put()) returns the buffer whenever the socket blocks and when the
+ * loop ends; the next send takes a fresh one.
+ */
+static inline void lazy_serve(ServerThreadArgs *args, int fd, lazy_send_fn send_fn,
+                              lazy_release_fn release, void *ctx, const RunWindow *w) {
+    MessagePool *pool = args->pool;
+    size_t field_size = args->msg_size / NUM_FIELDS;
+    size_t total_msg_size = NUM_FIELDS * field_size;
+    PooledMessage *pm = NULL;
+    size_t offset = 0;
+    CreditState credit;
+    memset(&credit, 0, sizeof(credit));
+
+    while (window_live(w)) {
+        /* In credit mode, wait until the client has granted room for a full message */
+        if (offset == 0 && args->use_credit &&
+            credit_acquire(fd, &credit, total_msg_size, w) < 0) {
+            break;
+        }
+
+        if (!pm && !(pm = pool_get(pool))) {
+            perror("Failed to allocate pooled message");
+            break;
+        }
+
+        ssize_t sent = send_fn(fd, pm, field_size, offset, total_msg_size - offset, ctx);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                /* Socket full: return the buffer while waiting for room */
+                if (release) {
+                    release(fd, pool, pm, ctx);
+                } else {
+                    pool_put(pool, pm);
+                }
+                pm = NULL;
+                if (run_wait(fd, POLLOUT, w, -1) < 0) break;
+                continue;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EPIPE || errno == ECONNRESET) {
+                printf("[Thread %d] Client disconnected\n", args->thread_id);
+                break;
+            }
+            perror("send failed");
+            break;
+        }
+
+        args->bytes_sent += sent;
+        core_account(sent);
+        offset += sent;
+        if (offset == total_msg_size) {
+            offset = 0;
+            args->messages_sent++;
+        }
+        if (args->use_credit) {
+            credit_consume(&credit, sent);
+        }
+    }
+
+    args->credit_stalls = credit.stalls;
+    if (pm && release) {
+        release(fd, pool, pm, ctx);
+    } else if (pm) {
+        pool_put(pool, pm);
+    }
+    if (args->use_credit) {
+        credit_drain(fd, &credit);
+    }
+}
+
+/*
+ * Thread attributes for connection threads: a stack of stack_kb KB instead
+ * of the default (usually 8 MB of address space). Returns NULL to use the
+ * defaults when stack_kb is 0; exits if the size is rejected.
+ */
+static inline pthread_attr_t* conn_thread_attr(pthread_attr_t *attr, size_t stack_kb) {
+    if (stack_kb == 0) {
+        return NULL;
+    }
+    pthread_attr_init(attr);
+    if (pthread_attr_setstacksize(attr, stack_kb * 1024) != 0) {
+        fprintf(stderr, "Invalid thread stack size %zu KB (minimum %ld KB)\n",
+                stack_kb, (long)(PTHREAD_STACK_MIN / 1024));
+        exit(EXIT_FAILURE);
+    }
+    return attr;
+}
+
+/*
+ * MSG_ZEROCOPY completion tracking
+ *
+ * Every successful MSG_ZEROCOPY sendmsg() on a socket gets the next 32-bit
+ * id, and the kernel reports finished ids as ranges on the socket's error
+ * queue. Until its completion arrives, the send's pages stay pinned and the
+ * buffer must not be reused or freed. The tracker remembers the size of
+ * each outstanding send in a ring, so the bytes still pinned are known
+ * exactly, and reaps completions to keep the error queue (and the socket's
+ * optmem budget) from filling up. Pooled buffers handed to zc_release()
+ * wait in a retire list until every send made before the release has
+ * completed; only then do they go back to the buffer pool.
+ */
+#define ZC_RING 4096
+
+typedef struct {
+    void *buf;
+    size_t size;
+    uint32_t after;                /* Reusable once done_id reaches this id */
+} ZcRetired;
+
+typedef struct {
+    uint32_t next_id;              /* Id the kernel gives the next zerocopy send */
+    uint32_t done_id;              /* All ids below this have completed */
+    unsigned char *completed;      /* Per-id completion flags (ring) */
+    uint32_t *sizes;               /* Per-id send size (ring) */
+    unsigned long outstanding_bytes;
+    unsigned long completions;
+    unsigned long copied;          /* Completions where the kernel copied instead */
+    ZcRetired *retired;            /* Buffers waiting for their completions */
+    int nretired;
+    int retired_cap;
+} ZcTracker;
+
+/* Pinned bytes across all connections in this process (for snapshots) */
+static unsigned long zc_outstanding_total = 0;
+
+static inline int zc_tracker_init(ZcTracker *t) {
+    memset(t, 0, sizeof(*t));
+    t->completed = (unsigned char*)calloc(ZC_RING, 1);
+    t->sizes = (uint32_t*)calloc(ZC_RING, sizeof(uint32_t));
+    return (t->completed && t->sizes) ? 0 : -1;
+}
+
+static inline uint32_t zc_in_flight(const ZcTracker *t) {
+    return t->next_id - t->done_id;
+}
+
+/*
+ * Buffers still retired here may be read by sends that never completed
+ * (zc_drain timed out); they are left allocated rather than reused.
+ */
+static inline void zc_tracker_free(ZcTracker *t) {
+    __atomic_sub_fetch(&zc_outstanding_total, t->outstanding_bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&bufpool_stats.abandoned, t->nretired, __ATOMIC_RELAXED);
+    free(t->completed);
+    free(t->sizes);
+    free(t->retired);
+    t->completed = NULL;
+    t->sizes = NULL;
+    t->retired = NULL;
+    t->nretired = 0;
+}
+
+/* Put retired buffers whose sends have all completed back into the pool */
+static inline void zc_release_due(ZcTracker *t) {
+    int kept = 0;
+    for (int i = 0; i < t->nretired; i++) {
+        ZcRetired *r = &t->retired[i];
+        if ((int32_t)(t->done_id - r->after) >= 0) {
+            bufpool_put(r->buf, r->size);
+        } else {
+            t->retired[kept++] = *r;
+        }
+    }
+    t->nretired = kept;
+}
+
+/*
+ * Give a pooled buffer back once no MSG_ZEROCOPY send made so far can
+ * still read it: at once if nothing is in flight (or t is NULL), otherwise
+ * when zc_reap() has seen the completions.
+ */
+static inline void zc_release(ZcTracker *t, void *buf, size_t size) {
+    if (!buf) return;
+    if (!t || zc_in_flight(t) == 0) {
+        bufpool_put(buf, size);
+        return;
+    }
+    if (t->nretired == t->retired_cap) {
+        int cap = t->retired_cap ? 2 * t->retired_cap : 16;
+        ZcRetired *grown = (ZcRetired*)realloc(t->retired, cap * sizeof(ZcRetired));
+        if (!grown) {
+            /* Cannot wait for it: leave it allocated rather than reuse it */
+            __atomic_add_fetch(&bufpool_stats.abandoned, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        t->retired = grown;
+        t->retired_cap = cap;
+    }
+    t->retired[t->nretired++] = (ZcRetired){ buf, size, t->next_id };
+    BUFPOOL_COUNT(deferred);
+}
+
+/* free_message() for a Message whose fields zero-copy sends may still read */
+static inline void zc_free_message(ZcTracker *t, Message *msg) {
+    if (!msg) return;
+    char *fields[NUM_FIELDS] = {
+        msg->field1, msg->field2, msg->field3, msg->field4,
+        msg->field5, msg->field6, msg->field7, msg->field8
+    };
+    for (int i = 0; i < NUM_FIELDS; i++) {
+        zc_release(t, fields[i], msg->field_size);
+    }
+    free(msg);
+}
+
+/*
+ * pool_put() for a lazy buffer that zero-copy sends may still read: with
+ * sends in flight it leaves the pool for good and its memory is retired in
+ * t, so it is reused only after their completions (or abandoned when the
+ * tracker is freed first).
+ */
+static inline void pool_put_after(MessagePool *pool, PooledMessage *pm, ZcTracker *t) {
+    if (!t || zc_in_flight(t) == 0) {
+        pool_put(pool, pm);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->lock);
+    if (pm->smsg) {
+        zc_release(t, pm->smsg, sizeof(SerializedMessage) + pm->smsg->total_size);
+    }
+    zc_free_message(t, pm->msg);
+    free(pm);
+}
+
+/* Record a successful MSG_ZEROCOPY send of `bytes` */
+static inline void zc_track(ZcTracker *t, size_t bytes) {
+    uint32_t slot = t->next_id % ZC_RING;
+    t->sizes[slot] = bytes;
+    t->completed[slot] = 0;
+    t->next_id++;
+    t->outstanding_bytes += bytes;
+    __atomic_add_fetch(&zc_outstanding_total, bytes, __ATOMIC_RELAXED);
+}
+
+/*
+ * Read completion notifications. Waits up to timeout_ms for the first one
+ * (0 = just poll). Returns the number of sends completed.
+ */
+static inline int zc_reap(int fd, ZcTracker *t, int timeout_ms) {
+    int reaped = 0;
+
+    if (timeout_ms > 0) {
+        struct pollfd pfd = { .fd = fd, .events = 0 };
+        if (poll(&pfd, 1, timeout_ms) <= 0 || !(pfd.revents & POLLERR)) {
+            return 0;
+        }
+    }
+
+    for (;;) {
+        char control[128];
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_control = control;
+        mh.msg_controllen = sizeof(control);
+
+        if (recvmsg(fd, &mh, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            struct sock_extended_err *ee = (struct sock_extended_err*)CMSG_DATA(cm);
+            if (ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee->ee_errno != 0) {
+                continue;
+            }
+
+            /* Ids ee_info..ee_data (inclusive) have completed */
+            uint32_t lo = ee->ee_info, hi = ee->ee_data;
+            for (uint32_t id = lo; id - lo <= hi - lo; id++) {
+                if (id - t->done_id >= zc_in_flight(t)) continue;
+                uint32_t slot = id % ZC_RING;
+                if (t->completed[slot]) continue;
+                t->completed[slot] = 1;
+                t->outstanding_bytes -= t->sizes[slot];
+                __atomic_sub_fetch(&zc_outstanding_total, t->sizes[slot], __ATOMIC_RELAXED);
+                t->completions++;
+                if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) t->copied++;
+                reaped++;
+                if (id == hi) break;
+            }
+        }
+    }
+
+    /* Advance past the completed prefix */
+    while (t->done_id != t->next_id && t->completed[t->done_id % ZC_RING]) {
+        t->done_id++;
+    }
+    if (t->nretired) {
+        zc_release_due(t);
+    }
+    return reaped;
+}
+
+/*
+ * Keep at most max_in_flight sends unreaped (capped at the ring size).
+ * Called after each zerocopy send; polls the error queue every 16 sends and
+ * blocks only when the limit is reached (until shutdown or the end of w,
+ * which may be NULL).
+ */
+static inline void zc_throttle(int fd, ZcTracker *t, uint32_t max_in_flight,
+                               const RunWindow *w) {
+    if (max_in_flight == 0 || max_in_flight > ZC_RING) max_in_flight = ZC_RING;
+    if ((t->next_id & 15) == 0) {
+        zc_reap(fd, t, 0);
+    }
+    while (zc_in_flight(t) >= max_in_flight) {
+        /* Completions are reported as POLLERR, which poll() always watches */
+        if (run_wait(fd, 0, w, 100) < 0) break;
+        zc_reap(fd, t, 0);
+    }
+}
+
+/* Wait (up to timeout_ms in total) for every outstanding send to complete */
+static inline void zc_drain(int fd, ZcTracker *t, int timeout_ms) {
+    double deadline = get_time_sec() + timeout_ms / 1000.0;
+    zc_reap(fd, t, 0);
+    while (zc_in_flight(t) > 0 && get_time_sec() < deadline) {
+        zc_reap(fd, t, 50);
+    }
+}
+
+/*
+ * Connection table for the servers
+ *
+ * One slot per connection thread. When a connection ends, its thread marks
+ * the slot done; the accept loop joins finished threads, folds their
+ * metrics into the totals and reuses the slot, so long runs with
+ * reconnecting clients neither run out of slots nor keep dead threads.
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_t *threads;
+    ServerThreadArgs *args;
+    int *in_use;
+    int max;
+    int active;
+    /* Totals from finished connections */
+    unsigned long finished;
+    unsigned long total_bytes;
+    unsigned long total_messages;
+    unsigned long total_stalls;
+    double max_time;
+    LoopStats loop_stats;
+    TmaCounts tma;
+    CoreCounts cores;
+    unsigned long steered;         /* Steered connections (-C) */
+    unsigned long on_incoming;     /* ... that finished on their incoming CPU */
+} ConnTable;
+
+static inline int conn_table_init(ConnTable *t, int max) {
+    memset(t, 0, sizeof(*t));
+    pthread_mutex_init(&t->lock, NULL);
+    t->max = max;
+    t->threads = (pthread_t*)calloc(max, sizeof(pthread_t));
+    t->args = (ServerThreadArgs*)calloc(max, sizeof(ServerThreadArgs));
+    t->in_use = (int*)calloc(max, sizeof(int));
+    return (t->threads && t->args && t->in_use) ? 0 : -1;
+}
+
+static inline void conn_table_free(ConnTable *t) {
+    free(t->threads);
+    free(t->args);
+    free(t->in_use);
+    pthread_mutex_destroy(&t->lock);
+}
+
+/* Runs when the handler returns or calls pthread_exit() */
+static inline void conn_mark_done(void *arg) {
+    ServerThreadArgs *a = (ServerThreadArgs*)arg;
+    if (a->topdown) {
+        tma_stop(&a->tma_probe, &a->tma);
+    }
+    if (a->placement) {
+        core_probe_stop(&a->core_probe, &a->cores);
+    }
+    if (a->steer) {
+        /* Where the packets arrive now: the flow may have moved since accept */
+        socklen_t len = sizeof(a->incoming_cpu);
+        if (a->steer_fd < 0 ||
+            getsockopt(a->steer_fd, SOL_SOCKET, SO_INCOMING_CPU, &a->incoming_cpu, &len) < 0) {
+            a->incoming_cpu = -1;
+        }
+        a->on_incoming = a->incoming_cpu >= 0 && sched_getcpu() == a->incoming_cpu;
+        if (a->steer_fd >= 0) close(a->steer_fd);
+        a->steer_fd = -1;
+    }
+    __atomic_store_n(&a->done, 1, __ATOMIC_RELEASE);
+}
+
+static inline void* conn_thread_main(void *arg) {
+    ServerThreadArgs *a = (ServerThreadArgs*)arg;
+    /* Pin first, so the whole window runs on the chosen core type */
+    if (a->placement) {
+        core_pin_self(a->placement);
+        core_probe_start(&a->core_probe);
+    }
+    /* -C: run next to the connection's softirq (or on a random CPU) */
+    if (a->steer && a->steer_cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(a->steer_cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    /* The thread starts inside the measurement window, so its counters cover it */
+    if (a->topdown && tma_start(&a->tma_probe) < 0) {
+        a->topdown = 0;
+    }
+    /* The handler closes client_fd; a duplicate keeps the socket readable until done */
+    a->steer_fd = a->steer ? dup(a->client_fd) : -1;
+    pthread_cleanup_push(conn_mark_done, a);
+    a->handler(a);
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+/* Join finished connections (or all of them) and fold in their metrics */
+static inline void conn_table_reap(ConnTable *t, int wait_all) {
+    for (int i = 0; i < t->max; i++) {
+        if (!t->in_use[i]) continue;
+        if (!wait_all && !__atomic_load_n(&t->args[i].done, __ATOMIC_ACQUIRE)) continue;
+
+        pthread_join(t->threads[i], NULL);
+
+        ServerThreadArgs *a = &t->args[i];
+        pthread_mutex_lock(&t->lock);
+        t->total_bytes += a->bytes_sent;
+        t->total_messages += a->messages_sent;
+        t->total_stalls += a->credit_stalls;
+        if (a->elapsed_time > t->max_time) t->max_time = a->elapsed_time;
+        loop_stats_add(&t->loop_stats, &a->loop_stats);
+        tma_add(&t->tma, &a->tma);
+        core_counts_add(&t->cores, &a->cores);
+        if (a->steer) {
+            t->steered++;
+            t->on_incoming += a->on_incoming;
+        }
+        t->finished++;
+        t->in_use[i] = 0;
+        t->active--;
+        pthread_mutex_unlock(&t->lock);
+    }
+}
+
+/*
+ * Start a connection thread from a template. Metrics start at zero.
+ * Returns 0 on success, -1 if the table is full or the thread could not be
+ * created; the caller still owns (and must close) the socket in that case.
+ */
+static inline int conn_table_start(ConnTable *t, const ServerThreadArgs *tmpl,
+                                   void *(*handler)(void *),
+                                   const pthread_attr_t *attr) {
+    int slot = -1;
+    for (int pass = 0; pass < 2 && slot < 0; pass++) {
+        if (pass == 1) conn_table_reap(t, 0);
+        for (int i = 0; i < t->max; i++) {
+            if (!t->in_use[i]) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot < 0) {
+        printf("Maximum threads reached, rejecting client\n");
+        return -1;
+    }
+
+    ServerThreadArgs *a = &t->args[slot];
+    pthread_mutex_lock(&t->lock);
+    *a = *tmpl;
+    a->handler = handler;
+    a->done = 0;
+    a->bytes_sent = 0;
+    a->messages_sent = 0;
+    a->credit_stalls = 0;
+    a->elapsed_time = 0;
+    memset(&a->loop_stats, 0, sizeof(a->loop_stats));
+    memset(&a->tma, 0, sizeof(a->tma));
+    memset(&a->cores, 0, sizeof(a->cores));
+    a->on_incoming = 0;
+    t->in_use[slot] = 1;
+    t->active++;
+    pthread_mutex_unlock(&t->lock);
+
+    if (pthread_create(&t->threads[slot], attr, conn_thread_main, a) != 0) {
+        perror("pthread_create failed");
+        pthread_mutex_lock(&t->lock);
+        t->in_use[slot] = 0;
+        t->active--;
+        pthread_mutex_unlock(&t->lock);
+        return -1;
+    }
+    return 0;
+}
+
+/* Bytes sent so far by finished and running connections */
+static inline unsigned long conn_table_bytes(ConnTable *t, int *active) {
+    pthread_mutex_lock(&t->lock);
+    unsigned long bytes = t->total_bytes;
+    for (int i = 0; i < t->max; i++) {
+        if (t->in_use[i]) bytes += t->args[i].bytes_sent;
+    }
+    *active = t->active;
+    pthread_mutex_unlock(&t->lock);
+    return bytes;
+}
+
+/*
+ * Periodic resource snapshots (-S <seconds>) for soak runs
+ *
+ * A monitor thread prints one line per interval:
+ *   SNAP: <t_sec>,<gbps>,<rss_kb>,<open_fds>,<threads>,<zc_outstanding_bytes>,<active_conns>
+ * where gbps covers the last interval only. MT25033_Part_C_Soak.sh collects
+ * these lines and flags metrics that keep growing.
+ */
+typedef struct {
+    ConnTable *table;
+    int interval;
+} SnapshotArgs;
+
+static inline long proc_rss_kb(void) {
+    long pages_total = 0, pages_rss = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (fscanf(f, "%ld %ld", &pages_total, &pages_rss) != 2) pages_rss = -1;
+    fclose(f);
+    return pages_rss < 0 ? -1 : pages_rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static inline int proc_open_fds(void) {
+    DIR *d = opendir("/proc/self/fd");
+    if (!d) return -1;
+    int n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] != '.') n++;
+    }
+    closedir(d);
+    return n - 1;                  /* The directory stream itself */
+}
+
+static inline int proc_threads(void) {
+    char line[256];
+    int threads = -1;
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "Threads: %d", &threads) == 1) break;
+    }
+    fclose(f);
+    return threads;
+}
+
+static inline void* snapshot_thread(void *arg) {
+    SnapshotArgs *sa = (SnapshotArgs*)arg;
+    double start = get_time_sec();
+    double last_time = start;
+    int active = 0;
+    unsigned long last_bytes = conn_table_bytes(sa->table, &active);
+
+    for (;;) {
+        /* Sleep on the shutdown eventfd so stopping is not delayed by the interval */
+        RunWindow nap = { last_time, last_time + sa->interval };
+        int r;
+        do {
+            r = run_wait(-1, 0, &nap, -1);
+        } while (r == 0);
+        if (!run_active()) break;
+
+        double now = get_time_sec();
+        unsigned long bytes = conn_table_bytes(sa->table, &active);
+        printf("SNAP: %.1f,%.4f,%ld,%d,%d,%lu,%d\n",
+               now - start, calc_throughput_gbps(bytes - last_bytes, now - last_time),
+               proc_rss_kb(), proc_open_fds(), proc_threads(),
+               __atomic_load_n(&zc_outstanding_total, __ATOMIC_RELAXED), active);
+        fflush(stdout);
+        last_bytes = bytes;
+        last_time = now;
+    }
+    return NULL;
+}
+
+/*
+ * Energy over the measurement window from RAPL (powercap)
+ *
+ * Every package zone (intel-rapl:N, "package-N") and its DRAM subzone
+ * ("dram") is read when the window opens and again when it closes. The
+ * counters are cumulative microjoules that wrap at max_energy_range_uj;
+ * a smaller reading than the last one means one wrap. The servers also
+ * sample from the accept loop about once a second, so windows longer than
+ * a full counter range (minutes at high power) still add up. Core and
+ * uncore subzones are part of the package and psys covers the whole
+ * platform, so neither is added. Without readable zones (no RAPL, a VM,
+ * or energy_uj restricted to root) nothing is reported. A zone whose
+ * counter wraps while max_energy_range_uj is unreadable has no known delta;
+ * its fields stay empty for that window.
+ */
+#ifndef POWERCAP_DIR
+#define POWERCAP_DIR "/sys/class/powercap"
+#endif
+
+#define ENERGY_MAX_ZONES 16
+
+typedef struct {
+    int nzones;
+    char path[ENERGY_MAX_ZONES][64];   /* <zone>/energy_uj, relative to POWERCAP_DIR */
+    int dram[ENERGY_MAX_ZONES];        /* DRAM zone (else package) */
+    uint64_t range[ENERGY_MAX_ZONES];  /* max_energy_range_uj */
+    uint64_t last[ENERGY_MAX_ZONES];
+    double joules[ENERGY_MAX_ZONES];   /* Accumulated since energy_start() */
+    int invalid[ENERGY_MAX_ZONES];     /* Wrapped with an unknown range this window */
+    double start, end;
+    int running;
+} EnergyMeter;
+
+static inline int energy_read_u64(const char *zone, const char *file, uint64_t *v) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s/%s", POWERCAP_DIR, zone, file);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    unsigned long long x;
+    int ok = fscanf(f, "%llu", &x) == 1;
+    fclose(f);
+    if (!ok) return -1;
+    *v = x;
+    return 0;
+}
+
+/* Find readable package and DRAM zones; returns the number found */
+static inline int energy_open(EnergyMeter *m) {
+    memset(m, 0, sizeof(*m));
+    DIR *d = opendir(POWERCAP_DIR);
+    if (!d) return 0;
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL && m->nzones < ENERGY_MAX_ZONES) {
+        /* intel-rapl:N and intel-rapl:N:M; the bare control type has no colon */
+        if (strncmp(e->d_name, "intel-rapl:", 11) != 0 || strlen(e->d_name) > 40) continue;
+
+        char path[256], name[32] = "";
+        snprintf(path, sizeof(path), "%s/%s/name", POWERCAP_DIR, e->d_name);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        int got = fscanf(f, "%31s", name) == 1;
+        fclose(f);
+        if (!got) continue;
+
+        int dram = strcmp(name, "dram") == 0;
+        if (!dram && strncmp(name, "package", 7) != 0) continue;
+
+        uint64_t now, range;
+        if (energy_read_u64(e->d_name, "energy_uj", &now) < 0) continue;
+        if (energy_read_u64(e->d_name, "max_energy_range_uj", &range) < 0) range = 0;
+
+        int z = m->nzones++;
+        snprintf(m->path[z], sizeof(m->path[z]), "%s", e->d_name);
+        m->dram[z] = dram;
+        m->range[z] = range;
+        m->last[z] = now;
+    }
+    closedir(d);
+    return m->nzones;
+}
+
+/* Fold the change since the last reading into the totals */
+static inline void energy_sample(EnergyMeter *m) {
+    if (!m->running) return;
+    for (int z = 0; z < m->nzones; z++) {
+        uint64_t now;
+        if (energy_read_u64(m->path[z], "energy_uj", &now) < 0) continue;
+        if (now < m->last[z] && m->range[z] == 0) {
+            m->invalid[z] = 1;
+        } else {
+            uint64_t delta = now >= m->last[z] ? now - m->last[z] : now + m->range[z] - m->last[z];
+            m->joules[z] += delta / 1e6;
+        }
+        m->last[z] = now;
+    }
+}
+
+static inline void energy_start(EnergyMeter *m) {
+    for (int z = 0; z < m->nzones; z++) {
+        uint64_t now;
+        if (energy_read_u64(m->path[z], "energy_uj", &now) == 0) m->last[z] = now;
+        m->joules[z] = 0;
+        m->invalid[z] = 0;
+    }
+    m->start = get_time_sec();
+    m->running = 1;
+}
+
+static inline void energy_stop(EnergyMeter *m) {
+    energy_sample(m);
+    if (m->running) m->end = get_time_sec();
+    m->running = 0;
+}
+
+/*
+ * Report the window:
+ *   ENERGYCSV: <package_j>,<dram_j>,<seconds>,<watts>,<j_per_gb>
+ * Watts and J/GB use package + DRAM. Fields are empty when not measured.
+ */
+static inline void energy_report(const EnergyMeter *m, unsigned long bytes) {
+    double seconds = m->end - m->start;
+    if (m->nzones == 0 || seconds <= 0) {
+        printf("Energy: %s\n", m->nzones ? "no measurement window" : "RAPL counters not available");
+        printf("ENERGYCSV: ,,,,\n");
+        return;
+    }
+
+    double pkg = 0, dram = 0;
+    int have_dram = 0, pkg_ok = 1, dram_ok = 1;
+    for (int z = 0; z < m->nzones; z++) {
+        if (m->dram[z]) {
+            dram += m->joules[z];
+            have_dram = 1;
+            if (m->invalid[z]) dram_ok = 0;
+        } else {
+            pkg += m->joules[z];
+            if (m->invalid[z]) pkg_ok = 0;
+        }
+    }
+    double total = pkg + dram;
+    double gb = bytes / 1e9;
+    int total_ok = pkg_ok && (!have_dram || dram_ok);
+    char pkg_s[32] = "", dram_s[32] = "", watts[32] = "", jpg[32] = "";
+    if (pkg_ok) snprintf(pkg_s, sizeof(pkg_s), "%.3f", pkg);
+    if (have_dram && dram_ok) snprintf(dram_s, sizeof(dram_s), "%.3f", dram);
+    if (total_ok) snprintf(watts, sizeof(watts), "%.3f", total / seconds);
+    if (total_ok && gb > 0) snprintf(jpg, sizeof(jpg), "%.4f", total / gb);
+
+    if (total_ok) {
+        printf("Energy: package %.2f J%s%s J over %.2f s: %.2f W, %s J/GB\n",
+               pkg, have_dram ? ", DRAM " : "", dram_s, seconds, total / seconds,
+               gb > 0 ? jpg : "-");
+    } else {
+        printf("Energy: a counter wrapped with an unknown range over %.2f s, "
+               "package %s J, DRAM %s J\n", seconds, pkg_ok ? pkg_s : "-",
+               have_dram && dram_ok ? dram_s : "-");
+    }
+    printf("ENERGYCSV: %s,%s,%.3f,%s,%s\n", pkg_s, dram_s, seconds, watts, jpg);
+}
+
+/*
+ * CPU time over the measurement window, from getrusage() of this process
+ * and of the children it has waited for (forked workers). Cores used is
+ * CPU seconds over wall seconds, the denominator of throughput per core:
+ *   CPUCSV: <side>,<user_s>,<sys_s>,<seconds>,<cores>
+ */
+typedef struct {
+    double start, end;
+    double user, sys;              /* Totals at the start, then the window's */
+    int running;
+} CpuMeter;
+
+static inline void cpu_times(double *user, double *sys) {
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    *user = self.ru_utime.tv_sec + children.ru_utime.tv_sec +
+            (self.ru_utime.tv_usec + children.ru_utime.tv_usec) / 1e6;
+    *sys = self.ru_stime.tv_sec + children.ru_stime.tv_sec +
+           (self.ru_stime.tv_usec + children.ru_stime.tv_usec) / 1e6;
+}
+
+static inline void cpu_start(CpuMeter *m) {
+    cpu_times(&m->user, &m->sys);
+    m->start = m->end = get_time_sec();
+    m->running = 1;
+}
+
+static inline void cpu_stop(CpuMeter *m) {
+    if (!m->running) return;
+    double user, sys;
+    cpu_times(&user, &sys);
+    m->user = user - m->user;
+    m->sys = sys - m->sys;
+    m->end = get_time_sec();
+    m->running = 0;
+}
+
+static inline void cpu_report(const char *side, const CpuMeter *m) {
+    double seconds = m->end - m->start;
+    if (m->running || seconds <= 0) {
+        printf("CPU (%s): no measurement window\n", side);
+        printf("CPUCSV: %s,,,,\n", side);
+        return;
+    }
+    double cores = (m->user + m->sys) / seconds;
+    printf("CPU (%s): user %.2f s, system %.2f s over %.2f s: %.2f cores\n",
+           side, m->user, m->sys, seconds, cores);
+    printf("CPUCSV: %s,%.3f,%.3f,%.3f,%.3f\n", side, m->user, m->sys, seconds, cores);
+}
+
+/*
+ * Kernel counter deltas over the measurement window (-K 1)
+ *
+ * Snapshots /proc/net/snmp, /proc/net/netstat (TcpExt, IpExt, ...),
+ * /proc/net/softnet_stat (summed over CPUs) and /proc/vmstat when the window
+ * opens and when it closes. /proc/net is per network namespace, so a server
+ * in server_ns and a client in client_ns each see their own stack;
+ * softnet_stat and vmstat are host-wide. Every counter that changed is
+ * printed as
+ *   KSTAT: <side>,<Group.Name>,<delta>
+ * (gauges such as Tcp.CurrEstab or nr_* pages can go down, so deltas are
+ * signed), after a summary line with the usual outlier suspects.
+ */
+#define KSTAT_MAX 2048
+#define KSTAT_NAME 64
+
+typedef struct {
+    char name[KSTAT_NAME];
+    long long value;
+} KstatEntry;
+
+typedef struct {
+    int n;
+    KstatEntry *e;
+} KstatSnap;
+
+static inline void kstat_put(KstatSnap *s, const char *group, const char *name, long long v) {
+    if (s->n >= KSTAT_MAX) return;
+    snprintf(s->e[s->n].name, KSTAT_NAME, "%.15s.%.47s", group, name);
+    s->e[s->n].value = v;
+    s->n++;
+}
+
+/* snmp/netstat layout: a "Group: names..." line followed by "Group: values..." */
+static inline void kstat_read_pairs(KstatSnap *s, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    char *names = NULL, *values = NULL;
+    size_t nlen = 0, vlen = 0;
+    while (getline(&names, &nlen, f) > 0 && getline(&values, &vlen, f) > 0) {
+        char *nsave = NULL, *vsave = NULL;
+        char *group = strtok_r(names, ": \n", &nsave);
+        char *vgroup = strtok_r(values, ": \n", &vsave);
+        if (!group || !vgroup || strcmp(group, vgroup) != 0) continue;
+        char *n, *v;
+        while ((n = strtok_r(NULL, " \n", &nsave)) && (v = strtok_r(NULL, " \n", &vsave))) {
+            kstat_put(s, group, n, strtoll(v, NULL, 10));
+        }
+    }
+    free(names);
+    free(values);
+    fclose(f);
+}
+
+/* softnet_stat: one line of hex columns per CPU */
+static inline void kstat_read_softnet(KstatSnap *s) {
+    static const struct { int col; const char *name; } cols[] = {
+        { 0, "processed" }, { 1, "dropped" }, { 2, "time_squeeze" },
+        { 9, "received_rps" }, { 10, "flow_limit_count" }
+    };
+    FILE *f = fopen("/proc/net/softnet_stat", "r");
+    if (!f) return;
+    long long sum[sizeof(cols) / sizeof(cols[0])] = {0};
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char *p = line, *end;
+        for (int c = 0, k = 0; k < (int)(sizeof(cols) / sizeof(cols[0])); c++) {
+            unsigned long long v = strtoull(p, &end, 16);
+            if (end == p) break;
+            if (c == cols[k].col) sum[k++] += v;
+            p = end;
+        }
+    }
+    fclose(f);
+    for (size_t k = 0; k < sizeof(cols) / sizeof(cols[0]); k++) {
+        kstat_put(s, "Softnet", cols[k].name, sum[k]);
+    }
+}
+
+static inline void kstat_read_vmstat(KstatSnap *s) {
+    FILE *f = fopen("/proc/vmstat", "r");
+    if (!f) return;
+    char name[KSTAT_NAME];
+    long long v;
+    while (fscanf(f, "%47s %lld", name, &v) == 2) {
+        kstat_put(s, "Vmstat", name, v);
+    }
+    fclose(f);
+}
+
+/* Take a snapshot (allocates on first use); returns -1 if out of memory */
+static inline int kstat_take(KstatSnap *s) {
+    if (!s->e && !(s->e = (KstatEntry*)malloc(KSTAT_MAX * sizeof(KstatEntry)))) return -1;
+    s->n = 0;
+    kstat_read_pairs(s, "/proc/net/snmp");
+    kstat_read_pairs(s, "/proc/net/netstat");
+    kstat_read_softnet(s);
+    kstat_read_vmstat(s);
+    return 0;
+}
+
+static inline void kstat_free(KstatSnap *s) {
+    free(s->e);
+    s->e = NULL;
+    s->n = 0;
+}
+
+/* Value of name in s (the same files give the same order, so try i first) */
+static inline int kstat_find(const KstatSnap *s, const char *name, int i) {
+    if (i < s->n && strcmp(s->e[i].name, name) == 0) return i;
+    for (int j = 0; j < s->n; j++) {
+        if (strcmp(s->e[j].name, name) == 0) return j;
+    }
+    return -1;
+}
+
+static inline long long kstat_delta(const KstatSnap *before, const KstatSnap *after,
+                                    const char *name) {
+    int a = kstat_find(after, name, 0);
+    int b = kstat_find(before, name, a);
+    return (a < 0 || b < 0) ? 0 : after->e[a].value - before->e[b].value;
+}
+
+static inline void kstat_report(const char *side, const KstatSnap *before,
+                                const KstatSnap *after) {
+    if (!before->e || !after->e) return;
+    int changed = 0;
+    for (int i = 0; i < after->n; i++) {
+        int b = kstat_find(before, after->e[i].name, i);
+        if (b >= 0 && after->e[i].value != before->e[b].value) changed++;
+    }
+    printf("Kernel counters (%s): %d changed; retransmits %+lld, backlog coalesce %+lld, "
+           "softnet drops %+lld, squeezes %+lld, compaction stalls %+lld, THP faults %+lld\n",
+           side, changed, kstat_delta(before, after, "Tcp.RetransSegs"),
+           kstat_delta(before, after, "TcpExt.TCPBacklogCoalesce"),
+           kstat_delta(before, after, "Softnet.dropped"),
+           kstat_delta(before, after, "Softnet.time_squeeze"),
+           kstat_delta(before, after, "Vmstat.compact_stall"),
+           kstat_delta(before, after, "Vmstat.thp_fault_alloc"));
+    for (int i = 0; i < after->n; i++) {
+        int b = kstat_find(before, after->e[i].name, i);
+        if (b >= 0 && after->e[i].value != before->e[b].value) {
+            printf("KSTAT: %s,%s,%lld\n", side, after->e[i].name,
+                   after->e[i].value - before->e[b].value);
+        }
+    }
+}
+
+/*
+ * Address families. Clients take the family from the address they are
+ * given (-i 10.0.0.1 or -i fd00::1). Servers listen on IPv4 (the default),
+ * IPv6 only, or dual-stack: one IPv6 socket with IPV6_V6ONLY off, which
+ * also accepts IPv4 clients as v4-mapped addresses (::ffff:a.b.c.d).
+ */
+enum { FAMILY_INET, FAMILY_INET6, FAMILY_DUAL };
+
+#define PEER_STRLEN (INET6_ADDRSTRLEN + 8)
+
+/* Server -F value: 4, 6 or 46 (also inet, inet6, dual). Returns -1 if unknown. */
+static inline int parse_family(const char *s) {
+    if (strcmp(s, "4") == 0 || strcmp(s, "inet") == 0) return FAMILY_INET;
+    if (strcmp(s, "6") == 0 || strcmp(s, "inet6") == 0) return FAMILY_INET6;
+    if (strcmp(s, "46") == 0 || strcmp(s, "dual") == 0) return FAMILY_DUAL;
+    return -1;
+}
+
+static inline const char *family_name(int family) {
+    switch (family) {
+        case FAMILY_INET6: return "IPv6 only";
+        case FAMILY_DUAL:  return "dual-stack (IPv6 socket, IPv4 clients v4-mapped)";
+        default:           return "IPv4";
+    }
+}
+
+/*
+ * Fill ss with a numeric IPv4 or IPv6 address and a port.
+ * Returns the address length, or 0 if ip is neither.
+ */
+static inline socklen_t make_sockaddr(const char *ip, int port, struct sockaddr_storage *ss) {
+    struct sockaddr_in *a4 = (struct sockaddr_in*)ss;
+    struct sockaddr_in6 *a6 = (struct sockaddr_in6*)ss;
+    memset(ss, 0, sizeof(*ss));
+    if (inet_pton(AF_INET, ip, &a4->sin_addr) == 1) {
+        a4->sin_family = AF_INET;
+        a4->sin_port = htons(port);
+        return sizeof(*a4);
+    }
+    if (inet_pton(AF_INET6, ip, &a6->sin6_addr) == 1) {
+        a6->sin6_family = AF_INET6;
+        a6->sin6_port = htons(port);
+        return sizeof(*a6);
+    }
+    return 0;
+}
+
+/* "a.b.c.d:port" or "[v6]:port" of an accepted peer (buf of PEER_STRLEN) */
+static inline const char *format_peer(const struct sockaddr_storage *ss, char *buf, size_t n) {
+    char host[INET6_ADDRSTRLEN] = "?";
+    if (ss->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *a6 = (const struct sockaddr_in6*)ss;
+        inet_ntop(AF_INET6, &a6->sin6_addr, host, sizeof(host));
+        snprintf(buf, n, "[%s]:%d", host, ntohs(a6->sin6_port));
+    } else {
+        const struct sockaddr_in *a4 = (const struct sockaddr_in*)ss;
+        inet_ntop(AF_INET, &a4->sin_addr, host, sizeof(host));
+        snprintf(buf, n, "%s:%d", host, ntohs(a4->sin_port));
+    }
+    return buf;
+}
+
+/*
+ * Create the listening socket (exits on failure, like the servers always
+ * did) on the wildcard address of family (FAMILY_*). With reuseport set,
+ * SO_REUSEPORT lets several worker processes bind their own listener to
+ * the same port; the kernel spreads incoming connections across them by
+ * hash.
+ */
+static inline int create_listen_socket(int port, int reuseport, int family) {
+    int server_fd = socket(family == FAMILY_INET ? AF_INET : AF_INET6, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("socket creation failed");
+        exit(EXIT_FAILURE);
+    }
+    if (family != FAMILY_INET) {
+        int v6only = family == FAMILY_INET6;
+        if (setsockopt(server_fd, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only)) < 0) {
+            perror("setsockopt IPV6_V6ONLY failed");
+            close(server_fd);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Allow address reuse */
+    int reuse = 1;
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0) {
+        perror("setsockopt SO_REUSEADDR failed");
+        close(server_fd);
+        exit(EXIT_FAILURE);
+    }
+    if (reuseport &&
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+        perror("setsockopt SO_REUSEPORT failed");
+        close(server_fd);
+        exit(EXIT_FAILURE);
+    }
+
+    /*
+     * Non-blocking: the accept loop waits in run_accept_wait(), and with a
+     * listener shared by worker processes another worker may take the
+     * connection first
+     */
+    fcntl(server_fd, F_SETFL, fcntl(server_fd, F_GETFL) | O_NONBLOCK);
+
+    /* Bind to the wildcard address */
+    struct sockaddr_storage server_addr;
+    socklen_t addr_len = make_sockaddr(family == FAMILY_INET ? "0.0.0.0" : "::", port,
+                                       &server_addr);
+
+    if (bind(server_fd, (struct sockaddr*)&server_addr, addr_len) < 0) {
+        perror("bind failed");
+        close(server_fd);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Listen for connections (large backlog for connection-count tests) */
+    if (listen(server_fd, SOMAXCONN) < 0) {
+        perror("listen failed");
+        close(server_fd);
+        exit(EXIT_FAILURE);
+    }
+    return server_fd;
+}
+
+/*
+ * Multi-process server mode (-f <workers>)
+ *
+ * Instead of one process with a thread per connection, the server forks
+ * worker processes that each run the normal accept loop, either on the
+ * listener created before the fork (shared accept queue) or on their own
+ * SO_REUSEPORT listener (-R). Workers have separate address spaces, so
+ * page pinning for MSG_ZEROCOPY and malloc do not contend on one mm.
+ * Each worker writes its totals into a MAP_SHARED array that the parent
+ * sums once every worker has exited. Workers also flag there when their
+ * measurement window opens (first client) and closes, and the parent runs
+ * its energy, CPU and kernel counter meters from the first opening to the
+ * last closing, as the threaded server does from its first client.
+ */
+#define WORKER_POLL_MS 10
+typedef struct {
+    unsigned long connections;
+    unsigned long bytes;
+    unsigned long messages;
+    unsigned long stalls;
+    double max_time;
+    int zerocopy;                  /* A3: MSG_ZEROCOPY was enabled */
+    TmaCounts tma;
+    CoreCounts cores;
+    unsigned long steered;
+    unsigned long on_incoming;
+    double cpu_user, cpu_sys;      /* CPU seconds over the worker's window */
+    int window_opened;             /* Set by the worker at its first client */
+    int window_closed;             /* Set by the worker when its window ends */
+    pid_t pid;                     /* Parent only: 0 once reaped (or never forked) */
+} WorkerStats;
+
+static inline WorkerStats* worker_stats_alloc(int workers) {
+    void *p = mmap(NULL, workers * sizeof(WorkerStats), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        perror("Failed to map worker statistics");
+        return NULL;
+    }
+    return (WorkerStats*)p;
+}
+
+static inline void worker_stats_free(WorkerStats *ws, int workers) {
+    munmap(ws, workers * sizeof(WorkerStats));
+}
+
+/*
+ * Fork the workers. Returns the worker index (0..workers-1) in a child.
+ * In the parent, closes the nclose descriptors in parent_close (sockets
+ * only the workers should hold) and returns -1 at once; the parent then
+ * follows the workers with workers_poll() and workers_wait().
+ */
+static inline int fork_workers(WorkerStats *ws, int workers, const int *parent_close,
+                               int nclose) {
+    fflush(stdout);                /* Children must not inherit buffered output */
+    for (int i = 0; i < workers; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            return i;
+        }
+        if (pid < 0) {
+            perror("fork failed");
+            break;
+        }
+        ws[i].pid = pid;
+    }
+
+    for (int i = 0; i < nclose; i++) {
+        close(parent_close[i]);
+    }
+    return -1;
+}
+
+/* Worker: tell the parent that its measurement window has opened or closed */
+static inline void worker_window_mark(WorkerStats *ws, int closed) {
+    __atomic_store_n(closed ? &ws->window_closed : &ws->window_opened, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Parent: reap exited workers without blocking. Returns whether any
+ * worker's window has opened. *all_closed is set once every opened window
+ * has closed (or its worker exited), or, if none opened, once every worker
+ * has exited. A worker that never saw a client does not hold the meters
+ * open: as in the threaded server, clients after the window do not count.
+ */
+static inline int workers_poll(WorkerStats *ws, int workers, int *all_closed) {
+    int opened = 0, open = 0, running = 0;
+    for (int i = 0; i < workers; i++) {
+        if (ws[i].pid > 0 && waitpid(ws[i].pid, NULL, WNOHANG) == ws[i].pid) {
+            ws[i].pid = 0;
+        }
+        if (ws[i].pid > 0) running++;
+        if (__atomic_load_n(&ws[i].window_opened, __ATOMIC_ACQUIRE)) {
+            opened = 1;
+            if (ws[i].pid > 0 && !__atomic_load_n(&ws[i].window_closed, __ATOMIC_ACQUIRE)) {
+                open++;
+            }
+        }
+    }
+    *all_closed = opened ? open == 0 : running == 0;
+    return opened;
+}
+
+/* Parent: wait for every worker to exit */
+static inline void workers_wait(void) {
+    for (;;) {
+        if (wait(NULL) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+    }
+}
+
+/* Copy a worker's totals into its shared slot */
+static inline void worker_stats_store(WorkerStats *ws, const ConnTable *t, const CpuMeter *cpu) {
+    ws->connections = t->finished;
+    ws->bytes = t->total_bytes;
+    ws->messages = t->total_messages;
+    ws->stalls = t->total_stalls;
+    ws->max_time = t->max_time;
+    ws->tma = t->tma;
+    ws->cores = t->cores;
+    ws->steered = t->steered;
+    ws->on_incoming = t->on_incoming;
+    ws->cpu_user = cpu->user;
+    ws->cpu_sys = cpu->sys;
+}
+
+/*
+ * Parent: CPU time over its window is what the workers used in theirs
+ * (RUSAGE_CHILDREN would only count workers already reaped, for their
+ * whole life)
+ */
+static inline void workers_cpu(const WorkerStats *ws, int workers, CpuMeter *m) {
+    if (m->end <= m->start) return;
+    m->user = m->sys = 0;
+    for (int i = 0; i < workers; i++) {
+        m->user += ws[i].cpu_user;
+        m->sys += ws[i].cpu_sys;
+    }
+}
+
+/* Parent: per-worker and aggregate statistics */
+static inline void report_workers(const WorkerStats *ws, int workers, int reuseport,
+                                  int use_credit, const CorePlacement *placement) {
+    unsigned long total_bytes = 0, total_messages = 0, total_stalls = 0;
+    double max_time = 0;
+    TmaCounts tma;
+    memset(&tma, 0, sizeof(tma));
+    CoreCounts cores;
+    memset(&cores, 0, sizeof(cores));
+
+    printf("\n=== Final Statistics (%d worker processes, %s) ===\n",
+           workers, reuseport ? "SO_REUSEPORT listeners" : "shared listener");
+    for (int i = 0; i < workers; i++) {
+        printf("Worker %d: %lu connections, %lu bytes, %.4f Gbps\n",
+               i, ws[i].connections, ws[i].bytes,
+               calc_throughput_gbps(ws[i].bytes, ws[i].max_time));
+        total_bytes += ws[i].bytes;
+        total_messages += ws[i].messages;
+        total_stalls += ws[i].stalls;
+        if (ws[i].max_time > max_time) max_time = ws[i].max_time;
+        tma_add(&tma, &ws[i].tma);
+        core_counts_add(&cores, &ws[i].cores);
+    }
+    printf("Total bytes sent: %lu\n", total_bytes);
+    printf("Total messages sent: %lu\n", total_messages);
+    printf("Aggregate throughput: %.4f Gbps\n", calc_throughput_gbps(total_bytes, max_time));
+    if (use_credit) {
+        printf("Credit stalls: %lu\n", total_stalls);
+    }
+    if (tma.windows || tma.cache_windows) {
+        tma_report("server", &tma, total_bytes);
+    }
+    if (placement) {
+        core_report("server", placement, &cores);
+    }
+}
+
 /*
  * Print usage information
  */
@@ -219,15 +2167,45 @@ static inline void print_usage(const char *prog_name, int is_server) {
         printf("  -p <port>      Port number (default: %d)\n", DEFAULT_PORT);
         printf("  -s <size>      Message field size in bytes (default: %d)\n", DEFAULT_MSG_SIZE);
         printf("  -d <duration>  Test duration in seconds (default: %d)\n", DEFAULT_DURATION);
+        printf("  -c             Credit mode: send only within client-granted credit\n");
+        printf("  -m <streams>   Multiplex streams per connection: sizes[:weight],...\n");
+        printf("  -k <chunk>     Multiplexed/striped chunk size in bytes (default: 16384/65536)\n");
+        printf("  -r <sched>     Multiplexed scheduler: rr or drr (default: rr)\n");
+        printf("  -O <msgs/s>    Open loop: start messages at this rate per connection (implies -m)\n");
+        printf("  -G             Striped: connections of one client stream share its chunks\n");
+        printf("  -F <family>    Listen on IPv4 (4), IPv6 only (6) or dual-stack (46) (default: 4)\n");
+        printf("  -C <mode>      CPU steering: incoming (SO_INCOMING_CPU), cbpf (with -f -R) or random\n");
+        printf("  -P <prio>      SO_PRIORITY for accepted connections (0-6)\n");
+        printf("  -S <seconds>   Print resource snapshots (SNAP:) every interval\n");
+        printf("  -f <workers>   Fork worker processes instead of one threaded process\n");
+        printf("  -R             With -f: one SO_REUSEPORT listener per worker\n");
+        printf("  -n <conns>     Maximum concurrent connections (default: 100)\n");
+        printf("  -T <KB>        Connection thread stack size (default: system)\n");
+        printf("  -L             Lazy buffers: pooled, held only while the socket accepts data\n");
+        printf("  -I <0|1>       Instrumented send loop: syscall timing and counts (default: 0)\n");
+        printf("  -U <0|1>       Top-down and cache counters per connection (default: 0)\n");
+        printf("  -K <0|1>       Kernel counter deltas (snmp, netstat, softnet, vmstat) (default: 0)\n");
+        printf("  -Q <bytes>     Batch to keep this many not-sent bytes queued (SIOCOUTQNSD)\n");
+        printf("  -A <where>     Pin connection threads: core, atom, any or a CPU list\n");
         printf("  -h             Show this help\n");
     } else {
         printf("Usage: %s [options]\n", prog_name);
         printf("Options:\n");
-        printf("  -i <ip>        Server IP address (default: 127.0.0.1)\n");
+        printf("  -i <ip>        Server IPv4 or IPv6 address (default: 127.0.0.1), or a list with -G\n");
         printf("  -p <port>      Server port (default: %d)\n", DEFAULT_PORT);
         printf("  -s <size>      Message field size in bytes (default: %d)\n", DEFAULT_MSG_SIZE);
         printf("  -t <threads>   Number of client threads (default: %d)\n", DEFAULT_NUM_THREADS);
         printf("  -d <duration>  Test duration in seconds (default: %d)\n", DEFAULT_DURATION);
+        printf("  -c <window>    Grant the server credit: bytes, or messages with 'msg' suffix\n");
+        printf("  -m             Receive multiplexed frames (server started with -m or -O)\n");
+        printf("  -G <links>     Stripe each thread's stream over this many connections\n");
+        printf("  -P <prio>      SO_PRIORITY for client sockets (0-6)\n");
+        printf("  -W <usec>      Slow reader: pause after every receive\n");
+        printf("  -I <0|1>       Instrumented receive loop: per-message latency (default: 1)\n");
+        printf("  -U <0|1>       Top-down and cache counters per thread (default: 0)\n");
+        printf("  -K <0|1>       Kernel counter deltas (snmp, netstat, softnet, vmstat) (default: 0)\n");
+        printf("  -Q <0|1>       Sample the receive queue depth (SIOCINQ) (default: 0)\n");
+        printf("  -A <where>     Pin client threads: core, atom, any or a CPU list\n");
         printf("  -h             Show this help\n");
     }
 }
@@ -0,0 +1,334 @@
+/*
+ * MT25033_Part_A_Hybrid.h
+ * Core-type (P-core / E-core) placement and per-core-type counters
+ * Roll Number: MT25033
+ *
+ * Hybrid Intel parts expose one PMU per core type in sysfs:
+ * /sys/devices/cpu_core (performance cores) and /sys/devices/cpu_atom
+ * (efficiency cores), each with a `cpus` list and a perf `type`. Other
+ * machines have a single type, reported as "cpu" and covering every CPU
+ * the process may use.
+ *
+ * With -A <placement> every server connection thread and every client
+ * thread is pinned before it starts its window:
+ *   core / p   the performance cores
+ *   atom / e   the efficiency cores
+ *   any        no pinning, but still counted per core type
+ *   <cpulist>  e.g. 0-3,8
+ * The thread also counts cycles and instructions once per core type, each
+ * event bound to that type's PMU (PERF_TYPE_HARDWARE with the PMU type in
+ * the upper config bits). Such an event only runs while the thread is on
+ * a core of that type, so its time_running is the thread's run time there.
+ * The send and receive loops also report every transfer with
+ * core_account(), which charges the bytes to the type of the CPU the
+ * thread is on (sched_getcpu()). Each side prints the run-time share, IPC,
+ * cycles per byte and throughput while on each type, followed by
+ *   CORECSV: <who>,<placement>,<type>,<run_share>,<cycles>,<instructions>,<ipc>,<cycles_per_byte>,<bytes>,<gbps>
+ * where cycles_per_byte and gbps use that type's own bytes and run time.
+ * Counter fields are empty where the PMU or perf_event_paranoid does not
+ * allow counting.
+ */
+
+#ifndef MT25033_PART_A_HYBRID_H
+#define MT25033_PART_A_HYBRID_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE                /* cpu_set_t, pthread_setaffinity_np() */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#ifndef HYBRID_SYSFS
+#define HYBRID_SYSFS "/sys/devices"
+#endif
+
+#define CORE_TYPES_MAX 2
+#define CORE_PMU_SHIFT 32          /* PERF_PMU_TYPE_SHIFT: PMU type in config */
+
+enum { CORE_CYCLES, CORE_INSTRUCTIONS, CORE_EVENTS };
+
+typedef struct {
+    int ntypes;
+    char name[CORE_TYPES_MAX][8];  /* "core" / "atom", or "cpu" */
+    cpu_set_t cpus[CORE_TYPES_MAX];
+    uint32_t pmu_type[CORE_TYPES_MAX];  /* 0: plain PERF_TYPE_HARDWARE */
+} CoreTopology;
+
+/* Where a side's threads run (-A) */
+typedef struct {
+    int pin;
+    cpu_set_t cpus;
+    char label[32];
+} CorePlacement;
+
+/* Counts summed over threads, per core type */
+typedef struct {
+    unsigned long windows;         /* Thread windows that were counted */
+    int user_only;
+    double run_ns[CORE_TYPES_MAX];
+    double events[CORE_TYPES_MAX][CORE_EVENTS];
+    double bytes[CORE_TYPES_MAX];  /* Moved while on a core of the type */
+} CoreCounts;
+
+/* Open counters of one thread */
+typedef struct {
+    int fd[CORE_TYPES_MAX][CORE_EVENTS];
+    int user_only;
+    unsigned long bytes[CORE_TYPES_MAX];
+} CoreProbe;
+
+static CoreTopology core_topo;
+static pthread_once_t core_topo_once = PTHREAD_ONCE_INIT;
+static __thread CoreProbe *core_probe_self;  /* The calling thread's open probe */
+
+/* Parse a sysfs CPU list ("0-7,12,14-15") */
+static inline int core_parse_cpulist(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p && *p != '\n') {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p || lo < 0) return -1;
+        if (*end == '-') {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+            if (end == p || hi < lo) return -1;
+        }
+        for (long c = lo; c <= hi && c < CPU_SETSIZE; c++) CPU_SET(c, set);
+        p = end;
+        if (*p == ',') p++;
+        else if (*p && *p != '\n') return -1;
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+static inline void core_topo_detect(void) {
+    static const char *pmus[CORE_TYPES_MAX][2] = { { "cpu_core", "core" }, { "cpu_atom", "atom" } };
+    CoreTopology *t = &core_topo;
+    memset(t, 0, sizeof(*t));
+
+    for (int i = 0; i < CORE_TYPES_MAX; i++) {
+        char path[256], buf[256];
+        snprintf(path, sizeof(path), "%s/%s/cpus", HYBRID_SYSFS, pmus[i][0]);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        int ok = fgets(buf, sizeof(buf), f) && core_parse_cpulist(buf, &t->cpus[t->ntypes]) == 0;
+        fclose(f);
+        snprintf(path, sizeof(path), "%s/%s/type", HYBRID_SYSFS, pmus[i][0]);
+        f = fopen(path, "r");
+        unsigned type = 0;
+        if (f) {
+            if (fscanf(f, "%u", &type) != 1) type = 0;
+            fclose(f);
+        }
+        if (!ok || type == 0) continue;
+        snprintf(t->name[t->ntypes], sizeof(t->name[0]), "%s", pmus[i][1]);
+        t->pmu_type[t->ntypes] = type;
+        t->ntypes++;
+    }
+
+    if (t->ntypes == 0) {
+        /* Not hybrid: one type, every CPU this process may run on */
+        t->ntypes = 1;
+        snprintf(t->name[0], sizeof(t->name[0]), "cpu");
+        sched_getaffinity(0, sizeof(cpu_set_t), &t->cpus[0]);
+        t->pmu_type[0] = 0;
+    }
+}
+
+static inline const CoreTopology* core_topology(void) {
+    pthread_once(&core_topo_once, core_topo_detect);
+    return &core_topo;
+}
+
+/* "core", "atom" (or p / e), "any" or a CPU list; -1 if not on this machine */
+static inline int parse_core_placement(const char *spec, CorePlacement *p) {
+    const CoreTopology *t = core_topology();
+    memset(p, 0, sizeof(*p));
+    snprintf(p->label, sizeof(p->label), "%s", spec);
+
+    if (strcmp(spec, "any") == 0) {
+        return 0;
+    }
+    const char *type = strcmp(spec, "p") == 0 ? "core" : strcmp(spec, "e") == 0 ? "atom" : spec;
+    for (int i = 0; i < t->ntypes; i++) {
+        if (strcmp(type, t->name[i]) == 0) {
+            p->pin = 1;
+            p->cpus = t->cpus[i];
+            snprintf(p->label, sizeof(p->label), "%s", t->name[i]);
+            return 0;
+        }
+    }
+    if (strcmp(type, "core") == 0 || strcmp(type, "atom") == 0) {
+        return -1;                 /* Asked for a core type this CPU does not have */
+    }
+    if (core_parse_cpulist(spec, &p->cpus) < 0) {
+        return -1;
+    }
+    p->pin = 1;
+    return 0;
+}
+
+/* Banner line: the core types found and where this side's threads go */
+static inline void core_placement_print(const CorePlacement *p) {
+    const CoreTopology *t = core_topology();
+    printf("Core types:");
+    for (int i = 0; i < t->ntypes; i++) {
+        printf(" %s (%d CPUs)", t->name[i], CPU_COUNT(&t->cpus[i]));
+    }
+    printf(", placement: %s%s\n", p->label, p->pin ? "" : " (not pinned)");
+}
+
+/* Pin the calling thread; returns -1 (and leaves it unpinned) on failure */
+static inline int core_pin_self(const CorePlacement *p) {
+    if (!p || !p->pin) return 0;
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &p->cpus);
+    if (err != 0) {
+        errno = err;
+        perror("pthread_setaffinity_np");
+        return -1;
+    }
+    return 0;
+}
+
+static inline int core_perf_open(uint32_t pmu_type, uint64_t hw_event, int exclude_kernel) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = ((uint64_t)pmu_type << CORE_PMU_SHIFT) | hw_event;
+    attr.disabled = 1;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/*
+ * Open and start the per-core-type counters on the calling thread.
+ * Returns 0 if anything could be counted, -1 otherwise.
+ */
+static inline int core_probe_start(CoreProbe *p) {
+    static const uint64_t hw[CORE_EVENTS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS };
+    const CoreTopology *t = core_topology();
+    int any = 0;
+    memset(p, 0, sizeof(*p));
+
+    for (int i = 0; i < CORE_TYPES_MAX; i++) {
+        for (int e = 0; e < CORE_EVENTS; e++) {
+            p->fd[i][e] = -1;
+            if (i >= t->ntypes) continue;
+            p->fd[i][e] = core_perf_open(t->pmu_type[i], hw[e], p->user_only);
+            if (p->fd[i][e] < 0 && !p->user_only && (errno == EACCES || errno == EPERM)) {
+                p->user_only = 1;
+                p->fd[i][e] = core_perf_open(t->pmu_type[i], hw[e], 1);
+            }
+            if (p->fd[i][e] < 0) continue;
+            ioctl(p->fd[i][e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(p->fd[i][e], PERF_EVENT_IOC_ENABLE, 0);
+            any = 1;
+        }
+    }
+    if (any) core_probe_self = p;
+    return any ? 0 : -1;
+}
+
+/* Index of the core type cpu belongs to (-1 if none) */
+static inline int core_type_of(int cpu) {
+    const CoreTopology *t = &core_topo;
+    for (int i = 0; i < t->ntypes; i++) {
+        if (cpu >= 0 && CPU_ISSET(cpu, &t->cpus[i])) return i;
+    }
+    return -1;
+}
+
+/* Charge bytes the calling thread just moved to the core type it is on */
+static inline void core_account(size_t bytes) {
+    CoreProbe *p = core_probe_self;
+    if (!p) return;
+    int type = core_type_of(sched_getcpu());
+    if (type >= 0) p->bytes[type] += bytes;
+}
+
+/* Stop, read and close; counts (unscaled: time on that type is the point) go to out */
+static inline void core_probe_stop(CoreProbe *p, CoreCounts *out) {
+    int counted = 0;
+    for (int i = 0; i < CORE_TYPES_MAX; i++) {
+        for (int e = 0; e < CORE_EVENTS; e++) {
+            uint64_t v[3] = {0};
+            int fd = p->fd[i][e];
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, v, sizeof(v)) == (ssize_t)sizeof(v)) {
+                out->events[i][e] += v[0];
+                if (e == CORE_CYCLES) out->run_ns[i] += v[2];
+                counted = 1;
+            }
+            close(fd);
+            p->fd[i][e] = -1;
+        }
+        out->bytes[i] += p->bytes[i];
+    }
+    if (core_probe_self == p) core_probe_self = NULL;
+    if (counted) {
+        out->windows++;
+        out->user_only |= p->user_only;
+    }
+}
+
+static inline void core_counts_add(CoreCounts *dst, const CoreCounts *src) {
+    dst->windows += src->windows;
+    dst->user_only |= src->user_only;
+    for (int i = 0; i < CORE_TYPES_MAX; i++) {
+        dst->run_ns[i] += src->run_ns[i];
+        dst->bytes[i] += src->bytes[i];
+        for (int e = 0; e < CORE_EVENTS; e++) dst->events[i][e] += src->events[i][e];
+    }
+}
+
+/* Per-core-type summary and CORECSV lines (counter fields empty if not counted) */
+static inline void core_report(const char *who, const CorePlacement *p, const CoreCounts *c) {
+    const CoreTopology *t = core_topology();
+    double total_ns = 0;
+    for (int i = 0; i < t->ntypes; i++) total_ns += c->run_ns[i];
+
+    printf("Core types (%s, placement %s%s):", who, p->label,
+           c->user_only ? ", user space only" : "");
+    if (!c->windows) printf(" not counted");
+    for (int i = 0; c->windows && i < t->ntypes; i++) {
+        double cyc = c->events[i][CORE_CYCLES], ins = c->events[i][CORE_INSTRUCTIONS];
+        double bytes = c->bytes[i];
+        printf("%s %s %.1f%% of run time, %.2f IPC, %.3f cycles/B, %.2f Gbps", i ? ";" : "",
+               t->name[i], total_ns > 0 ? c->run_ns[i] * 100 / total_ns : 0.0,
+               cyc > 0 ? ins / cyc : 0.0, bytes > 0 ? cyc / bytes : 0.0,
+               c->run_ns[i] > 0 ? bytes * 8 / c->run_ns[i] : 0.0);
+    }
+    printf("\n");
+
+    for (int i = 0; i < t->ntypes; i++) {
+        printf("CORECSV: %s,%s,%s,", who, p->label, t->name[i]);
+        if (c->windows) {
+            double cyc = c->events[i][CORE_CYCLES], ins = c->events[i][CORE_INSTRUCTIONS];
+            double bytes = c->bytes[i];
+            printf("%.4f,%.0f,%.0f,%.3f,%.4f,%.0f,%.4f",
+                   total_ns > 0 ? c->run_ns[i] / total_ns : 0.0, cyc, ins,
+                   cyc > 0 ? ins / cyc : 0.0, bytes > 0 ? cyc / bytes : 0.0, bytes,
+                   c->run_ns[i] > 0 ? bytes * 8 / c->run_ns[i] : 0.0);
+        } else {
+            printf(",,,,,,");
+        }
+        printf("\n");
+    }
+}
+
+#endif /* MT25033_PART_A_HYBRID_H */
@@ -0,0 +1,639 @@
+/*
+ * MT25033_Part_A_Mux.h
+ * Multi-stream multiplexing over a single connection
+ * Roll Number: MT25033
+ *
+ * In multiplexed mode every connection carries several logical streams.
+ * Each stream repeatedly sends messages of its own size, cut into framed
+ * chunks. The sender picks which stream's chunk goes next with round-robin
+ * (one chunk per stream per turn) or weighted deficit round-robin (each
+ * turn adds weight * chunk bytes to the stream's deficit).
+ *
+ * Frame layout on the wire:
+ *   MuxFrameHeader (16 bytes) followed by `length` payload bytes
+ *
+ * The header carries the time the message's first chunk was scheduled, so
+ * the receiver can measure message latency including the time spent waiting
+ * behind other streams' chunks (head-of-line blocking). Sender and receiver
+ * must share CLOCK_MONOTONIC, which holds for network namespaces on one host.
+ *
+ * Open loop (-O <msgs/s>): messages are started on a fixed schedule instead
+ * of as fast as the socket takes them. Each stream gets an equal share of
+ * the rate, staggered so the streams do not start together. A message's
+ * header carries its scheduled start, not the time it was sent, so a
+ * sender that falls behind shows up as latency at the receiver rather than
+ * as a lower rate (no coordinated omission). Between messages the sender
+ * sleeps; paced streams take turns round-robin (-r drr is ignored), and
+ * Nagle is turned off so a message is not held back for an earlier ACK.
+ */
+
+#ifndef MT25033_PART_A_MUX_H
+#define MT25033_PART_A_MUX_H
+
+#include "MT25033_Part_A_Common.h"
+#include <sys/uio.h>
+#include <endian.h>
+
+#define MUX_MAX_STREAMS 16
+#define MUX_DEFAULT_CHUNK 16384
+#define MUX_FLAG_END 0x1           /* Last chunk of a message */
+#define MUX_HDR_RING 1024          /* Header slots kept alive for MSG_ZEROCOPY */
+
+typedef struct {
+    uint16_t stream_id;
+    uint16_t flags;
+    uint32_t length;               /* Payload bytes following the header */
+    uint64_t msg_start_ns;         /* When the message's first chunk was scheduled */
+} MuxFrameHeader;
+
+/* Stream layout and scheduler, parsed from the server's -m/-k/-r options */
+typedef struct MuxConfig {
+    int count;
+    size_t sizes[MUX_MAX_STREAMS];
+    unsigned weights[MUX_MAX_STREAMS];
+    size_t chunk;
+    int drr;                       /* 0 = round-robin, 1 = weighted DRR */
+    double rate;                   /* Open loop: messages/s per connection (0 = off) */
+} MuxConfig;
+
+/* Sender-side state for one stream */
+typedef struct {
+    size_t msg_size;
+    size_t field_size;
+    unsigned weight;
+    Message *msg;
+    SerializedMessage *smsg;       /* Contiguous copy for the send() engine */
+    size_t offset;                 /* Bytes of the current message already sent */
+    long deficit;
+    int in_turn;
+    uint64_t msg_start_ns;
+    uint64_t next_ns;              /* Open loop: scheduled start of the next message */
+    uint64_t interval_ns;          /* Open loop: time between this stream's messages */
+    unsigned long bytes;
+    unsigned long messages;
+} MuxStream;
+
+typedef struct {
+    const MuxConfig *cfg;
+    MuxStream streams[MUX_MAX_STREAMS];
+    int cursor;
+    uint64_t max_lag_ns;           /* Open loop: latest start behind schedule */
+    unsigned long late;            /* Open loop: messages started a full interval late */
+} MuxSender;
+
+/* Receiver-side totals for one stream (summed over all client threads) */
+typedef struct {
+    unsigned long bytes;
+    unsigned long chunks;
+    unsigned long messages;
+    double latency_sum_us;
+    double latency_max_us;
+} MuxStreamStats;
+
+static pthread_mutex_t mux_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static MuxStreamStats mux_totals[MUX_MAX_STREAMS];
+
+static inline uint64_t mux_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Parse a stream spec: comma-separated message sizes, each with an optional
+ * DRR weight, e.g. "1024,65536:4". Sizes are rounded down to a multiple of
+ * NUM_FIELDS so every stream message still has 8 equal fields.
+ * Returns 0 on success, -1 on a malformed spec.
+ */
+static inline int parse_mux_spec(const char *spec, MuxConfig *cfg) {
+    cfg->count = 0;
+    const char *p = spec;
+    while (*p) {
+        if (cfg->count >= MUX_MAX_STREAMS) return -1;
+
+        char *end = NULL;
+        unsigned long size = strtoul(p, &end, 10);
+        unsigned long weight = 1;
+        if (end == p) return -1;
+        if (*end == ':') {
+            p = end + 1;
+            weight = strtoul(p, &end, 10);
+            if (end == p || weight == 0) return -1;
+        }
+        size -= size % NUM_FIELDS;
+        if (size == 0) return -1;
+
+        cfg->sizes[cfg->count] = size;
+        cfg->weights[cfg->count] = (unsigned)weight;
+        cfg->count++;
+
+        if (*end == ',') end++;
+        else if (*end != '\0') return -1;
+        p = end;
+    }
+    if (cfg->chunk == 0) cfg->chunk = MUX_DEFAULT_CHUNK;
+    return cfg->count > 0 ? 0 : -1;
+}
+
+/*
+ * Allocate one Message per stream. The send() engine also gets a serialized
+ * copy, since it sends from one contiguous buffer.
+ * Returns 0 on success, -1 on allocation failure.
+ */
+static inline int mux_sender_init(MuxSender *ms, const MuxConfig *cfg, int contiguous) {
+    memset(ms, 0, sizeof(*ms));
+    ms->cfg = cfg;
+    for (int i = 0; i < cfg->count; i++) {
+        MuxStream *st = &ms->streams[i];
+        st->msg_size = cfg->sizes[i];
+        st->field_size = cfg->sizes[i] / NUM_FIELDS;
+        st->weight = cfg->weights[i];
+        st->msg = create_message(st->field_size);
+        if (!st->msg) return -1;
+        if (contiguous) {
+            st->smsg = serialize_message(st->msg, st->field_size);
+            if (!st->smsg) return -1;
+        }
+    }
+    if (cfg->rate > 0) {
+        uint64_t now = mux_now_ns();
+        for (int i = 0; i < cfg->count; i++) {
+            MuxStream *st = &ms->streams[i];
+            st->interval_ns = (uint64_t)(1e9 * cfg->count / cfg->rate);
+            if (st->interval_ns == 0) st->interval_ns = 1;
+            st->next_ns = now + st->interval_ns * i / cfg->count;
+        }
+    }
+    return 0;
+}
+
+/* zc (may be NULL) holds the messages back until their zero-copy sends complete */
+static inline void mux_sender_free(MuxSender *ms, ZcTracker *zc) {
+    for (int i = 0; i < MUX_MAX_STREAMS; i++) {
+        free_serialized_message(ms->streams[i].smsg);
+        zc_free_message(zc, ms->streams[i].msg);
+    }
+}
+
+/*
+ * Pick the stream that sends the next chunk and the chunk length.
+ * Round-robin gives every stream one chunk per turn. DRR adds
+ * weight * chunk to a stream's deficit when its turn starts and lets it
+ * send while the deficit covers the next chunk.
+ */
+static inline int mux_next(MuxSender *ms, size_t *len) {
+    const MuxConfig *cfg = ms->cfg;
+    for (;;) {
+        MuxStream *st = &ms->streams[ms->cursor];
+        size_t remaining = st->msg_size - st->offset;
+        size_t n = remaining < cfg->chunk ? remaining : cfg->chunk;
+        int idx = ms->cursor;
+
+        if (!cfg->drr) {
+            ms->cursor = (ms->cursor + 1) % cfg->count;
+            *len = n;
+            return idx;
+        }
+
+        if (!st->in_turn) {
+            st->deficit += (long)(cfg->chunk * st->weight);
+            st->in_turn = 1;
+        }
+        if (st->deficit >= (long)n) {
+            st->deficit -= (long)n;
+            *len = n;
+            return idx;
+        }
+        st->in_turn = 0;
+        ms->cursor = (ms->cursor + 1) % cfg->count;
+    }
+}
+
+/*
+ * Open-loop variant of mux_next(): streams in the middle of a message, and
+ * streams whose next message is due, take turns round-robin. Returns -1
+ * when none may send and sets *wake to the next scheduled start.
+ */
+static inline int mux_next_paced(MuxSender *ms, uint64_t now, size_t *len, uint64_t *wake) {
+    const MuxConfig *cfg = ms->cfg;
+    *wake = UINT64_MAX;
+    for (int k = 0; k < cfg->count; k++) {
+        int idx = (ms->cursor + k) % cfg->count;
+        MuxStream *st = &ms->streams[idx];
+        if (st->offset == 0 && st->next_ns > now) {
+            if (st->next_ns < *wake) *wake = st->next_ns;
+            continue;
+        }
+        size_t remaining = st->msg_size - st->offset;
+        *len = remaining < cfg->chunk ? remaining : cfg->chunk;
+        ms->cursor = (idx + 1) % cfg->count;
+        return idx;
+    }
+    return -1;
+}
+
+/*
+ * Sleep until the next scheduled start: in run_wait() while it is far off,
+ * so a stop still wakes us, and with clock_nanosleep() for the last 2 ms.
+ * Returns -1 once the run is stopping or the window has closed.
+ */
+static inline int mux_pace_wait(uint64_t wake, const RunWindow *w) {
+    uint64_t now = mux_now_ns();
+    if (wake <= now) return 0;
+    if (wake - now > 2000000) {
+        return run_wait(-1, 0, w, (int)((wake - now) / 1000000) - 1) < 0 ? -1 : 0;
+    }
+    struct timespec ts = { .tv_sec = (time_t)(wake / 1000000000ULL),
+                           .tv_nsec = (long)(wake % 1000000000ULL) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        if (!run_active()) return -1;
+    }
+    return window_live(w) ? 0 : -1;
+}
+
+/* Fill the frame header for the chosen chunk, starting a new message if needed */
+static inline void mux_fill_header(MuxSender *ms, int idx, size_t len, MuxFrameHeader *hdr) {
+    MuxStream *st = &ms->streams[idx];
+    if (st->offset == 0 && st->interval_ns) {
+        /* Open loop: latency counts from the scheduled start */
+        uint64_t now = mux_now_ns();
+        uint64_t lag = now > st->next_ns ? now - st->next_ns : 0;
+        if (lag > ms->max_lag_ns) ms->max_lag_ns = lag;
+        if (lag >= st->interval_ns) ms->late++;
+        st->msg_start_ns = st->next_ns;
+        st->next_ns += st->interval_ns;
+    } else if (st->offset == 0) {
+        st->msg_start_ns = mux_now_ns();
+    }
+    hdr->stream_id = htons((uint16_t)idx);
+    hdr->flags = htons(st->offset + len == st->msg_size ? MUX_FLAG_END : 0);
+    hdr->length = htonl((uint32_t)len);
+    hdr->msg_start_ns = htobe64(st->msg_start_ns);
+}
+
+/* Record a chunk that was fully sent */
+static inline void mux_advance(MuxSender *ms, int idx, size_t len) {
+    MuxStream *st = &ms->streams[idx];
+    st->offset += len;
+    st->bytes += len;
+    if (st->offset == st->msg_size) {
+        st->offset = 0;
+        st->messages++;
+    }
+}
+
+/*
+ * Point iov entries at the chunk's payload inside the stream's 8 heap
+ * fields. Returns the number of entries used.
+ */
+static inline int mux_payload_iov(MuxStream *st, size_t len, struct iovec *iov) {
+    char *fields[NUM_FIELDS] = {
+        st->msg->field1, st->msg->field2, st->msg->field3, st->msg->field4,
+        st->msg->field5, st->msg->field6, st->msg->field7, st->msg->field8
+    };
+    size_t pos = st->offset;
+    int n = 0;
+    while (len > 0) {
+        size_t f = pos / st->field_size;
+        size_t off = pos % st->field_size;
+        size_t take = st->field_size - off;
+        if (take > len) take = len;
+        iov[n].iov_base = fields[f] + off;
+        iov[n].iov_len = take;
+        n++;
+        pos += take;
+        len -= take;
+    }
+    return n;
+}
+
+/*
+ * sendmsg() that finishes partial writes, so frames are only cut when the
+ * run ends. Sends never block: a full socket is waited out in run_wait(),
+ * which returns at shutdown or the end of w. Like the plain zero-copy loop,
+ * a MSG_ZEROCOPY send that fails with ENOBUFS or EINVAL is retried as a
+ * regular sendmsg(). Each zero-copy sendmsg() is recorded in zc so its
+ * completion can be reaped.
+ * Returns total bytes sent (short if the run ended mid-frame), or -1 with
+ * errno set.
+ */
+static inline ssize_t mux_sendmsg_all(int fd, struct msghdr *mh, int flags, ZcTracker *zc,
+                                      const RunWindow *w) {
+    ssize_t total = 0;
+    for (;;) {
+        ssize_t sent = sendmsg(fd, mh, flags | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (zc) zc_reap(fd, zc, 0);
+                if (run_wait(fd, POLLOUT, w, -1) < 0) return total;
+                continue;
+            }
+            if ((flags & MSG_ZEROCOPY) && (errno == ENOBUFS || errno == EINVAL)) {
+                flags &= ~MSG_ZEROCOPY;
+                continue;
+            }
+            return -1;
+        }
+        if ((flags & MSG_ZEROCOPY) && zc) {
+            zc_track(zc, sent);
+        }
+        total += sent;
+
+        /* Drop fully sent entries and trim the first partial one */
+        while (mh->msg_iovlen > 0 && (size_t)sent >= mh->msg_iov[0].iov_len) {
+            sent -= mh->msg_iov[0].iov_len;
+            mh->msg_iov++;
+            mh->msg_iovlen--;
+        }
+        if (mh->msg_iovlen == 0) return total;
+        mh->msg_iov[0].iov_base = (char*)mh->msg_iov[0].iov_base + sent;
+        mh->msg_iov[0].iov_len -= sent;
+    }
+}
+
+/*
+ * Multiplexed send loop for one connection.
+ *
+ * contiguous = 1 (send() engine): header and payload are copied into one
+ *   staging buffer and sent with send(), like the two-copy path.
+ * contiguous = 0 (sendmsg() engines): header and payload slices go out as
+ *   an iovec, with send_flags (0 or MSG_ZEROCOPY). Headers come from a ring
+ *   so a zero-copy send never references a header that is rewritten while
+ *   still queued; unreaped completions are capped at the ring size. The
+ *   ring is released through the tracker, so it is not reused while a
+ *   send that timed out in the drain may still read it.
+ */
+static inline void mux_serve(ServerThreadArgs *args, int fd, const MuxConfig *cfg,
+                             int contiguous, int send_flags, const RunWindow *w) {
+    MuxSender ms;
+    memset(&ms, 0, sizeof(ms));
+    size_t ring_bytes = MUX_HDR_RING * sizeof(MuxFrameHeader);
+    MuxFrameHeader *hdr_ring = (MuxFrameHeader*)bufpool_get(ring_bytes);
+    char *staging = contiguous ? (char*)malloc(sizeof(MuxFrameHeader) + cfg->chunk) : NULL;
+    unsigned long hdr_slot = 0;
+    CreditState credit;
+    memset(&credit, 0, sizeof(credit));
+    ZcTracker zc;
+    int use_zc = (send_flags & MSG_ZEROCOPY) != 0;
+
+    if (zc_tracker_init(&zc) < 0 || !hdr_ring || (contiguous && !staging) ||
+        mux_sender_init(&ms, cfg, contiguous) < 0) {
+        perror("Failed to allocate multiplexed streams");
+        mux_sender_free(&ms, NULL);
+        zc_tracker_free(&zc);
+        bufpool_put(hdr_ring, ring_bytes);
+        free(staging);
+        return;
+    }
+    if (cfg->rate > 0) {
+        /* A paced message must not wait for the ACK of the one before it */
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    /*
+     * Credit mode: the client's first grant is its whole window, and a
+     * frame is only sent once credit covers all of it. A window below the
+     * largest frame would stall the connection for the whole run.
+     */
+    int serving = 1;
+    if (args->use_credit) {
+        size_t max_frame = 0;
+        for (int i = 0; i < cfg->count; i++) {
+            size_t len = ms.streams[i].msg_size < cfg->chunk ? ms.streams[i].msg_size : cfg->chunk;
+            if (sizeof(MuxFrameHeader) + len > max_frame) max_frame = sizeof(MuxFrameHeader) + len;
+        }
+        while (serving && credit.available == 0) {
+            serving = run_wait(fd, POLLIN, w, -1) >= 0 && credit_read(fd, &credit, 0) == 0;
+        }
+        if (serving && credit.available < max_frame) {
+            fprintf(stderr, "[Thread %d] Credit window of %lu bytes is below one frame "
+                    "(%zu bytes): raise the client's -c\n",
+                    args->thread_id, credit.available, max_frame);
+            serving = 0;
+        }
+    }
+
+    while (serving && window_live(w)) {
+        size_t len;
+        int idx;
+        if (cfg->rate > 0) {
+            uint64_t wake;
+            idx = mux_next_paced(&ms, mux_now_ns(), &len, &wake);
+            if (idx < 0) {
+                if (mux_pace_wait(wake, w) < 0) break;
+                continue;
+            }
+        } else {
+            idx = mux_next(&ms, &len);
+        }
+        MuxStream *st = &ms.streams[idx];
+        MuxFrameHeader *hdr = &hdr_ring[hdr_slot++ % MUX_HDR_RING];
+        size_t frame = sizeof(*hdr) + len;
+
+        if (args->use_credit &&
+            credit_acquire(fd, &credit, frame, w) < 0) {
+            break;
+        }
+
+        mux_fill_header(&ms, idx, len, hdr);
+
+        ssize_t sent;
+        if (contiguous) {
+            memcpy(staging, hdr, sizeof(*hdr));
+            memcpy(staging + sizeof(*hdr), st->smsg->data + st->offset, len);
+            struct iovec iov = { .iov_base = staging, .iov_len = frame };
+            struct msghdr mh = { .msg_iov = &iov, .msg_iovlen = 1 };
+            sent = mux_sendmsg_all(fd, &mh, 0, NULL, w);
+        } else {
+            struct iovec iov[NUM_FIELDS + 1];
+            iov[0].iov_base = hdr;
+            iov[0].iov_len = sizeof(*hdr);
+            int n = 1 + mux_payload_iov(st, len, &iov[1]);
+            struct msghdr mh = { .msg_iov = iov, .msg_iovlen = n };
+            sent = mux_sendmsg_all(fd, &mh, send_flags, &zc, w);
+            if (use_zc) {
+                zc_throttle(fd, &zc, MUX_HDR_RING, w);
+            }
+        }
+
+        if (sent < 0) {
+            if (errno == EPIPE || errno == ECONNRESET) {
+                printf("[Thread %d] Client disconnected\n", args->thread_id);
+            } else {
+                perror("multiplexed send failed");
+            }
+            break;
+        }
+
+        args->bytes_sent += sent;
+        core_account(sent);
+        if (args->use_credit) {
+            credit_consume(&credit, sent);
+        }
+        if ((size_t)sent < frame) {
+            break;                 /* Run ended mid-frame */
+        }
+        mux_advance(&ms, idx, len);
+    }
+
+    args->credit_stalls = credit.stalls;
+    for (int i = 0; i < cfg->count; i++) {
+        args->messages_sent += ms.streams[i].messages;
+        printf("[Thread %d] Stream %d (%zu bytes, weight %u): %lu messages, %lu payload bytes\n",
+               args->thread_id, i, ms.streams[i].msg_size, ms.streams[i].weight,
+               ms.streams[i].messages, ms.streams[i].bytes);
+    }
+    if (cfg->rate > 0) {
+        unsigned long started = 0;
+        for (int i = 0; i < cfg->count; i++) started += ms.streams[i].messages;
+        printf("[Thread %d] Open loop at %.0f msg/s: %lu messages, %lu started an interval late, "
+               "max lag %.1f µs\n", args->thread_id, cfg->rate, started, ms.late,
+               ms.max_lag_ns / 1000.0);
+    }
+    if (use_zc) {
+        zc_drain(fd, &zc, 1000);
+        printf("[Thread %d] Zero-copy completions: %lu (%lu copied)\n",
+               args->thread_id, zc.completions, zc.copied);
+    }
+    if (args->use_credit) {
+        credit_drain(fd, &credit);
+    }
+
+    mux_sender_free(&ms, &zc);
+    zc_release(&zc, hdr_ring, ring_bytes);
+    zc_tracker_free(&zc);
+    free(staging);
+}
+
+/*
+ * Receive exactly len bytes (or discard them with MSG_TRUNC).
+ * Returns len, 0 if the peer closed, or -1 on error.
+ */
+static inline ssize_t mux_recv_full(int fd, void *buf, size_t len, int flags) {
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = recv(fd, buf ? (char*)buf + got : NULL, len - got, flags);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) return 0;
+        got += n;
+    }
+    return (ssize_t)got;
+}
+
+/*
+ * Multiplexed receive loop for one connection. Headers are always read
+ * normally; payloads are read into a buffer, or dropped in the kernel when
+ * payload_flags is MSG_TRUNC. Per-stream totals are added to mux_totals.
+ */
+static inline void mux_receive(ClientThreadArgs *args, int fd, int payload_flags,
+                               volatile int *running, double end_time,
+                               CreditGranter *granter) {
+    MuxStreamStats local[MUX_MAX_STREAMS];
+    memset(local, 0, sizeof(local));
+    size_t buf_size = MUX_DEFAULT_CHUNK;
+    char *buf = (payload_flags & MSG_TRUNC) ? NULL : (char*)bufpool_get(buf_size);
+
+    if (!(payload_flags & MSG_TRUNC) && !buf) {
+        perror("Failed to allocate receive buffer");
+        return;
+    }
+
+    while (*running && get_time_sec() < end_time) {
+        MuxFrameHeader hdr;
+
+        ssize_t n = mux_recv_full(fd, &hdr, sizeof(hdr), 0);
+        if (n <= 0) {
+            if (n < 0) perror("recv frame header failed");
+            else printf("[Thread %d] Server closed connection\n", args->thread_id);
+            break;
+        }
+
+        unsigned stream = ntohs(hdr.stream_id);
+        size_t len = ntohl(hdr.length);
+        if (stream >= MUX_MAX_STREAMS) {
+            fprintf(stderr, "[Thread %d] Bad stream id %u\n", args->thread_id, stream);
+            break;
+        }
+
+        if (buf && len > buf_size) {
+            char *bigger = (char*)bufpool_grow(buf, &buf_size, len);
+            if (!bigger) {
+                perror("Failed to grow receive buffer");
+                break;
+            }
+            buf = bigger;
+        }
+
+        n = mux_recv_full(fd, buf, len, payload_flags);
+        if (n <= 0) {
+            if (n < 0) perror("recv frame payload failed");
+            break;
+        }
+
+        MuxStreamStats *ss = &local[stream];
+        ss->bytes += len;
+        ss->chunks++;
+        if (ntohs(hdr.flags) & MUX_FLAG_END) {
+            double lat = (mux_now_ns() - be64toh(hdr.msg_start_ns)) / 1000.0;
+            ss->messages++;
+            ss->latency_sum_us += lat;
+            if (lat > ss->latency_max_us) ss->latency_max_us = lat;
+            args->messages_received++;
+            args->total_latency += lat;
+            lat_hist_add(&args->lat_hist, lat);
+        }
+
+        args->bytes_received += sizeof(hdr) + len;
+        core_account(sizeof(hdr) + len);
+
+        if (granter->window &&
+            credit_return(fd, granter, sizeof(hdr) + len) < 0) {
+            perror("credit grant failed");
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&mux_stats_mutex);
+    for (int i = 0; i < MUX_MAX_STREAMS; i++) {
+        mux_totals[i].bytes += local[i].bytes;
+        mux_totals[i].chunks += local[i].chunks;
+        mux_totals[i].messages += local[i].messages;
+        mux_totals[i].latency_sum_us += local[i].latency_sum_us;
+        if (local[i].latency_max_us > mux_totals[i].latency_max_us) {
+            mux_totals[i].latency_max_us = local[i].latency_max_us;
+        }
+    }
+    pthread_mutex_unlock(&mux_stats_mutex);
+
+    bufpool_put(buf, buf_size);
+}
+
+/*
+ * Print per-stream results. Message latency is measured from when the
+ * sender scheduled a message's first chunk to when its last chunk arrived,
+ * so it includes head-of-line blocking behind other streams.
+ */
+static inline void mux_report(const char *impl, double seconds) {
+    printf("\n=== Per-Stream Statistics ===\n");
+    for (int i = 0; i < MUX_MAX_STREAMS; i++) {
+        MuxStreamStats *ss = &mux_totals[i];
+        if (ss->chunks == 0) continue;
+
+        double avg = ss->messages ? ss->latency_sum_us / ss->messages : 0;
+        unsigned long msg_bytes = ss->messages ? ss->bytes / ss->messages : 0;
+        printf("Stream %d: ~%lu bytes/msg, %.4f Gbps, %lu messages, "
+               "avg latency %.2f µs, max latency %.2f µs\n",
+               i, msg_bytes, calc_throughput_gbps(ss->bytes, seconds),
+               ss->messages, avg, ss->latency_max_us);
+        printf("MUXCSV: %s,%d,%lu,%.4f,%lu,%.2f,%.2f\n",
+               impl, i, msg_bytes, calc_throughput_gbps(ss->bytes, seconds),
+               ss->messages, avg, ss->latency_max_us);
+    }
+}
+
+#endif /* MT25033_PART_A_MUX_H */
@@ -0,0 +1,301 @@
+/*
+ * MT25033_Part_A_Qdepth.h
+ * Send-queue-aware adaptive batching (SIOCOUTQ / SIOCOUTQNSD / SIOCINQ)
+ * Roll Number: MT25033
+ *
+ * The plain send loops hand the kernel one message per call and let the
+ * socket buffer decide how much is queued. In queue-depth mode (-Q <bytes>)
+ * the sender instead keeps the bytes the stack has not sent yet
+ * (SIOCOUTQNSD) near a target:
+ * - Before every call it reads the not-sent depth and sizes the batch to
+ *   refill the queue to the target: the rest of the current message plus
+ *   as many whole messages as fit, in a single sendmsg().
+ * - A batch cut short by QDEPTH_MAX_BATCH is sent with MSG_MORE, since the
+ *   next one follows at once. The last batch before waiting goes without
+ *   it so its tail is pushed.
+ * - TCP_NOTSENT_LOWAT is set to the target, so a full queue is waited out
+ *   in run_wait() until the depth falls below it.
+ * A deep target keeps the link busy, and a shallow one bounds queueing
+ * latency and, for MSG_ZEROCOPY, the pages pinned by unsent data.
+ *
+ * Both sides record a time series of queue depth, sampled at most every
+ * QDEPTH_INTERVAL_MS. When the buffer fills, every other sample is dropped
+ * and the interval doubles, so a series always covers the whole run. Each
+ * sample is printed as
+ *   QDEPTH: <side>,<thread>,<t_ms>,<outq>,<notsent>,<inq>,<batch>
+ * The server records outq (SIOCOUTQ: unsent + unacked), notsent
+ * (SIOCOUTQNSD) and the messages in its last batch. The client (-Q 1)
+ * records inq (SIOCINQ: received, not yet read). Fields a side does not
+ * see are left empty.
+ */
+
+#ifndef MT25033_PART_A_QDEPTH_H
+#define MT25033_PART_A_QDEPTH_H
+
+#include "MT25033_Part_A_Common.h"
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/sockios.h>
+
+#ifndef TCP_NOTSENT_LOWAT
+#define TCP_NOTSENT_LOWAT 25
+#endif
+
+#define QDEPTH_MAX_BATCH 64        /* Messages per sendmsg() */
+#define QDEPTH_MAX_IOV 1024        /* UIO_MAXIOV */
+#define QDEPTH_SAMPLES 1024
+#define QDEPTH_INTERVAL_MS 10
+
+typedef struct {
+    uint32_t t_ms;                 /* Since the series started */
+    int32_t outq;                  /* -1 = not recorded by this side */
+    int32_t notsent;
+    int32_t inq;
+    uint32_t batch;
+} QdepthSample;
+
+typedef struct QdepthSeries {
+    QdepthSample *s;
+    int n;
+    uint64_t start_ns;
+    uint64_t next_ns;
+    uint64_t interval_ns;
+} QdepthSeries;
+
+static inline int qdepth_series_init(QdepthSeries *q) {
+    memset(q, 0, sizeof(*q));
+    q->s = (QdepthSample*)malloc(QDEPTH_SAMPLES * sizeof(QdepthSample));
+    q->start_ns = q->next_ns = get_time_ns();
+    q->interval_ns = QDEPTH_INTERVAL_MS * 1000000ULL;
+    return q->s ? 0 : -1;
+}
+
+static inline void qdepth_series_free(QdepthSeries *q) {
+    free(q->s);
+    q->s = NULL;
+    q->n = 0;
+}
+
+/* Whether a sample is due (cheap enough to call every iteration) */
+static inline int qdepth_due(const QdepthSeries *q, uint64_t now) {
+    return q->s && now >= q->next_ns;
+}
+
+static inline void qdepth_record(QdepthSeries *q, uint64_t now, int outq, int notsent,
+                                 int inq, unsigned batch) {
+    if (!qdepth_due(q, now)) return;
+    if (q->n == QDEPTH_SAMPLES) {
+        /* Full: keep every other sample and halve the sampling rate */
+        for (int i = 0; i < QDEPTH_SAMPLES / 2; i++) q->s[i] = q->s[2 * i];
+        q->n = QDEPTH_SAMPLES / 2;
+        q->interval_ns *= 2;
+    }
+    QdepthSample *s = &q->s[q->n++];
+    s->t_ms = (uint32_t)((now - q->start_ns) / 1000000);
+    s->outq = outq;
+    s->notsent = notsent;
+    s->inq = inq;
+    s->batch = batch;
+    q->next_ns = now + q->interval_ns;
+}
+
+/* Print a summary line and one QDEPTH: line per sample */
+static inline void qdepth_print(const char *side, int thread_id, const QdepthSeries *q) {
+    if (!q->s || q->n == 0) return;
+    const char *names[3] = { "outq", "notsent", "inq" };
+    char summary[256];
+    int len = 0;
+    for (int f = 0; f < 3; f++) {
+        double sum = 0;
+        long max = -1;
+        for (int i = 0; i < q->n; i++) {
+            int32_t v = f == 0 ? q->s[i].outq : f == 1 ? q->s[i].notsent : q->s[i].inq;
+            if (v < 0) continue;
+            sum += v;
+            if (v > max) max = v;
+        }
+        if (max < 0) continue;
+        len += snprintf(summary + len, sizeof(summary) - len, "%s%s avg %.0f max %ld",
+                        len ? ", " : "", names[f], sum / q->n, max);
+    }
+    printf("[Thread %d] Queue depth (%d samples): %s\n", thread_id, q->n, summary);
+
+    for (int i = 0; i < q->n; i++) {
+        const QdepthSample *s = &q->s[i];
+        printf("QDEPTH: %s,%d,%u,", side, thread_id, s->t_ms);
+        if (s->outq >= 0) printf("%d", s->outq);
+        printf(",");
+        if (s->notsent >= 0) printf("%d", s->notsent);
+        printf(",");
+        if (s->inq >= 0) printf("%d", s->inq);
+        printf(",");
+        if (s->batch) printf("%u", s->batch);
+        printf("\n");
+    }
+}
+
+/*
+ * Engine hook for qdepth_serve(): send the batch described by mh without
+ * blocking. flags is MSG_DONTWAIT, plus MSG_MORE when another batch follows.
+ */
+typedef ssize_t (*qdepth_send_fn)(int fd, struct msghdr *mh, int flags, void *ctx);
+
+/*
+ * Queue-depth send loop for one connection. msg_iov describes one message
+ * (one contiguous buffer, or one entry per field). before_wait (optional)
+ * runs before the loop waits for the queue to drain; A3 reaps zero-copy
+ * completions there, which would otherwise wake the wait at once.
+ */
+static inline void qdepth_serve(ServerThreadArgs *args, int fd, const struct iovec *msg_iov,
+                                int msg_iovcnt, qdepth_send_fn send_fn,
+                                void (*before_wait)(int fd, void *ctx), void *ctx,
+                                const RunWindow *w) {
+    size_t total_msg_size = 0;
+    for (int i = 0; i < msg_iovcnt; i++) total_msg_size += msg_iov[i].iov_len;
+    int target = args->qdepth > INT32_MAX ? INT32_MAX : (int)args->qdepth;
+    int max_batch = QDEPTH_MAX_IOV / msg_iovcnt - 1;
+    if (max_batch > QDEPTH_MAX_BATCH) max_batch = QDEPTH_MAX_BATCH;
+
+    QdepthSeries series;
+    int have_series = qdepth_series_init(&series) == 0;
+    struct iovec *iov = (struct iovec*)malloc((max_batch + 1) * msg_iovcnt * sizeof(struct iovec));
+    if (!iov || !have_series) {
+        perror("Failed to allocate queue-depth batching");
+        free(iov);
+        qdepth_series_free(&series);
+        return;
+    }
+    if (setsockopt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &target, sizeof(target)) < 0) {
+        perror("TCP_NOTSENT_LOWAT");
+    }
+
+    size_t offset = 0;             /* Bytes of the current message already sent */
+    unsigned long batches = 0, batched_msgs = 0, coalesced = 0, waits = 0;
+    unsigned batch = 0;
+
+    while (window_live(w)) {
+        int outq = 0, notsent = 0;
+        ioctl(fd, SIOCOUTQ, &outq);
+        ioctl(fd, SIOCOUTQNSD, &notsent);
+        qdepth_record(&series, get_time_ns(), outq, notsent, -1, batch);
+
+        if (notsent >= target) {
+            waits++;
+            if (before_wait) before_wait(fd, ctx);
+            if (run_wait(fd, POLLOUT, w, -1) < 0) break;
+            continue;
+        }
+
+        /* Rest of the current message, then whole messages up to the target */
+        size_t room = (size_t)(target - notsent);
+        size_t rest = total_msg_size - offset;
+        size_t extra = room > rest ? (room - rest) / total_msg_size : 0;
+        int more = extra > (size_t)max_batch;
+        if (more) extra = max_batch;
+
+        int n = 0;
+        size_t skip = offset;
+        for (int i = 0; i < msg_iovcnt; i++) {
+            if (skip >= msg_iov[i].iov_len) {
+                skip -= msg_iov[i].iov_len;
+                continue;
+            }
+            iov[n].iov_base = (char*)msg_iov[i].iov_base + skip;
+            iov[n].iov_len = msg_iov[i].iov_len - skip;
+            skip = 0;
+            n++;
+        }
+        for (size_t m = 0; m < extra; m++) {
+            memcpy(&iov[n], msg_iov, msg_iovcnt * sizeof(struct iovec));
+            n += msg_iovcnt;
+        }
+
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov = iov;
+        mh.msg_iovlen = n;
+        batch = extra + 1;
+
+        ssize_t sent = send_fn(fd, &mh, MSG_DONTWAIT | (more ? MSG_MORE : 0), ctx);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waits++;
+                if (before_wait) before_wait(fd, ctx);
+                if (run_wait(fd, POLLOUT, w, -1) < 0) break;
+                continue;
+            }
+            if (errno == EINTR) continue;
+            if (errno == EPIPE || errno == ECONNRESET) {
+                printf("[Thread %d] Client disconnected\n", args->thread_id);
+                break;
+            }
+            perror("sendmsg failed");
+            break;
+        }
+
+        batches++;
+        batched_msgs += batch;
+        if (more) coalesced++;
+        args->bytes_sent += sent;
+        core_account(sent);
+        offset += sent;
+        args->messages_sent += offset / total_msg_size;
+        offset %= total_msg_size;
+    }
+
+    printf("[Thread %d] Queue-depth batching: target %d, %lu batches of %.1f messages avg, "
+           "%lu with MSG_MORE, %lu waits\n", args->thread_id, target, batches,
+           batches ? (double)batched_msgs / batches : 0.0, coalesced, waits);
+    qdepth_print("server", args->thread_id, &series);
+
+    qdepth_series_free(&series);
+    free(iov);
+}
+
+/*
+ * Receiver side: one thread samples SIOCINQ of every client connection.
+ * Connection threads publish their socket in sock_fd once connected and
+ * withdraw it (-1) before closing, both under sock_lock. The sampler holds
+ * the same lock from reading sock_fd until its ioctl returns, so it never
+ * queries a descriptor that was closed (and perhaps reused) in between.
+ */
+static inline void qdepth_publish(ClientThreadArgs *a, int fd) {
+    pthread_mutex_lock(&a->sock_lock);
+    a->sock_fd = fd;
+    pthread_mutex_unlock(&a->sock_lock);
+}
+
+/* Withdraw the connection's socket from the sampler, then close it */
+static inline void qdepth_close(ClientThreadArgs *a, int fd) {
+    pthread_mutex_lock(&a->sock_lock);
+    a->sock_fd = -1;
+    pthread_mutex_unlock(&a->sock_lock);
+    close(fd);
+}
+
+typedef struct {
+    ClientThreadArgs *threads;
+    QdepthSeries *series;          /* One per thread */
+    int count;
+    volatile int stop;
+} QdepthSampler;
+
+static inline void* qdepth_sampler_thread(void *arg) {
+    QdepthSampler *qs = (QdepthSampler*)arg;
+    while (!qs->stop) {
+        uint64_t now = get_time_ns();
+        for (int i = 0; i < qs->count; i++) {
+            ClientThreadArgs *a = &qs->threads[i];
+            int inq = 0, ok = 0;
+            if (!qdepth_due(&qs->series[i], now)) continue;
+            pthread_mutex_lock(&a->sock_lock);
+            if (a->sock_fd >= 0) ok = ioctl(a->sock_fd, SIOCINQ, &inq) == 0;
+            pthread_mutex_unlock(&a->sock_lock);
+            if (ok) qdepth_record(&qs->series[i], now, -1, -1, inq, 0);
+        }
+        usleep(QDEPTH_INTERVAL_MS * 1000);
+    }
+    return NULL;
+}
+
+#endif /* MT25033_PART_A_QDEPTH_H */
@@ -0,0 +1,151 @@
+/*
+ * MT25033_Part_A_Steer.h
+ * CPU-affine connection steering for the servers (-C)
+ * Roll Number: MT25033
+ *
+ * The kernel runs a connection's receive path (softirq, ACK processing,
+ * the freeing of sent skbs) on the CPU its packets are steered to. When
+ * the connection thread runs elsewhere, the socket and its queues bounce
+ * between the two caches. -C places the connection thread on that CPU:
+ *
+ *   incoming  after accept, read SO_INCOMING_CPU and pin the connection
+ *             thread to it
+ *   cbpf      with -f N -R: the parent opens the N SO_REUSEPORT listeners
+ *             and attaches a classic BPF program that picks listener
+ *             (cpu % N); worker i is pinned to the CPUs that map to it, so
+ *             a connection is accepted by a worker on the CPU that handled
+ *             its SYN
+ *   random    pin each connection thread to a random allowed CPU; the
+ *             baseline the other two are compared against
+ *
+ * When a steered connection ends, SO_INCOMING_CPU is read again and
+ * compared with the CPU its thread is running on, so a flow whose packets
+ * moved to another CPU after accept does not count as local. The server
+ * prints the share of local connections as a STEERCSV line.
+ */
+
+#ifndef MT25033_PART_A_STEER_H
+#define MT25033_PART_A_STEER_H
+
+#include "MT25033_Part_A_Common.h"
+#include <linux/filter.h>
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+#define STEER_MAX_LISTENERS 256
+
+/* STEER_OFF is 0 so zeroed thread arguments mean "not steering" */
+enum { STEER_OFF, STEER_INCOMING, STEER_CBPF, STEER_RANDOM };
+
+static inline int parse_steer_mode(const char *s) {
+    if (strcmp(s, "incoming") == 0) return STEER_INCOMING;
+    if (strcmp(s, "cbpf") == 0) return STEER_CBPF;
+    if (strcmp(s, "random") == 0) return STEER_RANDOM;
+    return -1;
+}
+
+static inline const char* steer_name(int mode) {
+    switch (mode) {
+        case STEER_INCOMING: return "incoming";
+        case STEER_CBPF:     return "cbpf";
+        case STEER_RANDOM:   return "random";
+        default:             return "off";
+    }
+}
+
+/* CPU whose softirq last processed this socket's packets, -1 if unknown */
+static inline int steer_incoming_cpu(int fd) {
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0) return -1;
+    return cpu;
+}
+
+/* A random CPU from the process's affinity mask */
+static inline int steer_random_cpu(unsigned int *seed) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) < 0) return -1;
+    int count = CPU_COUNT(&set);
+    if (count == 0) return -1;
+    int pick = rand_r(seed) % count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set) && pick-- == 0) return cpu;
+    }
+    return -1;
+}
+
+/*
+ * Fill in the steering fields of a connection's thread arguments after
+ * accept. cbpf workers are already pinned as a whole, so their threads
+ * are not pinned again.
+ */
+static inline void steer_connection(ServerThreadArgs *a, int mode, unsigned int *seed) {
+    a->steer = mode;
+    a->incoming_cpu = steer_incoming_cpu(a->client_fd);
+    switch (mode) {
+        case STEER_INCOMING: a->steer_cpu = a->incoming_cpu; break;
+        case STEER_RANDOM:   a->steer_cpu = steer_random_cpu(seed); break;
+        default:             a->steer_cpu = -1; break;
+    }
+}
+
+/* The reuseport group picks listener (cpu % groups): ld cpu; mod groups; ret a */
+static inline int steer_attach_cbpf(int fd, int groups) {
+    struct sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)groups },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    struct sock_fprog prog = { sizeof(code) / sizeof(code[0]), code };
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+}
+
+/*
+ * Parent, before the fork: open one SO_REUSEPORT listener per worker in
+ * order (the program's return value indexes the group in that order) and
+ * attach the program to the group. Exits on failure.
+ */
+static inline void steer_open_listeners(int *fds, int workers, int port, int family) {
+    for (int i = 0; i < workers; i++) {
+        fds[i] = create_listen_socket(port, 1, family);
+    }
+    if (steer_attach_cbpf(fds[0], workers) < 0) {
+        perror("SO_ATTACH_REUSEPORT_CBPF failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+ * Worker i: keep listener i, close the others and pin the process to the
+ * CPUs the program sends to it. Workers with no such CPU (more workers than
+ * CPUs) stay unpinned; they receive no connections.
+ */
+static inline int steer_take_listener(int *fds, int workers, int id) {
+    for (int i = 0; i < workers; i++) {
+        if (i != id) close(fds[i]);
+    }
+
+    cpu_set_t allowed, set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (cpu % workers == id && CPU_ISSET(cpu, &allowed)) CPU_SET(cpu, &set);
+        }
+    }
+    if (CPU_COUNT(&set) > 0 && sched_setaffinity(0, sizeof(set), &set) < 0) {
+        perror("sched_setaffinity");
+    }
+    printf("[Worker %d] Steered CPUs: %d\n", id, CPU_COUNT(&set));
+    return fds[id];
+}
+
+static inline void steer_report(int mode, unsigned long steered, unsigned long on_incoming) {
+    printf("CPU steering (%s): %lu of %lu connections ran on their incoming CPU\n",
+           steer_name(mode), on_incoming, steered);
+    printf("STEERCSV: %s,%lu,%lu,%.4f\n", steer_name(mode), steered, on_incoming,
+           steered ? (double)on_incoming / steered : 0.0);
+}
+
+#endif /* MT25033_PART_A_STEER_H */
@@ -0,0 +1,539 @@
+/*
+ * MT25033_Part_A_Stripe.h
+ * Striping one logical stream over several connections
+ * Roll Number: MT25033
+ *
+ * A single connection is sent by one server thread, so one stream's
+ * throughput is capped by one core's send path. In striped mode a client
+ * thread opens K connections (-G K on the client, -G on the server), each
+ * optionally to a different address so they can use separate veth pairs.
+ * The server threads of the K connections share one sequence counter:
+ * each takes the next chunk number, sends that chunk of the message and
+ * takes another, so the links share the stream in proportion to how fast
+ * each one drains.
+ *
+ * Frame layout on the wire:
+ *   StripeHeader (24 bytes) followed by `length` payload bytes
+ *
+ * Sequence number seq is chunk seq % per_msg of message seq / per_msg,
+ * where per_msg is the message size over the chunk size (-k). The client
+ * reads every connection in its own thread into a ring of STRIPE_SLOTS
+ * chunk slots and delivers chunks in sequence order. A chunk that arrives
+ * STRIPE_SLOTS or more ahead of the next undelivered one waits until the
+ * ring catches up, which stops reading that connection and so backs its
+ * sender off through TCP flow control.
+ *
+ * Message latency runs from when the sender took the message's first chunk
+ * to when its last chunk was delivered in order, so it includes the time a
+ * chunk waited for an earlier one on a slower link. As with the mux frames,
+ * sender and receiver must share CLOCK_MONOTONIC.
+ */
+
+#ifndef MT25033_PART_A_STRIPE_H
+#define MT25033_PART_A_STRIPE_H
+
+#include "MT25033_Part_A_Mux.h"
+
+#define STRIPE_MAGIC 0x53545250u   /* "STRP" */
+#define STRIPE_MAX_LINKS 16
+#define STRIPE_MAX_GROUPS 64       /* Striped streams served at once */
+#define STRIPE_DEFAULT_CHUNK 65536
+#define STRIPE_MAX_CHUNK (64UL << 20)
+#define STRIPE_SLOTS 256           /* Reassembly ring: chunks delivered out of order */
+#define STRIPE_FLAG_START 0x1      /* First chunk of a message */
+#define STRIPE_FLAG_END 0x2        /* Last chunk of a message */
+
+/* Sent by the client on every connection of a stripe before any data */
+typedef struct {
+    uint32_t magic;
+    uint16_t index;                /* This connection's place in the stripe */
+    uint16_t count;                /* K */
+    uint64_t stripe_id;
+} StripeHello;
+
+typedef struct {
+    uint64_t seq;
+    uint64_t sent_ns;              /* When the sender took this chunk */
+    uint32_t length;               /* Payload bytes following the header */
+    uint32_t flags;
+} StripeHeader;
+
+/*
+ * Server side: connections with the same stripe_id share next_seq.
+ * Slots are reused once the last connection of a stripe has left.
+ */
+typedef struct {
+    uint64_t id;
+    int refs;
+    uint64_t next_seq;
+} StripeGroup;
+
+static pthread_mutex_t stripe_mutex = PTHREAD_MUTEX_INITIALIZER;
+static StripeGroup stripe_groups[STRIPE_MAX_GROUPS];
+
+/* Receiver-side totals (summed over all client threads) */
+typedef struct {
+    int links;
+    unsigned long chunks;
+    unsigned long out_of_order;    /* Chunks that arrived before an earlier one */
+    unsigned long max_reorder;     /* Furthest a chunk arrived ahead of the next in order */
+    unsigned long window_waits;    /* Times a link waited for ring space */
+} StripeStats;
+
+static StripeStats stripe_totals;
+
+static inline StripeGroup *stripe_join(uint64_t id) {
+    StripeGroup *g = NULL;
+    pthread_mutex_lock(&stripe_mutex);
+    for (int i = 0; i < STRIPE_MAX_GROUPS && !g; i++) {
+        if (stripe_groups[i].refs > 0 && stripe_groups[i].id == id) g = &stripe_groups[i];
+    }
+    for (int i = 0; i < STRIPE_MAX_GROUPS && !g; i++) {
+        if (stripe_groups[i].refs == 0) {
+            g = &stripe_groups[i];
+            g->id = id;
+            g->next_seq = 0;
+        }
+    }
+    if (g) g->refs++;
+    pthread_mutex_unlock(&stripe_mutex);
+    return g;
+}
+
+static inline void stripe_leave(StripeGroup *g) {
+    pthread_mutex_lock(&stripe_mutex);
+    g->refs--;
+    pthread_mutex_unlock(&stripe_mutex);
+}
+
+/*
+ * Pick entry j (modulo the count) of a comma-separated address list into
+ * buf. Returns buf, or NULL if the entry does not fit.
+ */
+static inline const char *stripe_ip(const char *list, int j, char *buf, size_t n) {
+    int count = 1;
+    for (const char *p = list; *p; p++) {
+        if (*p == ',') count++;
+    }
+    const char *p = list;
+    for (int skip = j % count; skip > 0; skip--) {
+        p = strchr(p, ',') + 1;
+    }
+    size_t len = strcspn(p, ",");
+    if (len == 0 || len >= n) return NULL;
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return buf;
+}
+
+/*
+ * Read the client's hello, waiting at most RUN_CONNECT_GRACE seconds in
+ * all and never past the window, so a client that sends part of it (or
+ * nothing) cannot hold the thread. Returns 0, or -1 on timeout or close.
+ */
+static inline int stripe_read_hello(int fd, StripeHello *hello, const RunWindow *w) {
+    double deadline = get_time_sec() + RUN_CONNECT_GRACE;
+    size_t got = 0;
+    while (got < sizeof(*hello)) {
+        int left_ms = (int)((deadline - get_time_sec()) * 1000);
+        if (left_ms <= 0 || run_wait(fd, POLLIN, w, left_ms) < 0) return -1;
+        ssize_t n = recv(fd, (char*)hello + got, sizeof(*hello) - got, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+            return -1;
+        }
+        if (n == 0) return -1;
+        got += n;
+    }
+    return 0;
+}
+
+/*
+ * Striped send loop for one connection: read the client's hello, join its
+ * stripe, then send whichever chunk is next in the shared sequence until
+ * the window ends.
+ *
+ * contiguous = 1 (send() engine): the payload comes from the serialized
+ *   copy of the message, so every chunk is one slice of one buffer.
+ * contiguous = 0 (sendmsg() engines): the payload is gathered from the 8
+ *   heap fields, with send_flags (0 or MSG_ZEROCOPY). Headers come from a
+ *   ring, as in mux_serve(), so a queued zero-copy send never references a
+ *   rewritten header, and the ring goes back through the tracker.
+ */
+static inline void stripe_serve(ServerThreadArgs *args, int fd, int contiguous,
+                                int send_flags, const RunWindow *w) {
+    size_t chunk = args->stripe_chunk;
+    StripeHello hello;
+
+    if (stripe_read_hello(fd, &hello, w) < 0 || ntohl(hello.magic) != STRIPE_MAGIC) {
+        fprintf(stderr, "[Thread %d] No stripe hello from client (started without -G?)\n",
+                args->thread_id);
+        return;
+    }
+    uint64_t id = be64toh(hello.stripe_id);
+    StripeGroup *g = stripe_join(id);
+    if (!g) {
+        fprintf(stderr, "[Thread %d] More than %d striped streams\n",
+                args->thread_id, STRIPE_MAX_GROUPS);
+        return;
+    }
+
+    MuxStream st;
+    memset(&st, 0, sizeof(st));
+    st.msg_size = args->msg_size - args->msg_size % NUM_FIELDS;
+    st.field_size = st.msg_size / NUM_FIELDS;
+    st.msg = create_message(st.field_size);
+    st.smsg = (contiguous && st.msg) ? serialize_message(st.msg, st.field_size) : NULL;
+    size_t ring_bytes = MUX_HDR_RING * sizeof(StripeHeader);
+    StripeHeader *hdr_ring = (StripeHeader*)bufpool_get(ring_bytes);
+    unsigned long hdr_slot = 0;
+    ZcTracker zc;
+    int use_zc = (send_flags & MSG_ZEROCOPY) != 0;
+
+    if (zc_tracker_init(&zc) < 0 || !hdr_ring || !st.msg || (contiguous && !st.smsg)) {
+        perror("Failed to allocate striped message");
+        zc_tracker_free(&zc);
+        bufpool_put(hdr_ring, ring_bytes);
+        free_serialized_message(st.smsg);
+        free_message(st.msg);
+        stripe_leave(g);
+        return;
+    }
+
+    uint64_t per_msg = (st.msg_size + chunk - 1) / chunk;
+    unsigned long chunks = 0;
+    printf("[Thread %d] Stripe %016llx link %u/%u\n", args->thread_id,
+           (unsigned long long)id, ntohs(hello.index) + 1, ntohs(hello.count));
+
+    while (window_live(w)) {
+        uint64_t seq = __atomic_fetch_add(&g->next_seq, 1, __ATOMIC_RELAXED);
+        uint64_t part = seq % per_msg;
+        size_t len = st.msg_size - part * chunk;
+        if (len > chunk) len = chunk;
+        st.offset = part * chunk;
+
+        StripeHeader *hdr = &hdr_ring[hdr_slot++ % MUX_HDR_RING];
+        hdr->seq = htobe64(seq);
+        hdr->sent_ns = htobe64(mux_now_ns());
+        hdr->length = htonl((uint32_t)len);
+        hdr->flags = htonl((part == 0 ? STRIPE_FLAG_START : 0) |
+                           (part == per_msg - 1 ? STRIPE_FLAG_END : 0));
+        size_t frame = sizeof(*hdr) + len;
+
+        struct iovec iov[NUM_FIELDS + 1];
+        iov[0].iov_base = hdr;
+        iov[0].iov_len = sizeof(*hdr);
+        int n = 1;
+        if (contiguous) {
+            iov[1].iov_base = st.smsg->data + st.offset;
+            iov[1].iov_len = len;
+            n = 2;
+        } else {
+            n += mux_payload_iov(&st, len, &iov[1]);
+        }
+        struct msghdr mh = { .msg_iov = iov, .msg_iovlen = n };
+        ssize_t sent = mux_sendmsg_all(fd, &mh, send_flags, &zc, w);
+        if (use_zc) {
+            zc_throttle(fd, &zc, MUX_HDR_RING, w);
+        }
+
+        if (sent < 0) {
+            if (errno == EPIPE || errno == ECONNRESET) {
+                printf("[Thread %d] Client disconnected\n", args->thread_id);
+            } else {
+                perror("striped send failed");
+            }
+            break;
+        }
+        args->bytes_sent += sent;
+        core_account(sent);
+        if ((size_t)sent < frame) {
+            break;                 /* Run ended mid-frame */
+        }
+        chunks++;
+        if (part == per_msg - 1) {
+            args->messages_sent++;
+        }
+    }
+
+    printf("[Thread %d] Stripe link %u/%u: %lu chunks, %lu messages completed\n",
+           args->thread_id, ntohs(hello.index) + 1, ntohs(hello.count),
+           chunks, args->messages_sent);
+    if (use_zc) {
+        zc_drain(fd, &zc, 1000);
+        printf("[Thread %d] Zero-copy completions: %lu (%lu copied)\n",
+               args->thread_id, zc.completions, zc.copied);
+    }
+
+    stripe_leave(g);
+    free_serialized_message(st.smsg);
+    zc_free_message(&zc, st.msg);
+    zc_release(&zc, hdr_ring, ring_bytes);
+    zc_tracker_free(&zc);
+}
+
+/* Client side: one reassembly ring per striped stream, shared by its links */
+typedef struct {
+    uint64_t seq;
+    uint64_t sent_ns;
+    uint32_t length;
+    uint32_t flags;
+    int full;
+} StripeSlot;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t moved;          /* next advanced or a link stopped */
+    StripeSlot slots[STRIPE_SLOTS];
+    char *bufs[STRIPE_SLOTS];      /* Payload per slot (NULL with MSG_TRUNC) */
+    size_t buf_sizes[STRIPE_SLOTS];
+    uint64_t next;                 /* Next chunk to deliver */
+    uint64_t msg_start_ns;
+    int stopped;                   /* A link has ended: the stream can stall */
+    int payload_flags;
+    volatile int *running;
+    double end_time;
+    ClientThreadArgs *args;        /* Delivered totals, under lock */
+    StripeStats stats;
+} StripeReasm;
+
+typedef struct {
+    StripeReasm *r;
+    int fd;
+    int index;
+} StripeLink;
+
+static inline int stripe_live(const StripeReasm *r) {
+    return *r->running && !r->stopped && get_time_sec() < r->end_time;
+}
+
+/* Deliver every chunk that is now next in sequence (lock held) */
+static inline void stripe_deliver(StripeReasm *r) {
+    ClientThreadArgs *args = r->args;
+    int moved = 0;
+    for (;;) {
+        StripeSlot *s = &r->slots[r->next % STRIPE_SLOTS];
+        if (!s->full || s->seq != r->next) break;
+        if (s->flags & STRIPE_FLAG_START) {
+            r->msg_start_ns = s->sent_ns;
+        }
+        if (s->flags & STRIPE_FLAG_END) {
+            double lat = (mux_now_ns() - r->msg_start_ns) / 1000.0;
+            args->messages_received++;
+            args->total_latency += lat;
+            lat_hist_add(&args->lat_hist, lat);
+        }
+        args->bytes_received += sizeof(StripeHeader) + s->length;
+        core_account(sizeof(StripeHeader) + s->length);
+        s->full = 0;
+        r->next++;
+        moved = 1;
+    }
+    if (moved) pthread_cond_broadcast(&r->moved);
+}
+
+/* Receive loop for one link of a stripe */
+static inline void *stripe_link_loop(void *arg) {
+    StripeLink *link = (StripeLink*)arg;
+    StripeReasm *r = link->r;
+    int id = r->args->thread_id;
+
+    while (stripe_live(r)) {
+        StripeHeader hdr;
+        ssize_t n = mux_recv_full(link->fd, &hdr, sizeof(hdr), 0);
+        if (n <= 0) {
+            if (n < 0) perror("recv stripe header failed");
+            else printf("[Thread %d] Server closed link %d\n", id, link->index + 1);
+            break;
+        }
+        uint64_t seq = be64toh(hdr.seq);
+        size_t len = ntohl(hdr.length);
+        if (len > STRIPE_MAX_CHUNK) {
+            fprintf(stderr, "[Thread %d] Bad stripe frame on link %d (server started without -G?)\n",
+                    id, link->index + 1);
+            break;
+        }
+
+        /* Wait until the chunk falls inside the reassembly ring */
+        pthread_mutex_lock(&r->lock);
+        while (seq >= r->next + STRIPE_SLOTS && stripe_live(r)) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += 100000000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            r->stats.window_waits++;
+            pthread_cond_timedwait(&r->moved, &r->lock, &ts);
+        }
+        int fits = seq < r->next + STRIPE_SLOTS && seq >= r->next;
+        pthread_mutex_unlock(&r->lock);
+        if (!fits) break;
+
+        /* The slot is this link's until the chunk is marked full */
+        unsigned slot = seq % STRIPE_SLOTS;
+        char *buf = NULL;
+        if (!(r->payload_flags & MSG_TRUNC)) {
+            if (len > r->buf_sizes[slot]) {
+                char *bigger = (char*)bufpool_grow(r->bufs[slot], &r->buf_sizes[slot], len);
+                if (!bigger) {
+                    perror("Failed to grow reassembly slot");
+                    break;
+                }
+                r->bufs[slot] = bigger;
+            }
+            buf = r->bufs[slot];
+        }
+        n = mux_recv_full(link->fd, buf, len, r->payload_flags);
+        if (n <= 0) {
+            if (n < 0) perror("recv stripe payload failed");
+            break;
+        }
+
+        pthread_mutex_lock(&r->lock);
+        StripeSlot *s = &r->slots[slot];
+        s->seq = seq;
+        s->sent_ns = be64toh(hdr.sent_ns);
+        s->length = (uint32_t)len;
+        s->flags = ntohl(hdr.flags);
+        s->full = 1;
+        r->stats.chunks++;
+        if (seq != r->next) {
+            r->stats.out_of_order++;
+            if (seq - r->next > r->stats.max_reorder) r->stats.max_reorder = seq - r->next;
+        }
+        stripe_deliver(r);
+        pthread_mutex_unlock(&r->lock);
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->stopped = 1;
+    pthread_cond_broadcast(&r->moved);
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+/* Open one more connection of a stripe. Returns the socket or -1. */
+static inline int stripe_connect(const char *ip, int port, int priority) {
+    struct sockaddr_storage addr;
+    socklen_t addr_len = make_sockaddr(ip, port, &addr);
+    if (addr_len == 0) {
+        fprintf(stderr, "Invalid stripe address '%s'\n", ip);
+        return -1;
+    }
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket creation failed");
+        return -1;
+    }
+    set_socket_priority(fd, priority);
+    if (connect(fd, (struct sockaddr*)&addr, addr_len) < 0) {
+        perror("connect failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Striped receive for one client thread: fd0 is its first connection, the
+ * other args->stripe - 1 are opened here (to args->stripe_ips in turn).
+ * Every link gets a hello, then its own receive thread; this thread runs
+ * link 0. payload_flags is 0 or MSG_TRUNC (discard engine).
+ */
+static inline void stripe_receive(ClientThreadArgs *args, int fd0, int payload_flags,
+                                  volatile int *running, double end_time) {
+    int k = args->stripe;
+    StripeLink links[STRIPE_MAX_LINKS];
+    pthread_t tids[STRIPE_MAX_LINKS];
+    StripeReasm *r = (StripeReasm*)calloc(1, sizeof(StripeReasm));
+    if (!r) {
+        perror("Failed to allocate reassembly ring");
+        return;
+    }
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->moved, NULL);
+    r->payload_flags = payload_flags;
+    r->running = running;
+    r->end_time = end_time;
+    r->args = args;
+
+    uint64_t id = ((uint64_t)getpid() << 32) ^ ((uint64_t)args->thread_id << 24) ^
+                  (mux_now_ns() & 0xffffff);
+    int opened = 0;
+    for (int j = 0; j < k; j++) {
+        char ip[INET6_ADDRSTRLEN];
+        int fd = fd0;
+        if (j > 0) {
+            if (!stripe_ip(args->stripe_ips, j, ip, sizeof(ip)) ||
+                (fd = stripe_connect(ip, args->server_port, args->priority)) < 0) {
+                break;
+            }
+            printf("[Thread %d] Link %d connected to %s:%d\n",
+                   args->thread_id, j + 1, ip, args->server_port);
+        }
+        StripeHello hello = { htonl(STRIPE_MAGIC), htons((uint16_t)j), htons((uint16_t)k),
+                              htobe64(id) };
+        links[j].r = r;
+        links[j].fd = fd;
+        links[j].index = j;
+        opened++;
+        if (send(fd, &hello, sizeof(hello), 0) != (ssize_t)sizeof(hello)) {
+            perror("stripe hello failed");
+            break;
+        }
+    }
+
+    if (opened == k) {
+        int started = 1;
+        for (int j = 1; j < k; j++, started++) {
+            if (pthread_create(&tids[j], NULL, stripe_link_loop, &links[j]) != 0) {
+                perror("pthread_create failed");
+                r->stopped = 1;
+                break;
+            }
+        }
+        stripe_link_loop(&links[0]);
+        for (int j = 1; j < started; j++) {
+            pthread_join(tids[j], NULL);
+        }
+    }
+
+    printf("[Thread %d] Striped over %d links: %lu chunks, %lu out of order "
+           "(max distance %lu), %lu ring waits\n", args->thread_id, k, r->stats.chunks,
+           r->stats.out_of_order, r->stats.max_reorder, r->stats.window_waits);
+
+    pthread_mutex_lock(&mux_stats_mutex);
+    stripe_totals.links = k;
+    stripe_totals.chunks += r->stats.chunks;
+    stripe_totals.out_of_order += r->stats.out_of_order;
+    stripe_totals.window_waits += r->stats.window_waits;
+    if (r->stats.max_reorder > stripe_totals.max_reorder) {
+        stripe_totals.max_reorder = r->stats.max_reorder;
+    }
+    pthread_mutex_unlock(&mux_stats_mutex);
+
+    for (int j = 1; j < opened; j++) {
+        close(links[j].fd);
+    }
+    for (int i = 0; i < STRIPE_SLOTS; i++) {
+        bufpool_put(r->bufs[i], r->buf_sizes[i]);
+    }
+    pthread_cond_destroy(&r->moved);
+    pthread_mutex_destroy(&r->lock);
+    free(r);
+}
+
+/* Print the reassembly totals of all striped streams */
+static inline void stripe_report(const char *impl) {
+    StripeStats *s = &stripe_totals;
+    printf("\n=== Striping ===\n");
+    printf("Links per stream: %d, chunks: %lu, out of order: %lu, "
+           "max reorder distance: %lu, ring waits: %lu\n",
+           s->links, s->chunks, s->out_of_order, s->max_reorder, s->window_waits);
+    printf("STRIPECSV: %s,%d,%lu,%lu,%lu,%lu\n",
+           impl, s->links, s->chunks, s->out_of_order, s->max_reorder, s->window_waits);
+}
+
+#endif /* MT25033_PART_A_STRIPE_H */
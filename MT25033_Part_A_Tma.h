@@ -0,0 +1,427 @@
+/*
+ * MT25033_Part_A_Tma.h
+ * Top-down microarchitecture analysis (TMA) per connection thread
+ * Roll Number: MT25033
+ *
+ * With -U 1 every server connection thread and client thread counts its own
+ * measurement window with perf_event_open() (user and kernel, this thread
+ * only), so the numbers cover the send/recv loop and not process setup.
+ *
+ * Level 1 splits the pipeline slots into retiring, bad speculation,
+ * frontend bound and backend bound:
+ * - Ice Lake and later: the `slots` group with the topdown-* metric events;
+ *   where the PMU has them (Sapphire Rapids and later) also the level-2
+ *   events heavy-ops, br-mispredict, fetch-lat and mem-bound
+ * - Skylake-era cores: topdown-total-slots, -slots-issued, -slots-retired,
+ *   -fetch-bubbles and -recovery-bubbles with the usual level-1 formulas
+ * Event encodings are read from sysfs, so nothing here is model specific.
+ *
+ * To tell an L1/L2-bound copy from a DRAM-bandwidth-bound one, cycles,
+ * L1D read misses and LLC read misses are counted next to the groups: many
+ * L1D misses per KB with few LLC misses means the copies are served from
+ * L2/L3, while close to 16 LLC misses per KB (one per 64-byte line) means
+ * they stream from memory.
+ *
+ * Whatever the PMU or perf_event_paranoid does not allow is left out and
+ * its fields print empty. With paranoid >= 2 only user space is counted.
+ */
+
+#ifndef MT25033_PART_A_TMA_H
+#define MT25033_PART_A_TMA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#ifndef TMA_SYSFS
+#define TMA_SYSFS "/sys/bus/event_source/devices"
+#endif
+
+/* Slot categories; level 2 splits one level-1 category each */
+enum {
+    TMA_RETIRING,
+    TMA_BAD_SPEC,
+    TMA_FE_BOUND,
+    TMA_BE_BOUND,
+    TMA_HEAVY_OPS,                 /* Part of retiring */
+    TMA_BR_MISPREDICT,             /* Part of bad speculation */
+    TMA_FETCH_LAT,                 /* Part of frontend bound */
+    TMA_MEM_BOUND,                 /* Part of backend bound */
+    TMA_METRICS
+};
+
+/* Cache counters next to the slot groups */
+enum { TMA_CYCLES, TMA_L1D_MISS, TMA_LLC_MISS, TMA_CACHE_EVENTS };
+
+#define TMA_GROUP_MAX 9
+
+/* Counts summed over threads (slots per category, raw cache events) */
+typedef struct {
+    unsigned long windows;         /* Thread windows with top-down counts */
+    unsigned long cache_windows;   /* Thread windows with cache counts */
+    unsigned present;              /* Bit per TMA_* category that was counted */
+    int user_only;                 /* Kernel was excluded (perf_event_paranoid) */
+    double slots;
+    double metric[TMA_METRICS];
+    double cache[TMA_CACHE_EVENTS];
+    int cache_ok[TMA_CACHE_EVENTS];
+} TmaCounts;
+
+/* Open counters of one thread */
+typedef struct {
+    int group[TMA_GROUP_MAX];      /* group[0] is the leader */
+    int ngroup;
+    int cache[TMA_CACHE_EVENTS];
+    int user_only;
+} TmaProbe;
+
+/* Event from sysfs */
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+    double scale;
+} TmaEvent;
+
+#define TMA_MODE_NONE 0
+#define TMA_MODE_METRICS 1         /* slots + topdown-* (perf metrics) */
+#define TMA_MODE_LEGACY 2          /* topdown-total-slots and friends */
+
+static const char *const tma_metric_events[TMA_METRICS] = {
+    "topdown-retiring", "topdown-bad-spec", "topdown-fe-bound", "topdown-be-bound",
+    "topdown-heavy-ops", "topdown-br-mispredict", "topdown-fetch-lat", "topdown-mem-bound"
+};
+
+/* Legacy group order: leader first */
+static const char *const tma_legacy_events[] = {
+    "topdown-total-slots", "topdown-slots-issued", "topdown-slots-retired",
+    "topdown-fetch-bubbles", "topdown-recovery-bubbles"
+};
+#define TMA_LEGACY_EVENTS 5
+
+/* Resolved once per process */
+static pthread_once_t tma_once = PTHREAD_ONCE_INIT;
+static int tma_mode = TMA_MODE_NONE;
+static int tma_nevents;
+static TmaEvent tma_events[TMA_GROUP_MAX];
+static int tma_event_metric[TMA_GROUP_MAX];   /* METRICS mode: category per member */
+
+static inline int tma_read_file(const char *path, char *buf, size_t len) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    size_t n = fread(buf, 1, len - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' ')) buf[--n] = '\0';
+    return 0;
+}
+
+/* Place value into config at the bit ranges of a format file ("config:0-7,32-35") */
+static inline int tma_apply_format(const char *pmu, const char *term, uint64_t value,
+                                   uint64_t *config) {
+    char path[256], fmt[128];
+    snprintf(path, sizeof(path), "%s/%s/format/%s", TMA_SYSFS, pmu, term);
+    if (tma_read_file(path, fmt, sizeof(fmt)) < 0) return -1;
+    if (strncmp(fmt, "config:", 7) != 0) return -1;   /* config1/config2 not needed here */
+
+    char *p = fmt + 7;
+    while (*p) {
+        char *end;
+        int lo = (int)strtol(p, &end, 10);
+        int hi = lo;
+        if (*end == '-') hi = (int)strtol(end + 1, &end, 10);
+        if (end == p || lo < 0 || hi > 63 || hi < lo) return -1;
+        int width = hi - lo + 1;
+        uint64_t mask = width == 64 ? ~0ULL : ((1ULL << width) - 1);
+        *config |= (value & mask) << lo;
+        value = width == 64 ? 0 : value >> width;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',') return -1;
+    }
+    return 0;
+}
+
+/* Look up events/<name> ("event=0x00,umask=0x81") and its optional .scale */
+static inline int tma_lookup(const char *pmu, uint32_t type, const char *name, TmaEvent *ev) {
+    char path[256], desc[256];
+    snprintf(path, sizeof(path), "%s/%s/events/%s", TMA_SYSFS, pmu, name);
+    if (tma_read_file(path, desc, sizeof(desc)) < 0) return -1;
+
+    ev->type = type;
+    ev->config = 0;
+    ev->scale = 1.0;
+
+    char *save = NULL;
+    for (char *tok = strtok_r(desc, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        uint64_t value = 1;
+        if (eq) {
+            *eq = '\0';
+            value = strtoull(eq + 1, NULL, 0);
+        }
+        if (tma_apply_format(pmu, tok, value, &ev->config) < 0) return -1;
+    }
+
+    char scale[64];
+    snprintf(path, sizeof(path), "%s/%s/events/%s.scale", TMA_SYSFS, pmu, name);
+    if (tma_read_file(path, scale, sizeof(scale)) == 0 && atof(scale) > 0) {
+        ev->scale = atof(scale);
+    }
+    return 0;
+}
+
+static inline void tma_resolve(void) {
+    /* Hybrid parts name the big-core PMU cpu_core */
+    const char *pmus[] = { "cpu", "cpu_core" };
+    for (size_t i = 0; i < sizeof(pmus) / sizeof(pmus[0]); i++) {
+        char path[256], buf[32];
+        snprintf(path, sizeof(path), "%s/%s/type", TMA_SYSFS, pmus[i]);
+        if (tma_read_file(path, buf, sizeof(buf)) < 0) continue;
+        uint32_t type = (uint32_t)strtoul(buf, NULL, 10);
+
+        /* Perf metrics: slots leads, then every topdown-* metric present */
+        if (tma_lookup(pmus[i], type, "slots", &tma_events[0]) == 0) {
+            int n = 1;
+            unsigned level1 = 0;
+            for (int m = 0; m < TMA_METRICS && n < TMA_GROUP_MAX; m++) {
+                if (tma_lookup(pmus[i], type, tma_metric_events[m], &tma_events[n]) == 0) {
+                    if (m <= TMA_BE_BOUND) level1 |= 1U << m;
+                    tma_event_metric[n++] = m;
+                }
+            }
+            if (level1 == 0xfU) {
+                tma_nevents = n;
+                tma_mode = TMA_MODE_METRICS;
+                return;
+            }
+        }
+
+        int ok = 1;
+        for (int e = 0; e < TMA_LEGACY_EVENTS && ok; e++) {
+            ok = tma_lookup(pmus[i], type, tma_legacy_events[e], &tma_events[e]) == 0;
+        }
+        if (ok) {
+            tma_nevents = TMA_LEGACY_EVENTS;
+            tma_mode = TMA_MODE_LEGACY;
+            return;
+        }
+    }
+}
+
+static inline int tma_perf_open(uint32_t type, uint64_t config, int group_fd,
+                                int exclude_kernel) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd < 0;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    if (group_fd < 0) attr.read_format |= PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static inline void tma_close(TmaProbe *p) {
+    for (int i = 0; i < p->ngroup; i++) close(p->group[i]);
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) {
+        if (p->cache[i] >= 0) close(p->cache[i]);
+    }
+    p->ngroup = 0;
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) p->cache[i] = -1;
+}
+
+/* Open the slot group (if this PMU has one) on the calling thread */
+static inline void tma_open_group(TmaProbe *p) {
+    if (tma_mode == TMA_MODE_NONE) return;
+    for (int i = 0; i < tma_nevents; i++) {
+        int fd = tma_perf_open(tma_events[i].type, tma_events[i].config,
+                               i == 0 ? -1 : p->group[0], p->user_only);
+        if (fd < 0 && i == 0 && !p->user_only && (errno == EACCES || errno == EPERM)) {
+            p->user_only = 1;
+            fd = tma_perf_open(tma_events[i].type, tma_events[i].config, -1, 1);
+        }
+        if (fd < 0) {
+            /* The group is all or nothing: the formulas need every member */
+            for (int j = 0; j < p->ngroup; j++) close(p->group[j]);
+            p->ngroup = 0;
+            return;
+        }
+        p->group[p->ngroup++] = fd;
+    }
+}
+
+/*
+ * Open and start the counters on the calling thread.
+ * Returns 0 if anything could be counted, -1 otherwise.
+ */
+static inline int tma_start(TmaProbe *p) {
+    static const struct { uint32_t type; uint64_t config; } cache_events[TMA_CACHE_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    };
+
+    pthread_once(&tma_once, tma_resolve);
+    memset(p, 0, sizeof(*p));
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) p->cache[i] = -1;
+
+    tma_open_group(p);
+    int any = p->ngroup > 0;
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) {
+        p->cache[i] = tma_perf_open(cache_events[i].type, cache_events[i].config, -1,
+                                    p->user_only);
+        if (p->cache[i] < 0 && !p->user_only && (errno == EACCES || errno == EPERM)) {
+            p->user_only = 1;
+            p->cache[i] = tma_perf_open(cache_events[i].type, cache_events[i].config, -1, 1);
+        }
+        any |= p->cache[i] >= 0;
+    }
+    if (!any) return -1;
+
+    if (p->ngroup > 0) {
+        ioctl(p->group[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(p->group[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) {
+        if (p->cache[i] < 0) continue;
+        ioctl(p->cache[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(p->cache[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+    return 0;
+}
+
+/* Stop the counters, add this thread's window to out and close them */
+static inline void tma_stop(TmaProbe *p, TmaCounts *out) {
+    if (p->ngroup > 0) {
+        ioctl(p->group[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        /* nr, time_enabled, time_running, value[nr] */
+        uint64_t buf[3 + TMA_GROUP_MAX];
+        ssize_t n = read(p->group[0], buf, sizeof(buf));
+        if (n >= (ssize_t)(3 * sizeof(uint64_t)) && buf[0] == (uint64_t)p->ngroup && buf[2] > 0) {
+            double mult = (double)buf[1] / buf[2];   /* Multiplexing correction */
+            double v[TMA_GROUP_MAX] = {0};
+            for (int i = 0; i < p->ngroup; i++) {
+                v[i] = buf[3 + i] * mult * tma_events[i].scale;
+            }
+
+            if (tma_mode == TMA_MODE_METRICS) {
+                /* The kernel reports each metric already in slots */
+                out->slots += v[0];
+                for (int i = 1; i < p->ngroup; i++) {
+                    out->metric[tma_event_metric[i]] += v[i];
+                    out->present |= 1U << tma_event_metric[i];
+                }
+            } else {
+                /* total, issued, retired, fetch bubbles, recovery bubbles */
+                double bad = v[1] - v[2] + v[4];
+                double be = v[0] - v[3] - bad - v[2];
+                out->slots += v[0];
+                out->metric[TMA_RETIRING] += v[2];
+                out->metric[TMA_BAD_SPEC] += bad > 0 ? bad : 0;
+                out->metric[TMA_FE_BOUND] += v[3];
+                out->metric[TMA_BE_BOUND] += be > 0 ? be : 0;
+                out->present |= 0xfU;
+            }
+            out->windows++;
+        }
+    }
+
+    int cache_counted = 0;
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) {
+        if (p->cache[i] < 0) continue;
+        ioctl(p->cache[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t buf[3];
+        if (read(p->cache[i], buf, sizeof(buf)) == (ssize_t)sizeof(buf) && buf[2] > 0) {
+            out->cache[i] += buf[0] * ((double)buf[1] / buf[2]);
+            out->cache_ok[i] = 1;
+            cache_counted = 1;
+        }
+    }
+    if (cache_counted) out->cache_windows++;
+    if (p->user_only) out->user_only = 1;
+
+    tma_close(p);
+}
+
+static inline void tma_add(TmaCounts *dst, const TmaCounts *src) {
+    dst->windows += src->windows;
+    dst->cache_windows += src->cache_windows;
+    dst->present |= src->present;
+    dst->user_only |= src->user_only;
+    dst->slots += src->slots;
+    for (int i = 0; i < TMA_METRICS; i++) dst->metric[i] += src->metric[i];
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) {
+        dst->cache[i] += src->cache[i];
+        dst->cache_ok[i] |= src->cache_ok[i];
+    }
+}
+
+/* "%.1f" of a slot share, or "" when the category was not counted */
+static inline const char* tma_pct(const TmaCounts *t, int m, char *buf, size_t len) {
+    buf[0] = '\0';
+    if (t->windows && t->slots > 0 && (t->present & (1U << m))) {
+        snprintf(buf, len, "%.1f", t->metric[m] * 100.0 / t->slots);
+    }
+    return buf;
+}
+
+/* Cache event per KB moved (or per byte for cycles), or "" */
+static inline const char* tma_cache_rate(const TmaCounts *t, int e, unsigned long bytes,
+                                         char *buf, size_t len) {
+    buf[0] = '\0';
+    if (t->cache_ok[e] && bytes > 0) {
+        if (e == TMA_CYCLES) {
+            snprintf(buf, len, "%.3f", t->cache[e] / bytes);
+        } else {
+            snprintf(buf, len, "%.3f", t->cache[e] * 1024.0 / bytes);
+        }
+    }
+    return buf;
+}
+
+/*
+ * Summary lines for the whole run:
+ *   TMACSV: <who>,retiring,bad_spec,fe_bound,be_bound,heavy_ops,br_mispredict,
+ *           fetch_lat,mem_bound,l1d_miss_per_kb,llc_miss_per_kb,cycles_per_byte
+ * Shares are percent of slots; fields not counted here are empty.
+ */
+static inline void tma_report(const char *who, const TmaCounts *t, unsigned long bytes) {
+    char m[TMA_METRICS][16], c[TMA_CACHE_EVENTS][32];
+    for (int i = 0; i < TMA_METRICS; i++) tma_pct(t, i, m[i], sizeof(m[i]));
+    for (int i = 0; i < TMA_CACHE_EVENTS; i++) tma_cache_rate(t, i, bytes, c[i], sizeof(c[i]));
+
+    if (t->windows) {
+        printf("Top-down%s: retiring %s%%, bad speculation %s%%, frontend %s%%, backend %s%%",
+               t->user_only ? " (user only)" : "",
+               m[TMA_RETIRING], m[TMA_BAD_SPEC], m[TMA_FE_BOUND], m[TMA_BE_BOUND]);
+        if (m[TMA_MEM_BOUND][0]) {
+            printf(" (memory %s%%)", m[TMA_MEM_BOUND]);
+        }
+        printf("\n");
+    } else {
+        printf("Top-down: not available (no top-down events on this PMU or access denied)\n");
+    }
+    if (t->cache_windows) {
+        printf("Cache: %s L1D misses/KB, %s LLC misses/KB, %s cycles/byte\n",
+               c[TMA_L1D_MISS][0] ? c[TMA_L1D_MISS] : "-",
+               c[TMA_LLC_MISS][0] ? c[TMA_LLC_MISS] : "-",
+               c[TMA_CYCLES][0] ? c[TMA_CYCLES] : "-");
+    }
+    printf("TMACSV: %s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", who,
+           m[TMA_RETIRING], m[TMA_BAD_SPEC], m[TMA_FE_BOUND], m[TMA_BE_BOUND],
+           m[TMA_HEAVY_OPS], m[TMA_BR_MISPREDICT], m[TMA_FETCH_LAT], m[TMA_MEM_BOUND],
+           c[TMA_L1D_MISS], c[TMA_LLC_MISS], c[TMA_CYCLES]);
+}
+
+#endif /* MT25033_PART_A_TMA_H */
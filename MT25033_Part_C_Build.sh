@@ -0,0 +1,268 @@
+#!/bin/bash
+# MT25033
+# MT25033_Part_C_Build.sh
+# Compiler sensitivity: the same runs with each build variant
+# Roll Number: MT25033
+#
+# This script:
+# 1. Sets up the network namespaces
+# 2. For each build variant (o2, o3, lto, pgo) rebuilds every program with
+#    'make BUILD=<variant>' ('make pgo' for the profile-guided build, which
+#    trains on a short loopback run first)
+# 3. Runs each engine (A1/A2/A3) at a small and a large message size and
+#    records the server's user and kernel cost per byte: cycles:u / cycles:k
+#    from perf stat when available, and user / system CPU time always
+# 4. Stores one row per run with the build variant in CSV format, then a
+#    delta table against o2. Kernel cost should not move between builds;
+#    the change in user cost per byte is the compiler-sensitive part.
+#
+# Usage: sudo ./MT25033_Part_C_Build.sh [variant ...]
+#   variant  o2, o3, lto and/or pgo (default: all four; o2 is the baseline)
+
+set -e  # Exit on error
+
+# Configuration
+DURATION=10                           # Test duration in seconds
+PORT=8080                             # Server port
+SERVER_IP="10.0.0.1"                  # Server IP in namespace
+CLIENT_IP="10.0.0.2"                  # Client IP in namespace
+MSG_SIZES=(1024 65536)                # Small messages show per-call cost
+THREADS=1
+
+# Server-side user/kernel split (perf is optional)
+PERF_EVENTS="cycles:u,cycles:k,instructions:u"
+
+# Output directory for results
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Build_${TIMESTAMP}.csv"
+DELTA_FILE="${OUTPUT_DIR}/MT25033_Part_B_Build_${TIMESTAMP}_delta.csv"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+log_info() {
+    echo -e "${GREEN}[INFO]${NC} $1"
+}
+
+log_warn() {
+    echo -e "${YELLOW}[WARN]${NC} $1"
+}
+
+log_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+# Check if running as root (needed for namespaces)
+check_root() {
+    if [ "$EUID" -ne 0 ]; then
+        log_error "This script must be run as root for network namespaces"
+        log_info "Usage: sudo $0 [variant ...]"
+        exit 1
+    fi
+}
+
+# Set up network namespaces
+setup_namespaces() {
+    log_info "Setting up network namespaces..."
+
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+
+    ip netns add server_ns
+    ip netns add client_ns
+
+    ip link add veth-server type veth peer name veth-client
+
+    ip link set veth-server netns server_ns
+    ip link set veth-client netns client_ns
+
+    ip netns exec server_ns ip addr add ${SERVER_IP}/24 dev veth-server
+    ip netns exec server_ns ip link set veth-server up
+    ip netns exec server_ns ip link set lo up
+
+    ip netns exec client_ns ip addr add ${CLIENT_IP}/24 dev veth-client
+    ip netns exec client_ns ip link set veth-client up
+    ip netns exec client_ns ip link set lo up
+
+    log_info "Network namespaces configured"
+}
+
+# Clean up network namespaces
+cleanup_namespaces() {
+    log_info "Cleaning up network namespaces..."
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+}
+
+# Initialize CSV file with headers
+init_csv() {
+    mkdir -p ${OUTPUT_DIR}
+    echo "build,implementation,msg_size,threads,throughput_gbps,total_bytes,user_sec,sys_sec,user_ns_per_byte,sys_ns_per_byte,cycles_u,cycles_k,instructions_u,user_cycles_per_byte,kernel_cycles_per_byte" > ${CSV_FILE}
+    log_info "CSV file initialized: ${CSV_FILE}"
+}
+
+# Rebuild every program as one variant
+build_variant() {
+    local build=$1
+
+    log_info "Building variant ${build}..."
+    if [ "${build}" = "pgo" ]; then
+        make pgo > /dev/null
+    else
+        make BUILD=${build} > /dev/null
+    fi
+}
+
+# Run one engine at one message size with the current build
+run_build() {
+    local build=$1
+    local impl_name=$2
+    local server_bin=$3
+    local client_bin=$4
+    local msg_size=$5
+
+    log_info "Running: ${build}, ${impl_name}, msg_size=${msg_size}"
+
+    local tag="${build}_${impl_name}_${msg_size}"
+    local server_output="${OUTPUT_DIR}/build_server_${tag}.txt"
+    local client_output="${OUTPUT_DIR}/build_client_${tag}.txt"
+    local perf_output="${OUTPUT_DIR}/build_perf_${tag}.txt"
+    local time_output="${OUTPUT_DIR}/build_time_${tag}.txt"
+
+    # bash's time keyword reports the server's own user/system CPU time;
+    # the measurement window opens when the client connects
+    local perf=""
+    if [ ${USE_PERF} -eq 1 ]; then
+        perf="perf stat -e ${PERF_EVENTS} -o ${perf_output}"
+    fi
+    local TIMEFORMAT="%U,%S"
+    { time ip netns exec server_ns ${perf} ./${server_bin} -p ${PORT} -s ${msg_size} \
+        -d ${DURATION} > ${server_output} 2>&1 ; } 2> ${time_output} &
+    local server_pid=$!
+    sleep 1
+
+    ip netns exec client_ns ./${client_bin} -i ${SERVER_IP} -p ${PORT} -s ${msg_size} \
+        -t ${THREADS} -d $((DURATION + 2)) > ${client_output} 2>&1 || true
+    wait ${server_pid} 2>/dev/null || true
+
+    local built=$(grep "^Build variant:" ${server_output} | awk '{ print $3 }')
+    if [ "${built}" != "${build}" ]; then
+        log_warn "  Server reports build '${built}', expected '${build}'"
+    fi
+
+    # CSV: impl,size,threads,gbps,latency,bytes
+    local csv_line=$(grep "^CSV:" ${client_output} | tail -1 | cut -d':' -f2 | tr -d ' ')
+    local throughput=$(echo ${csv_line} | cut -d',' -f4)
+    local total_bytes=$(echo ${csv_line} | cut -d',' -f6)
+    local user_sec=$(tail -1 ${time_output} | cut -d',' -f1)
+    local sys_sec=$(tail -1 ${time_output} | cut -d',' -f2)
+
+    local cycles_u="" cycles_k="" instructions_u=""
+    if [ ${USE_PERF} -eq 1 ]; then
+        cycles_u=$(grep -E "cycles:u" ${perf_output} | awk '{ print $1 }' | tr -d ',')
+        cycles_k=$(grep -E "cycles:k" ${perf_output} | awk '{ print $1 }' | tr -d ',')
+        instructions_u=$(grep -E "instructions:u" ${perf_output} | awk '{ print $1 }' | tr -d ',')
+    fi
+
+    local per_byte=$(awk -v b=${total_bytes:-0} -v u=${user_sec:-0} -v s=${sys_sec:-0} \
+        -v cu="${cycles_u}" -v ck="${cycles_k}" 'BEGIN {
+            if (b <= 0) { print ",,,"; exit }
+            printf "%.4f,%.4f,", u * 1e9 / b, s * 1e9 / b
+            if (cu ~ /^[0-9]+$/) printf "%.4f", cu / b
+            printf ","
+            if (ck ~ /^[0-9]+$/) printf "%.4f", ck / b
+            printf "\n"
+        }')
+    local user_ns=$(echo ${per_byte} | cut -d',' -f1)
+    local sys_ns=$(echo ${per_byte} | cut -d',' -f2)
+    local ucpb=$(echo ${per_byte} | cut -d',' -f3)
+    local kcpb=$(echo ${per_byte} | cut -d',' -f4)
+
+    echo "${build},${impl_name},${msg_size},${THREADS},${throughput},${total_bytes},${user_sec},${sys_sec},${user_ns},${sys_ns},${cycles_u},${cycles_k},${instructions_u},${ucpb},${kcpb}" >> ${CSV_FILE}
+    log_info "  ${throughput} Gbps, user ${user_ns} ns/B, sys ${sys_ns} ns/B${ucpb:+, user ${ucpb} cycles/B}"
+
+    sleep 1
+}
+
+# Change of each variant against o2 for the same engine and message size
+write_delta() {
+    awk -F',' '
+        NR == 1 { next }
+        {
+            key = $2 "," $3
+            if ($1 == "o2") { gbps[key] = $5; uns[key] = $9; sns[key] = $10; ucpb[key] = $14 }
+            rows[++n] = $0
+        }
+        function pct(v, base) {
+            if (base == "" || v == "" || base + 0 == 0) return ""
+            return sprintf("%+.1f", (v - base) * 100 / base)
+        }
+        END {
+            print "build,implementation,msg_size,throughput_pct,user_ns_per_byte_pct,sys_ns_per_byte_pct,user_cycles_per_byte_pct"
+            for (i = 1; i <= n; i++) {
+                split(rows[i], f, ",")
+                if (f[1] == "o2") continue
+                key = f[2] "," f[3]
+                if (!(key in gbps)) continue
+                print f[1] "," key "," pct(f[5], gbps[key]) "," pct(f[9], uns[key]) "," \
+                      pct(f[10], sns[key]) "," pct(f[14], ucpb[key])
+            }
+        }' ${CSV_FILE} > ${DELTA_FILE}
+}
+
+# Main execution
+main() {
+    log_info "PA02: Build variant comparison (O2 / O3 native / LTO / PGO)"
+    log_info "Roll Number: MT25033"
+    log_info "=========================================="
+
+    local builds=("$@")
+    if [ ${#builds[@]} -eq 0 ]; then
+        builds=(o2 o3 lto pgo)
+    fi
+
+    check_root
+
+    USE_PERF=0
+    if perf stat -e ${PERF_EVENTS} true > /dev/null 2>&1; then
+        USE_PERF=1
+    else
+        log_warn "perf with ${PERF_EVENTS} not available, recording CPU time only"
+    fi
+
+    setup_namespaces
+    init_csv
+
+    for build in "${builds[@]}"; do
+        case ${build} in
+            o2|o3|lto|pgo) ;;
+            *) log_warn "Unknown build variant '${build}', skipping"; continue ;;
+        esac
+        build_variant ${build}
+        for msg_size in "${MSG_SIZES[@]}"; do
+            run_build ${build} "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client" ${msg_size}
+            run_build ${build} "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client" ${msg_size}
+            run_build ${build} "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client" ${msg_size}
+        done
+    done
+
+    # Leave the default build in place for the other scripts
+    make BUILD=o2 > /dev/null
+    write_delta
+
+    log_info "=========================================="
+    log_info "Results saved to: ${CSV_FILE}"
+    log_info "Delta against o2: ${DELTA_FILE}"
+    log_info "=========================================="
+    column -t -s ',' ${DELTA_FILE} 2>/dev/null || cat ${DELTA_FILE}
+}
+
+# Trap to ensure cleanup on exit
+trap cleanup_namespaces EXIT
+
+# Run main
+main "$@"
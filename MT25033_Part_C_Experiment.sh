@@ -10,25 +10,217 @@
 # 3. Runs experiments across message sizes and thread counts
 # 4. Collects profiling output using perf
 # 5. Stores results in CSV format
+# 6. Re-runs each server against the MSG_TRUNC discard client (A4) as a
+#    calibration baseline with the receiver's copy removed
+# 7. Sweeps the credit window of the optional credit flow-control mode
+# 8. Sweeps chunk size and scheduler of the multiplexed mode, with
+#    per-stream throughput and latency in a separate CSV
+# 9. Compares the threaded servers with forked worker processes (shared
+#    listener and per-worker SO_REUSEPORT listeners)
+# 10. Measures the cost of loop instrumentation: the same runs with the
+#     send/recv loops specialised without (instr0) and with (instr1) it
+# 11. Sweeps the send-queue target of queue-depth batching (-Q): batch size
+#     adapts to keep SIOCOUTQNSD near the target; the server's send-queue
+#     and the client's receive-queue time series go to a separate CSV
+# 12. On hybrid CPUs, places sender and receiver threads on performance
+#     (core) or efficiency (atom) cores in every combination (-A)
+# 13. Stripes one large-message stream over 1-8 connections (-G), on the
+#     main veth pair and on one extra pair per link; throughput and speedup
+#     over one link go to a separate CSV
+# 14. Re-runs a subset of the matrix over IPv6 (tcp6) and through a
+#     dual-stack listener (tcp46), for the per-family cost of the stack
+# 15. Places connection threads on the CPU that processes their packets
+#     (-C incoming, -C cbpf with per-CPU reuseport workers) and on random
+#     CPUs (-C random); throughput and cache misses against random go to a
+#     separate CSV
+#
+# Every run counts cycles and instructions per core type on both sides
+# (-A any); those rows go to a per-core-type CSV, so results can be split
+# by the core type the threads actually ran on. perf stat's per-PMU lines
+# on hybrid parts (cpu_core/cycles/, cpu_atom/cycles/) are summed.
+#
+# Every row also records the cores used by server and clients together
+# (CPU time over each side's window), throughput per core and the clients'
+# p50/p99/p99.9 receive latency (the highest of several client processes).
+# Zero-copy runs also record the server's completed and kernel-copied sends.
+# Multiplexed and open-loop (-O) runs record the messages per second the
+# clients received (msg_rate); the runner's SLO search compares it with the
+# offered rate.
+#
+# Each sweep writes a manifest of the machine and software it ran on
+# (MT25033_Part_B_Manifest_<timestamp>.txt, key=value); the HTML report
+# (MT25033_Part_D_Report.py) shows it next to the results.
+#
+# Every row also carries the top-down level-1 breakdown and memory-bound
+# share of server and client (srv_* / cli_*), counted over each side's
+# measurement window with perf_event_open (-U 1).
+#
+# Energy columns (package and DRAM joules, watts, joules per GB) come from
+# the server's RAPL readings over its window and stay empty without RAPL.
+#
+# Both sides snapshot /proc/net/snmp, /proc/net/netstat, softnet_stat and
+# vmstat in their own namespace when the window opens and closes (-K 1).
+# Every non-zero delta goes to a long-format kernel counter CSV (one row per
+# run, side and counter); the server's retransmits, TCPBacklogCoalesce and
+# softnet drops are also copied into the main results row.
+#
+# Every row records the build variant of the binaries (BUILD=o3 / lto / pgo
+# in the environment selects one; MT25033_Part_C_Build.sh compares them)
+#
+# Message sizes, thread counts and the duration of the main sweep come from
+# the sweep spec (MT25033_Part_C_Spec.json, or SPEC_FILE). The spec's full
+# matrix (engine, transport, size, threads, connections, topology, sysctls,
+# repeats) is run by MT25033_Part_C_Runner.py, one point per call of
+#   ./MT25033_Part_C_Experiment.sh --job <engine> <server_bin> <client_bin>
+#       <transport> <size> <threads> <connections> <topology> <variant> <id>
+#       [sysctl=value ...]
+# which sets up the topology, applies the sysctls, runs connections/threads
+# client processes and appends one row to the result files of TIMESTAMP.
+# JOB_SERVER_OPTS / JOB_CLIENT_OPTS in the environment add program options
+# (the auto-tuner's knobs).
+#
+# The namespaces get IPv4 and IPv6 addresses (NS_FAMILY=inet6: IPv6 only).
+# The transport is the address family: tcp (IPv4), tcp6 (IPv6) or tcp46
+# (IPv4 clients to a dual-stack listener); TRANSPORT selects it for the
+# main sweep, the runner per job.
+#
+# Every point is journaled (MT25033_Part_B_Journal_<timestamp>.log) when it
+# completes or fails. A sweep that died midway (namespace setup, OOM, a
+# perf error under set -e) continues with
+#   sudo ./MT25033_Part_C_Experiment.sh --resume <timestamp>
+# which appends to the same result files, skips completed points and runs
+# failed ones again. A point is tried at most MAX_ATTEMPTS times over all
+# resumes, and one invocation retries at most RETRY_BUDGET times.
 
 set -e  # Exit on error
 
+# --resume <timestamp>: continue that sweep from its journal
+if [ "$1" = "--resume" ]; then
+    if [ -z "$2" ]; then
+        echo "Usage: $0 --resume <timestamp>"
+        exit 1
+    fi
+    TIMESTAMP=$2
+    RESUMING=1
+    shift 2
+fi
+
+# Sweep spec shared with the menu and the runner
+SPEC_FILE=${SPEC_FILE:-MT25033_Part_C_Spec.json}
+
+# One value or list from the spec (fails the script if the spec is broken)
+spec_values() {
+    python3 MT25033_Part_C_Runner.py values "$1" --spec ${SPEC_FILE}
+}
+
 # Configuration
-DURATION=10                           # Test duration in seconds
+DURATION=${DURATION:-$(spec_values duration)}   # Test duration in seconds
 PORT=8080                             # Server port
 SERVER_IP="10.0.0.1"                  # Server IP in namespace
 CLIENT_IP="10.0.0.2"                  # Client IP in namespace
+SERVER_IP6="fd00::1"                  # Server IPv6 address in namespace
+CLIENT_IP6="fd00::2"                  # Client IPv6 address in namespace
+
+# Addresses the namespaces get: dual (IPv4 and IPv6) or inet6 (IPv6 only)
+NS_FAMILY=${NS_FAMILY:-dual}
+
+# Where clients run and what they connect to (a loopback job runs both
+# sides in server_ns), and client processes per run
+CLIENT_NS="client_ns"
+CONNECT_IP=${SERVER_IP}
+CLIENT_PROCS=1
+
+# Transport of the main matrix (tcp, tcp6 or tcp46, see set_transport)
+# and the server listener family it needs
+TRANSPORT=${TRANSPORT:-tcp}
+FAMILY_OPT=""
 
 # Message sizes to test (in bytes) - total message size (8 fields)
-MSG_SIZES=(1024 4096 16384 65536)
+MSG_SIZES=($(spec_values size))
 
 # Thread counts to test
-THREAD_COUNTS=(1 2 4 8)
+THREAD_COUNTS=($(spec_values threads))
+
+# Credit windows (bytes per connection) for the flow-control sweep,
+# run at a fixed message size and thread count
+CREDIT_WINDOWS=(65536 262144 1048576 4194304 16777216)
+CREDIT_MSG_SIZE=65536
+CREDIT_THREADS=4
+
+# Multiplexed mode: streams per connection (size[:weight]), chunk sizes and
+# schedulers to sweep. Fewer connections carry all streams.
+MUX_STREAMS="1024,65536,1048576:4"
+MUX_CHUNKS=(4096 16384 65536 262144)
+MUX_SCHEDULERS=(rr drr)
+MUX_THREADS=2
+
+# Multi-process mode: worker process counts, run with a fixed number of
+# client connections so rows compare directly with the threaded server
+WORKER_COUNTS=(2 4 8)
+WORKER_MSG_SIZE=65536
+WORKER_THREADS=8
+
+# Instrumentation overhead: small messages, where per-call cost shows most.
+# Base rows use the server's plain loop and the client's timed loop (latency).
+INSTR_MSG_SIZES=(1024 65536)
+INSTR_THREADS=1
+
+# Queue-depth batching: not-sent byte targets, message sizes and threads
+QDEPTH_TARGETS=(16384 65536 262144 1048576)
+QDEPTH_MSG_SIZES=(1024 65536)
+QDEPTH_THREADS=2
+
+# Striping: one large-message stream over K connections, all on the main
+# veth pair ("shared") or each on its own ("veth", 10.0.<i>.1 <-> .2)
+STRIPE_LINKS=(1 2 4 8)
+STRIPE_MSG_SIZE=16777216
+STRIPE_THREADS=1
+
+# Address families: transports re-run against the IPv4 (tcp) rows
+FAMILY_TRANSPORTS=(tcp6 tcp46)
+FAMILY_MSG_SIZES=(1024 65536 1048576)
+FAMILY_THREADS=(1 4)
+
+# CPU steering: modes (random is the baseline), message sizes and threads;
+# cbpf runs one SO_REUSEPORT worker per CPU (at least two)
+STEER_MODES=(random incoming cbpf)
+STEER_MSG_SIZES=(65536 1048576)
+STEER_THREADS=4
+STEER_WORKERS=$(( $(nproc) > 1 ? $(nproc) : 2 ))
+
+# Core-type placement (hybrid CPUs only): server and client core types
+PLACEMENTS=(core atom)
+PLACEMENT_MSG_SIZES=(1024 65536)
+PLACEMENT_THREADS=1
 
 # Output directory for results
 OUTPUT_DIR="results"
-TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+TIMESTAMP=${TIMESTAMP:-$(date +%Y%m%d_%H%M%S)}   # The runner shares one across jobs
+JOB_TAG=""                            # Suffix of per-run output files (job id)
 CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Results_${TIMESTAMP}.csv"
+MUX_CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Mux_${TIMESTAMP}.csv"
+KSTAT_CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Kstat_${TIMESTAMP}.csv"
+QDEPTH_CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Qdepth_${TIMESTAMP}.csv"
+CORES_CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Cores_${TIMESTAMP}.csv"
+STRIPE_CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Stripe_${TIMESTAMP}.csv"
+STEER_CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Steer_${TIMESTAMP}.csv"
+MANIFEST_FILE="${OUTPUT_DIR}/MT25033_Part_B_Manifest_${TIMESTAMP}.txt"
+
+# Journal of completed and failed points: "<epoch> done|fail <tag> <attempt>"
+JOURNAL_FILE="${OUTPUT_DIR}/MT25033_Part_B_Journal_${TIMESTAMP}.log"
+MAX_ATTEMPTS=${MAX_ATTEMPTS:-3}       # Attempts per point, over all resumes
+RETRY_BUDGET=${RETRY_BUDGET:-20}      # Retries per invocation
+
+# Top-down and cache counters inside server and client (empty where the
+# PMU has no top-down events or perf_event_paranoid denies them)
+TOPDOWN_OPT="-U 1"
+
+# Kernel counter deltas over each side's window (snmp, netstat, softnet, vmstat)
+KSTAT_OPT="-K 1"
+
+# Per-core-type cycles and instructions, threads left unpinned (placement
+# runs override it)
+CORE_OPT="-A any"
 
 # Perf events to collect
 PERF_EVENTS="cycles,instructions,cache-references,cache-misses,L1-dcache-loads,L1-dcache-load-misses,LLC-loads,LLC-load-misses,context-switches"
@@ -64,7 +256,11 @@ check_root() {
 compile_all() {
     log_info "Compiling all implementations..."
     make clean
-    make all
+    if [ "${BUILD:-o2}" = "pgo" ]; then
+        make pgo
+    else
+        make all BUILD=${BUILD:-o2}
+    fi
     log_info "Compilation complete"
 }
 
@@ -87,19 +283,87 @@ setup_namespaces() {
     ip link set veth-server netns server_ns
     ip link set veth-client netns client_ns
 
-    # Configure interfaces in server namespace
-    ip netns exec server_ns ip addr add ${SERVER_IP}/24 dev veth-server
+    # Configure interfaces in server namespace (IPv6 without duplicate
+    # address detection, so the address is usable at once)
+    if [ "${NS_FAMILY}" != "inet6" ]; then
+        ip netns exec server_ns ip addr add ${SERVER_IP}/24 dev veth-server
+    fi
+    ip netns exec server_ns ip -6 addr add ${SERVER_IP6}/64 dev veth-server nodad
     ip netns exec server_ns ip link set veth-server up
     ip netns exec server_ns ip link set lo up
 
     # Configure interfaces in client namespace
-    ip netns exec client_ns ip addr add ${CLIENT_IP}/24 dev veth-client
+    if [ "${NS_FAMILY}" != "inet6" ]; then
+        ip netns exec client_ns ip addr add ${CLIENT_IP}/24 dev veth-client
+    fi
+    ip netns exec client_ns ip -6 addr add ${CLIENT_IP6}/64 dev veth-client nodad
     ip netns exec client_ns ip link set veth-client up
     ip netns exec client_ns ip link set lo up
 
-    log_info "Network namespaces configured"
-    log_info "  Server namespace: server_ns (${SERVER_IP})"
-    log_info "  Client namespace: client_ns (${CLIENT_IP})"
+    log_info "Network namespaces configured (${NS_FAMILY})"
+    if [ "${NS_FAMILY}" = "inet6" ]; then
+        log_info "  Server namespace: server_ns (${SERVER_IP6})"
+        log_info "  Client namespace: client_ns (${CLIENT_IP6})"
+    else
+        log_info "  Server namespace: server_ns (${SERVER_IP}, ${SERVER_IP6})"
+        log_info "  Client namespace: client_ns (${CLIENT_IP}, ${CLIENT_IP6})"
+    fi
+}
+
+# Address family of a transport: the servers' listener (-F) and the address
+# clients connect to, after the topology has set CONNECT_IP.
+#   tcp    IPv4
+#   tcp6   IPv6 (fd00::1, or ::1 on loopback)
+#   tcp46  IPv4 clients to a dual-stack IPv6 listener (v4-mapped)
+set_transport() {
+    case $1 in
+        tcp)
+            FAMILY_OPT=""
+            ;;
+        tcp6)
+            FAMILY_OPT="-F 6"
+            if [ "${CONNECT_IP}" = "127.0.0.1" ] || [ "${CONNECT_IP}" = "::1" ]; then
+                CONNECT_IP="::1"
+            else
+                CONNECT_IP=${SERVER_IP6}
+            fi
+            ;;
+        tcp46)
+            FAMILY_OPT="-F 46"
+            ;;
+        *)
+            log_error "Unsupported transport '$1'"
+            exit 1
+            ;;
+    esac
+}
+
+# Extra veth pairs for striped links: veth-s<i> (10.0.<i>.1) in server_ns,
+# veth-c<i> (10.0.<i>.2) in client_ns, for i = 1..n-1. They go away with
+# the namespaces.
+setup_stripe_links() {
+    local n=$1 i
+    local prefix=${SERVER_IP%.*.*}
+    for ((i = 1; i < n; i++)); do
+        ip netns exec server_ns ip link show veth-s${i} >/dev/null 2>&1 && continue
+        ip link add veth-s${i} type veth peer name veth-c${i}
+        ip link set veth-s${i} netns server_ns
+        ip link set veth-c${i} netns client_ns
+        ip netns exec server_ns ip addr add ${prefix}.${i}.1/24 dev veth-s${i}
+        ip netns exec server_ns ip link set veth-s${i} up
+        ip netns exec client_ns ip addr add ${prefix}.${i}.2/24 dev veth-c${i}
+        ip netns exec client_ns ip link set veth-c${i} up
+    done
+}
+
+# Server addresses of n striped links, one per veth pair (comma-separated)
+stripe_addresses() {
+    local n=$1 i
+    local list=${SERVER_IP}
+    for ((i = 1; i < n; i++)); do
+        list="${list},${SERVER_IP%.*.*}.${i}.1"
+    done
+    echo ${list}
 }
 
 # Clean up network namespaces
@@ -108,51 +372,227 @@ cleanup_namespaces() {
     ip netns del server_ns 2>/dev/null || true
     ip netns del client_ns 2>/dev/null || true
     log_info "Namespaces cleaned up"
+    restore_sysctls
+}
+
+# Sysctls of a job (key=value), and global ones it changed as key=old_value
+JOB_SYSCTLS=()
+SYSCTL_RESTORE=()
+
+# Apply key=value sysctls: inside both namespaces where the key is per
+# network namespace (net.*, discarded with them), otherwise globally,
+# keeping the old value for restore_sysctls
+apply_sysctls() {
+    local kv key
+    for kv in "$@"; do
+        key=${kv%%=*}
+        if [[ ${key} == net.* ]] && \
+           ip netns exec server_ns sysctl -qw "${kv}" 2>/dev/null && \
+           ip netns exec client_ns sysctl -qw "${kv}" 2>/dev/null; then
+            log_info "  sysctl ${kv} (per namespace)"
+            continue
+        fi
+        local old=$(sysctl -n ${key} 2>/dev/null | tr '\t' ' ')
+        if [ -z "${old}" ] || ! sysctl -qw "${kv}"; then
+            log_error "Cannot set sysctl ${kv}"
+            return 1
+        fi
+        SYSCTL_RESTORE+=("${key}=${old}")
+        log_info "  sysctl ${kv} (global, was ${old})"
+    done
+}
+
+# Set the namespaces up again if a failed run took them down
+ensure_namespaces() {
+    if ip netns exec server_ns true 2>/dev/null && ip netns exec client_ns true 2>/dev/null; then
+        return
+    fi
+    log_warn "Namespaces missing, setting them up again"
+    setup_namespaces
+    apply_sysctls "${JOB_SYSCTLS[@]}"
+}
+
+restore_sysctls() {
+    local kv
+    for kv in "${SYSCTL_RESTORE[@]}"; do
+        sysctl -qw "${kv}" || log_warn "Cannot restore sysctl ${kv}"
+    done
+    SYSCTL_RESTORE=()
+}
+
+# Top-down columns per side; TMACSV fields 2-5 (level 1), 9 (memory bound),
+# 10-11 (L1D / LLC read misses per KB)
+TMA_FIELDS="2-5,9-11"
+TMA_COLUMNS="srv_retiring,srv_bad_spec,srv_fe_bound,srv_be_bound,srv_mem_bound,srv_l1d_mpkb,srv_llc_mpkb,cli_retiring,cli_bad_spec,cli_fe_bound,cli_be_bound,cli_mem_bound,cli_l1d_mpkb,cli_llc_mpkb"
+
+# Write a CSV header unless the file exists (jobs of one sweep append)
+csv_header() {
+    [ -f $1 ] || echo "$2" > $1
 }
 
 # Initialize CSV file with headers
 init_csv() {
     mkdir -p ${OUTPUT_DIR}
-    echo "implementation,msg_size,threads,throughput_gbps,latency_us,total_bytes,cycles,instructions,cache_refs,cache_misses,l1_loads,l1_misses,llc_loads,llc_misses,context_switches" > ${CSV_FILE}
+    csv_header ${CSV_FILE} "implementation,msg_size,threads,throughput_gbps,latency_us,total_bytes,cycles,instructions,cache_refs,cache_misses,l1_loads,l1_misses,llc_loads,llc_misses,context_switches,variant,build,${TMA_COLUMNS},pkg_joules,dram_joules,watts,joules_per_gb,retrans_segs,backlog_coalesce,softnet_drops,cpu_cores,gbps_per_core,p99_us,p50_us,p999_us,zc_sends,zc_copied,msg_rate"
+    csv_header ${MUX_CSV_FILE} "implementation,chunk,scheduler,stream,msg_bytes,throughput_gbps,messages,avg_latency_us,max_latency_us"
+    csv_header ${KSTAT_CSV_FILE} "implementation,msg_size,threads,variant,side,counter,delta"
+    csv_header ${QDEPTH_CSV_FILE} "implementation,msg_size,target,side,thread,t_ms,outq,notsent,inq,batch"
+    csv_header ${CORES_CSV_FILE} "implementation,msg_size,threads,variant,throughput_gbps,side,placement,core_type,run_share,cycles,instructions,ipc,cycles_per_byte,core_bytes,core_gbps"
+    csv_header ${STRIPE_CSV_FILE} "implementation,msg_size,links,paths,throughput_gbps,speedup,chunks,out_of_order,max_reorder,ring_waits"
+    csv_header ${STEER_CSV_FILE} "implementation,msg_size,threads,mode,throughput_gbps,cache_misses,llc_misses,misses_per_mb,connections,on_incoming_cpu,gbps_vs_random,misses_vs_random"
+    [ -f ${MANIFEST_FILE} ] || write_manifest > ${MANIFEST_FILE}
     log_info "CSV file initialized: ${CSV_FILE}"
 }
 
+# Machine and software of the sweep, key=value (written once per timestamp)
+write_manifest() {
+    echo "timestamp=${TIMESTAMP}"
+    echo "started=$(date '+%Y-%m-%d %H:%M:%S %z')"
+    echo "host=$(hostname)"
+    echo "kernel=$(uname -r)"
+    echo "arch=$(uname -m)"
+    echo "cpu=$(grep -m1 '^model name' /proc/cpuinfo | cut -d':' -f2 | sed 's/^ *//')"
+    echo "cpus=$(nproc)"
+    echo "hybrid=$([ -d /sys/devices/cpu_atom ] && echo yes || echo no)"
+    echo "memory_kb=$(awk '/^MemTotal:/ { print $2 }' /proc/meminfo)"
+    echo "governor=$(cat /sys/devices/system/cpu/cpu0/cpufreq/scaling_governor 2>/dev/null)"
+    echo "compiler=$(${CC:-gcc} --version 2>/dev/null | head -1)"
+    echo "perf=$(perf --version 2>/dev/null)"
+    echo "perf_event_paranoid=$(cat /proc/sys/kernel/perf_event_paranoid 2>/dev/null)"
+    echo "commit=$(git rev-parse --short HEAD 2>/dev/null)$(git diff --quiet HEAD 2>/dev/null || echo ' (modified)')"
+    echo "build=${BUILD:-o2}"
+    echo "duration=${DURATION}"
+    echo "transport=${TRANSPORT}"
+    echo "ns_family=${NS_FAMILY}"
+    echo "spec=${SPEC_FILE}"
+    local key
+    for key in net.core.rmem_max net.core.wmem_max net.ipv4.tcp_rmem net.ipv4.tcp_wmem \
+               net.ipv4.tcp_congestion_control net.core.optmem_max; do
+        echo "${key}=$(sysctl -n ${key} 2>/dev/null)"
+    done
+}
+
 # Run a single experiment
+# Optional arguments 6-8: extra server options, extra client options and a
+# variant label recorded in the CSV (default "base")
 run_experiment() {
     local impl_name=$1
     local server_bin=$2
     local client_bin=$3
     local msg_size=$4
     local threads=$5
+    local server_extra=${6:-}
+    local client_extra=${7:-}
+    local variant=${8:-base}
 
-    log_info "Running: ${impl_name}, msg_size=${msg_size}, threads=${threads}"
+    log_info "Running: ${impl_name}, msg_size=${msg_size}, threads=${threads}, variant=${variant}"
 
-    local perf_output="${OUTPUT_DIR}/perf_${impl_name}_${msg_size}_${threads}.txt"
-    local server_output="${OUTPUT_DIR}/server_${impl_name}_${msg_size}_${threads}.txt"
-    local client_output="${OUTPUT_DIR}/client_${impl_name}_${msg_size}_${threads}.txt"
-
-    # Start client FIRST in client namespace (receiver)
-    ip netns exec client_ns ./${client_bin} -i ${SERVER_IP} -p ${PORT} -s ${msg_size} -t ${threads} -d $((DURATION + 5)) > ${client_output} 2>&1 &
-    local client_pid=$!
+    local tag="${impl_name}_${msg_size}_${threads}"
+    if [ "${variant}" != "base" ]; then
+        tag="${tag}_${variant}"
+    fi
+    tag="${tag}${JOB_TAG}"
+    local perf_output="${OUTPUT_DIR}/perf_${tag}.txt"
+    local server_output="${OUTPUT_DIR}/server_${tag}.txt"
+    local client_output="${OUTPUT_DIR}/client_${tag}.txt"
+    LAST_CLIENT_OUTPUT=${client_output}
+    LAST_SERVER_OUTPUT=${server_output}
+    LAST_RUN_OK=0
 
-    # Wait for client to be ready
-    sleep 2
+    if journal_done ${tag}; then
+        log_info "  Done in ${JOURNAL_FILE}, skipping"
+        return
+    fi
 
-    # Run server with perf in server namespace (sender - where copy optimization happens)
-    ip netns exec server_ns perf stat -e ${PERF_EVENTS} -o ${perf_output} \
-        ./${server_bin} -p ${PORT} -s ${msg_size} -d ${DURATION} > ${server_output} 2>&1
+    # Failed attempts count across resumes; retries also draw on RETRY_BUDGET
+    local attempt=$(journal_failures ${tag})
+    while true; do
+        attempt=$((attempt + 1))
+        if [ ${attempt} -gt ${MAX_ATTEMPTS} ]; then
+            if [ -n "${JOURNAL_FILE}" ]; then
+                log_warn "  ${tag} failed ${MAX_ATTEMPTS} times, giving up on it"
+            fi
+            return
+        fi
+        if [ ${attempt} -gt 1 ]; then
+            if [ ${RETRY_BUDGET} -le 0 ]; then
+                log_warn "  Retry budget used up, leaving ${tag} for a later --resume"
+                return
+            fi
+            RETRY_BUDGET=$((RETRY_BUDGET - 1))
+            log_warn "  Attempt ${attempt}/${MAX_ATTEMPTS} (${RETRY_BUDGET} retries left)"
+            ensure_namespaces
+        fi
 
-    # Kill client
-    kill ${client_pid} 2>/dev/null || true
-    wait ${client_pid} 2>/dev/null || true
+        if run_point ${server_bin} ${client_bin} ${msg_size} ${threads} \
+                ${server_output} ${client_output} ${perf_output} "${server_extra}" "${client_extra}"; then
+            break
+        fi
+        journal_add fail ${tag} ${attempt}
+        log_warn "  No result from every client (see ${server_output}, ${client_output})"
+        sleep 1
+    done
 
     # Parse results
-    parse_results "${impl_name}" "${msg_size}" "${threads}" "${client_output}" "${perf_output}"
+    parse_results "${impl_name}" "${msg_size}" "${threads}" "${client_output}" "${perf_output}" "${variant}" "${server_output}"
+    journal_add done ${tag} ${attempt}
+    LAST_RUN_OK=1
 
     # Small delay between experiments
     sleep 1
 }
 
+# One run of server and clients; fails unless every client process
+# printed its CSV: line
+run_point() {
+    local server_bin=$1
+    local client_bin=$2
+    local msg_size=$3
+    local threads=$4
+    local server_output=$5
+    local client_output=$6
+    local perf_output=$7
+    local server_extra=$8
+    local client_extra=$9
+
+    # Run server with perf in server namespace (sender - where copy optimization happens)
+    ip netns exec server_ns perf stat -e ${PERF_EVENTS} -o ${perf_output} \
+        ./${server_bin} -p ${PORT} -s ${msg_size} -d ${DURATION} ${TOPDOWN_OPT} ${KSTAT_OPT} ${CORE_OPT} ${FAMILY_OPT} ${server_extra} > ${server_output} 2>&1 &
+    local server_pid=$!
+
+    # Wait for the server to listen (clients do not retry connect)
+    sleep 2
+
+    # Start the clients (receivers); extra processes log to client_<tag>_p<n>.txt
+    local client_pids=()
+    for ((p = 0; p < CLIENT_PROCS; p++)); do
+        local out=${client_output}
+        if [ ${p} -gt 0 ]; then
+            out="${client_output%.txt}_p${p}.txt"
+        fi
+        ip netns exec ${CLIENT_NS} ./${client_bin} -i ${CONNECT_IP} -p ${PORT} -s ${msg_size} -t ${threads} -d $((DURATION + 5)) ${TOPDOWN_OPT} ${KSTAT_OPT} ${CORE_OPT} ${client_extra} > ${out} 2>&1 &
+        client_pids+=($!)
+    done
+
+    # The server ends the window and closes the connections; the clients
+    # then print their totals and exit. Stop any still running after 5 s.
+    wait ${server_pid} 2>/dev/null || true
+    local pid
+    for ((t = 0; t < 50; t++)); do
+        local alive=0
+        for pid in ${client_pids[@]}; do
+            if kill -0 ${pid} 2>/dev/null; then alive=1; fi
+        done
+        [ ${alive} -eq 1 ] || break
+        sleep 0.1
+    done
+    kill ${client_pids[@]} 2>/dev/null || true
+    wait ${client_pids[@]} 2>/dev/null || true
+
+    local results=$(cat ${client_output} ${client_output%.txt}_p*.txt 2>/dev/null | grep -c "^CSV:")
+    [ ${results} -ge ${CLIENT_PROCS} ]
+}
+
 # Parse results and append to CSV
 parse_results() {
     local impl_name=$1
@@ -160,23 +600,69 @@ parse_results() {
     local threads=$3
     local client_output=$4
     local perf_output=$5
+    local variant=$6
+    local server_output=$7
 
-    # Extract metrics from client output (CSV line)
-    local csv_line=$(grep "^CSV:" ${client_output} | tail -1 | cut -d':' -f2 | tr -d ' ')
-    local throughput=$(echo ${csv_line} | cut -d',' -f4)
-    local latency=$(echo ${csv_line} | cut -d',' -f5)
-    local total_bytes=$(echo ${csv_line} | cut -d',' -f6)
+    # Extract metrics from client output (CSV line); with several client
+    # processes throughput and bytes are summed and latency averaged.
+    # Counters and top-down columns are the first process's.
+    local client_outputs=${client_output}
+    for ((p = 1; p < CLIENT_PROCS; p++)); do
+        client_outputs="${client_outputs} ${client_output%.txt}_p${p}.txt"
+    done
+    local client_totals=$(client_csv ${client_outputs})
+    local throughput=$(echo ${client_totals} | cut -d',' -f1)
+    local latency=$(echo ${client_totals} | cut -d',' -f2)
+    local total_bytes=$(echo ${client_totals} | cut -d',' -f3)
+    local cpu=$(cpu_cores "${throughput}" ${server_output} ${client_outputs})
+    local p99=$(latency_percentile 3 ${client_outputs})
+    local p50=$(latency_percentile 2 ${client_outputs})
+    local p999=$(latency_percentile 4 ${client_outputs})
+
+    # Zero-copy sends completed / copied by the kernel anyway (A3 only)
+    local zc=$(grep -h "Zero-copy completions:" ${server_output} 2>/dev/null | \
+        sed 's/.*completions: \([0-9]*\) (\([0-9]*\) copied).*/\1 \2/' | \
+        awk '{ sends += $1; copied += $2; n++ } END { if (n) print sends "," copied; else print "," }')
+
+    # Messages per second over the window (MUXCSV field 5, multiplexed runs only)
+    local msg_rate=$(cat ${client_outputs} 2>/dev/null | grep "^MUXCSV:" | cut -d',' -f5 | \
+        awk -v d=${DURATION} '{ n += $1; c++ } END { if (c) printf "%.1f", n / d }')
 
     # Extract perf metrics
-    local cycles=$(grep -E "^\s*[0-9,]+\s+cycles" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local instructions=$(grep -E "^\s*[0-9,]+\s+instructions" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local cache_refs=$(grep "cache-references" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local cache_misses=$(grep "cache-misses" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local l1_loads=$(grep "L1-dcache-loads" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local l1_misses=$(grep "L1-dcache-load-misses" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local llc_loads=$(grep "LLC-loads" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local llc_misses=$(grep "LLC-load-misses" ${perf_output} | awk '{print $1}' | tr -d ',')
-    local ctx_switches=$(grep "context-switches" ${perf_output} | awk '{print $1}' | tr -d ',')
+    local cycles=$(perf_value ${perf_output} cycles)
+    local instructions=$(perf_value ${perf_output} instructions)
+    local cache_refs=$(perf_value ${perf_output} cache-references)
+    local cache_misses=$(perf_value ${perf_output} cache-misses)
+    local l1_loads=$(perf_value ${perf_output} L1-dcache-loads)
+    local l1_misses=$(perf_value ${perf_output} L1-dcache-load-misses)
+    local llc_loads=$(perf_value ${perf_output} LLC-loads)
+    local llc_misses=$(perf_value ${perf_output} LLC-load-misses)
+    local ctx_switches=$(perf_value ${perf_output} context-switches)
+
+    # Build variant the binaries were compiled as (make BUILD=...)
+    local build=$(grep "^Build variant:" ${client_output} | awk '{print $3}')
+
+    # Top-down breakdown of each side (7 fields each, empty if not counted)
+    local srv_tma=$(grep "^TMACSV:" ${server_output} | tail -1 | cut -d',' -f${TMA_FIELDS})
+    local cli_tma=$(grep "^TMACSV:" ${client_output} | tail -1 | cut -d',' -f${TMA_FIELDS})
+    srv_tma=${srv_tma:-,,,,,,}
+    cli_tma=${cli_tma:-,,,,,,}
+
+    # ENERGYCSV: package_j,dram_j,seconds,watts,j_per_gb (empty without RAPL)
+    local energy=$(grep "^ENERGYCSV:" ${server_output} | tail -1 | cut -d':' -f2 | tr -d ' ' | cut -d',' -f1,2,4,5)
+    energy=${energy:-,,,}
+
+    # KSTAT: side,counter,delta (non-zero deltas only) -> long-format CSV
+    cat ${server_output} ${client_output} | grep "^KSTAT:" | sed "s/^KSTAT: /${impl_name},${msg_size},${threads},${variant},/" \
+        >> ${KSTAT_CSV_FILE} || true
+    local retrans=$(kstat_value ${server_output} Tcp.RetransSegs)
+    local coalesce=$(kstat_value ${server_output} TcpExt.TCPBacklogCoalesce)
+    local drops=$(kstat_value ${server_output} Softnet.dropped)
+
+    # CORECSV: who,placement,type,run_share,cycles,instructions,ipc,cycles_per_byte,bytes,gbps
+    cat ${server_output} ${client_output} | grep "^CORECSV:" | \
+        sed "s/^CORECSV: /${impl_name},${msg_size},${threads},${variant},${throughput},/" \
+        >> ${CORES_CSV_FILE} || true
 
     # Set defaults for missing values
     cycles=${cycles:-0}
@@ -190,9 +676,84 @@ parse_results() {
     ctx_switches=${ctx_switches:-0}
 
     # Append to CSV
-    echo "${impl_name},${msg_size},${threads},${throughput},${latency},${total_bytes},${cycles},${instructions},${cache_refs},${cache_misses},${l1_loads},${l1_misses},${llc_loads},${llc_misses},${ctx_switches}" >> ${CSV_FILE}
+    echo "${impl_name},${msg_size},${threads},${throughput},${latency},${total_bytes},${cycles},${instructions},${cache_refs},${cache_misses},${l1_loads},${l1_misses},${llc_loads},${llc_misses},${ctx_switches},${variant},${build},${srv_tma},${cli_tma},${energy},${retrans},${coalesce},${drops},${cpu},${p99},${p50},${p999},${zc},${msg_rate}" >> ${CSV_FILE}
 
-    log_info "  Throughput: ${throughput} Gbps, Latency: ${latency} µs"
+    local j_per_gb=$(echo ${energy} | cut -d',' -f4)
+    log_info "  Throughput: ${throughput} Gbps, Latency: ${latency} µs${j_per_gb:+, Energy: ${j_per_gb} J/GB}"
+}
+
+# Count of one event from perf stat output; hybrid parts report one line per
+# core-type PMU (cpu_core/cycles/, cpu_atom/cycles/), which are summed
+perf_value() {
+    awk -v ev="$2" '$2 == ev || $2 == "cpu_core/" ev "/" || $2 == "cpu_atom/" ev "/" {
+        gsub(",", "", $1)
+        if ($1 ~ /^[0-9]+$/) { sum += $1; n++ }
+    } END { if (n) print sum }' $1
+}
+
+# Journal helpers (no-ops without a journal, as in --job mode, where the
+# runner keeps its own)
+journal_add() {
+    [ -n "${JOURNAL_FILE}" ] || return 0
+    echo "$(date +%s) $1 $2 $3" >> ${JOURNAL_FILE}
+}
+
+journal_done() {
+    [ -n "${JOURNAL_FILE}" ] && grep -q "^[0-9]* done $1 " ${JOURNAL_FILE} 2>/dev/null
+}
+
+journal_failures() {
+    local n=0
+    if [ -n "${JOURNAL_FILE}" ] && [ -f ${JOURNAL_FILE} ]; then
+        n=$(grep -c "^[0-9]* fail $1 " ${JOURNAL_FILE} || true)
+    fi
+    echo ${n}
+}
+
+journal_count() {
+    awk -v s=$1 '$2 == s { n++ } END { print n + 0 }' ${JOURNAL_FILE} 2>/dev/null
+}
+
+# Throughput, latency and bytes over client logs (CSV: impl,size,threads,gbps,lat_us,bytes)
+client_csv() {
+    local f
+    for f in "$@"; do
+        grep "^CSV:" ${f} 2>/dev/null | tail -1 | cut -d':' -f2 | tr -d ' '
+    done | awk -F',' '
+        { gbps += $4; lat += $5; bytes += $6; n++; line = $4 "," $5 "," $6 }
+        END {
+            if (n == 1) print line
+            else if (n > 1) printf "%.4f,%.2f,%.0f\n", gbps, lat / n, bytes
+        }'
+}
+
+# Cores used by server and clients together (CPUCSV: side,user,sys,seconds,cores)
+# and throughput per core: "cores,gbps_per_core", empty without CPU lines
+cpu_cores() {
+    local gbps=$1
+    shift
+    cat "$@" 2>/dev/null | grep "^CPUCSV:" | cut -d',' -f5 | \
+        awk -v gbps="${gbps}" '$1 != "" { cores += $1; n++ }
+            END {
+                if (!n || cores <= 0) { print ","; exit }
+                printf "%.3f,", cores
+                if (gbps != "") printf "%.4f", gbps / cores
+                printf "\n"
+            }'
+}
+
+# Highest latency percentile of several client logs (LATCSV field 2 = p50,
+# 3 = p99, 4 = p99.9)
+latency_percentile() {
+    local field=$1
+    shift
+    cat "$@" 2>/dev/null | grep "^LATCSV:" | cut -d',' -f${field} | grep -v '^$' | sort -g | tail -1
+}
+
+# Delta of one kernel counter from a KSTAT log (0 when it did not change)
+kstat_value() {
+    local value=$(grep "^KSTAT: [a-z]*,$2," $1 | tail -1 | cut -d',' -f3)
+    echo ${value:-0}
 }
 
 # Run all experiments for an implementation
@@ -212,8 +773,299 @@ run_all_experiments() {
     done
 }
 
+# Sweep the credit window for one implementation
+run_credit_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Credit sweep: ${impl_name}"
+    log_info "=========================================="
+
+    for window in "${CREDIT_WINDOWS[@]}"; do
+        run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+            "${CREDIT_MSG_SIZE}" "${CREDIT_THREADS}" "-c" "-c ${window}" "credit${window}"
+    done
+}
+
+# Sweep chunk size and scheduler of the multiplexed mode for one implementation
+run_mux_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Multiplexed sweep: ${impl_name} (streams ${MUX_STREAMS})"
+    log_info "=========================================="
+
+    for chunk in "${MUX_CHUNKS[@]}"; do
+        for sched in "${MUX_SCHEDULERS[@]}"; do
+            run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                "${chunk}" "${MUX_THREADS}" "-m ${MUX_STREAMS} -k ${chunk} -r ${sched}" "-m" \
+                "mux_${sched}_${chunk}"
+            [ ${LAST_RUN_OK} -eq 1 ] || continue
+
+            # Per-stream rows: impl,stream,msg_bytes,gbps,messages,avg_lat,max_lat
+            grep "^MUXCSV:" ${LAST_CLIENT_OUTPUT} | cut -d':' -f2 | tr -d ' ' | \
+                awk -F',' -v c=${chunk} -v r=${sched} \
+                    '{ print $1 "," c "," r "," $2 "," $3 "," $4 "," $5 "," $6 "," $7 }' >> ${MUX_CSV_FILE}
+        done
+    done
+}
+
+# Forked workers (shared listener, then SO_REUSEPORT) for one implementation
+run_worker_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Worker process sweep: ${impl_name}"
+    log_info "=========================================="
+
+    for workers in "${WORKER_COUNTS[@]}"; do
+        run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+            "${WORKER_MSG_SIZE}" "${WORKER_THREADS}" "-f ${workers}" "" "fork${workers}"
+        run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+            "${WORKER_MSG_SIZE}" "${WORKER_THREADS}" "-f ${workers} -R" "" "reuseport${workers}"
+    done
+}
+
+# Loops without and with instrumentation on both sides for one implementation
+run_instr_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Instrumentation overhead: ${impl_name}"
+    log_info "=========================================="
+
+    for msg_size in "${INSTR_MSG_SIZES[@]}"; do
+        for instr in 0 1; do
+            run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                "${msg_size}" "${INSTR_THREADS}" "-I ${instr}" "-I ${instr}" "instr${instr}"
+        done
+    done
+}
+
+# Queue-depth targets for one implementation, with both sides' time series
+run_qdepth_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Queue-depth batching sweep: ${impl_name}"
+    log_info "=========================================="
+
+    for msg_size in "${QDEPTH_MSG_SIZES[@]}"; do
+        for target in "${QDEPTH_TARGETS[@]}"; do
+            run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                "${msg_size}" "${QDEPTH_THREADS}" "-Q ${target}" "-Q 1" "qdepth${target}"
+            [ ${LAST_RUN_OK} -eq 1 ] || continue
+
+            # QDEPTH: side,thread,t_ms,outq,notsent,inq,batch
+            cat ${LAST_SERVER_OUTPUT} ${LAST_CLIENT_OUTPUT} | grep "^QDEPTH:" | \
+                sed "s/^QDEPTH: /${impl_name},${msg_size},${target},/" >> ${QDEPTH_CSV_FILE} || true
+        done
+    done
+}
+
+# Sender and receiver on each core type (hybrid CPUs only)
+run_placement_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    if [ ! -d /sys/devices/cpu_atom ]; then
+        log_warn "Not a hybrid CPU (no /sys/devices/cpu_atom), skipping placement sweep for ${impl_name}"
+        return
+    fi
+
+    log_info "=========================================="
+    log_info "Core-type placement: ${impl_name}"
+    log_info "=========================================="
+
+    for msg_size in "${PLACEMENT_MSG_SIZES[@]}"; do
+        for srv in "${PLACEMENTS[@]}"; do
+            for cli in "${PLACEMENTS[@]}"; do
+                run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                    "${msg_size}" "${PLACEMENT_THREADS}" "-A ${srv}" "-A ${cli}" "place_${srv}_${cli}"
+            done
+        done
+    done
+}
+
+# One stream striped over K connections for one implementation: throughput
+# against K (speedup over K = 1), with the links sharing one veth pair or
+# each on its own
+run_stripe_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Striping sweep: ${impl_name} (${STRIPE_MSG_SIZE}-byte messages)"
+    log_info "=========================================="
+
+    local max=${STRIPE_LINKS[${#STRIPE_LINKS[@]} - 1]}
+    setup_stripe_links ${max}
+
+    local base="" links paths
+    for links in "${STRIPE_LINKS[@]}"; do
+        for paths in shared veth; do
+            # One link is the same run either way
+            [ ${links} -eq 1 ] && [ "${paths}" = "veth" ] && continue
+
+            local client_extra="-G ${links}" variant="stripe${links}"
+            if [ "${paths}" = "veth" ]; then
+                client_extra="${client_extra} -i $(stripe_addresses ${links})"
+                variant="${variant}veth"
+            fi
+            run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                "${STRIPE_MSG_SIZE}" "${STRIPE_THREADS}" "-G" "${client_extra}" "${variant}"
+            [ ${LAST_RUN_OK} -eq 1 ] || continue
+
+            # STRIPECSV: impl,links,chunks,out_of_order,max_reorder,ring_waits
+            local gbps=$(grep "^CSV:" ${LAST_CLIENT_OUTPUT} | tail -1 | cut -d',' -f4)
+            local stats=$(grep "^STRIPECSV:" ${LAST_CLIENT_OUTPUT} | tail -1 | cut -d',' -f3-)
+            [ ${links} -eq 1 ] && base=${gbps}
+            local speedup=$(awk -v g=${gbps:-0} -v b=${base:-0} 'BEGIN { if (b > 0) printf "%.3f", g / b }')
+            echo "${impl_name},${STRIPE_MSG_SIZE},${links},${paths},${gbps},${speedup},${stats}" >> ${STRIPE_CSV_FILE}
+            log_info "  ${links} link(s), ${paths}: ${gbps} Gbps${speedup:+ (${speedup}x)}"
+        done
+    done
+}
+
+# Connection threads on their incoming CPU vs random CPUs for one
+# implementation: throughput and server cache misses per MB against random
+run_steer_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "CPU steering sweep: ${impl_name}"
+    log_info "=========================================="
+
+    local msg_size mode
+    for msg_size in "${STEER_MSG_SIZES[@]}"; do
+        local base_gbps="" base_misses=""
+        for mode in "${STEER_MODES[@]}"; do
+            local server_extra="-C ${mode}"
+            [ "${mode}" = "cbpf" ] && server_extra="${server_extra} -f ${STEER_WORKERS} -R"
+            run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                "${msg_size}" "${STEER_THREADS}" "${server_extra}" "" "steer_${mode}"
+            [ ${LAST_RUN_OK} -eq 1 ] || continue
+
+            # The row just written: throughput, bytes, cache-misses, LLC-load-misses
+            local row=$(tail -1 ${CSV_FILE})
+            local gbps=$(echo ${row} | cut -d',' -f4)
+            local bytes=$(echo ${row} | cut -d',' -f6)
+            local misses=$(echo ${row} | cut -d',' -f10)
+            local llc=$(echo ${row} | cut -d',' -f14)
+            local per_mb=$(awk -v m=${misses:-0} -v b=${bytes:-0} 'BEGIN { if (b > 0 && m > 0) printf "%.2f", m / (b / 1048576) }')
+
+            # STEERCSV: mode,connections,on_incoming,share
+            local steer=$(grep -h "^STEERCSV:" ${LAST_SERVER_OUTPUT} | tail -1 | cut -d',' -f2,3)
+            steer=${steer:-,}
+
+            if [ "${mode}" = "random" ]; then
+                base_gbps=${gbps}
+                base_misses=${per_mb}
+            fi
+            local vs_gbps=$(awk -v g=${gbps:-0} -v b=${base_gbps:-0} 'BEGIN { if (b > 0) printf "%.3f", g / b }')
+            local vs_misses=$(awk -v m=${per_mb:-0} -v b=${base_misses:-0} 'BEGIN { if (b > 0) printf "%.3f", m / b }')
+            echo "${impl_name},${msg_size},${STEER_THREADS},${mode},${gbps},${misses},${llc},${per_mb},${steer},${vs_gbps},${vs_misses}" >> ${STEER_CSV_FILE}
+            log_info "  ${mode}: ${gbps} Gbps, ${per_mb:-?} cache misses/MB${vs_gbps:+ (${vs_gbps}x random)}"
+        done
+    done
+}
+
+# IPv6 and dual-stack runs for one implementation (variants tcp6, tcp46);
+# the base rows of run_all_experiments are the IPv4 reference
+run_family_sweep() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    log_info "=========================================="
+    log_info "Address family sweep: ${impl_name}"
+    log_info "=========================================="
+
+    if [ "${NS_FAMILY}" = "inet6" ]; then
+        log_warn "IPv6-only namespaces, skipping address family sweep for ${impl_name}"
+        return
+    fi
+
+    local transport msg_size threads
+    for transport in "${FAMILY_TRANSPORTS[@]}"; do
+        set_transport ${transport}
+        for msg_size in "${FAMILY_MSG_SIZES[@]}"; do
+            for threads in "${FAMILY_THREADS[@]}"; do
+                run_experiment "${impl_name}" "${server_bin}" "${client_bin}" \
+                    "${msg_size}" "${threads}" "" "" "${transport}"
+            done
+        done
+    done
+    CONNECT_IP=${SERVER_IP}
+    set_transport ${TRANSPORT}
+}
+
+# One point of the spec matrix (see the header), called by the runner
+run_job() {
+    if [ $# -lt 10 ]; then
+        log_error "Usage: $0 --job <engine> <server_bin> <client_bin> <transport> <size> <threads> <connections> <topology> <variant> <id> [sysctl=value ...]"
+        exit 1
+    fi
+    local engine=$1 server_bin=$2 client_bin=$3 transport=$4 msg_size=$5
+    local threads=$6 connections=$7 topology=$8 variant=$9 id=${10}
+    shift 10
+
+    if [ $((connections % threads)) -ne 0 ]; then
+        log_error "connections (${connections}) must be a multiple of threads (${threads})"
+        exit 1
+    fi
+    CLIENT_PROCS=$((connections / threads))
+    JOB_TAG="_${id}"
+    JOB_SYSCTLS=("$@")
+
+    # One attempt; the runner journals jobs and retries them
+    JOURNAL_FILE=""
+    MAX_ATTEMPTS=1
+
+    check_root
+    setup_namespaces
+    case ${topology} in
+        veth) ;;
+        loopback)
+            CLIENT_NS="server_ns"
+            CONNECT_IP="127.0.0.1"
+            ;;
+        *)
+            log_error "Unknown topology '${topology}'"
+            exit 1
+            ;;
+    esac
+    set_transport ${transport}
+    apply_sysctls "$@"
+    init_csv
+
+    run_experiment "${engine}" "${server_bin}" "${client_bin}" "${msg_size}" "${threads}" \
+        "${JOB_SERVER_OPTS:-}" "${JOB_CLIENT_OPTS:-}" "${variant}"
+    [ ${LAST_RUN_OK} -eq 1 ]
+}
+
 # Main execution
 main() {
+    if [ "$1" = "--job" ]; then
+        shift
+        run_job "$@"
+        return
+    fi
+
     log_info "PA02: Network I/O Analysis - Automated Experiment Script"
     log_info "Roll Number: MT25033"
     log_info "=========================================="
@@ -226,21 +1078,93 @@ main() {
 
     # Set up namespaces
     setup_namespaces
+    set_transport ${TRANSPORT}
 
     # Initialize CSV
     init_csv
+    if [ "${RESUMING:-0}" -eq 1 ]; then
+        if [ ! -f ${JOURNAL_FILE} ]; then
+            log_error "No journal ${JOURNAL_FILE} to resume from"
+            exit 1
+        fi
+        log_info "Resuming ${TIMESTAMP}: $(journal_count done) points done, $(journal_count fail) failed attempts"
+    fi
 
     # Run experiments for each implementation
     run_all_experiments "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
     run_all_experiments "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
     run_all_experiments "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
 
+    # Calibration baseline: same senders, receiver drains with MSG_TRUNC.
+    # The gap to the rows above is the cost of the client's receive copy.
+    run_all_experiments "two_copy_discard" "MT25033_Part_A1_Server" "MT25033_Part_A4_Client"
+    run_all_experiments "one_copy_discard" "MT25033_Part_A2_Server" "MT25033_Part_A4_Client"
+    run_all_experiments "zero_copy_discard" "MT25033_Part_A3_Server" "MT25033_Part_A4_Client"
+
+    # Throughput against credit window (bounded in-flight bytes)
+    run_credit_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_credit_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_credit_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # Several streams per connection: per-stream throughput and HOL latency
+    run_mux_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_mux_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_mux_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # Processes instead of threads: no shared mm for page pinning or malloc
+    run_worker_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_worker_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_worker_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # Specialised loops: measurement tax of the instrumented variants
+    run_instr_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_instr_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_instr_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # Batches sized from the send queue instead of one message per call
+    run_qdepth_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_qdepth_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_qdepth_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # Copies on performance vs efficiency cores
+    run_placement_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_placement_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_placement_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # The same copies over IPv6 and a dual-stack listener
+    run_family_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_family_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_family_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # One stream over several connections: scaling past one send path
+    run_stripe_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_stripe_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_stripe_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
+    # Connection threads next to their softirq vs on random CPUs
+    run_steer_sweep "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client"
+    run_steer_sweep "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client"
+    run_steer_sweep "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client"
+
     # Cleanup
     cleanup_namespaces
 
     log_info "=========================================="
     log_info "All experiments completed!"
     log_info "Results saved to: ${CSV_FILE}"
+    log_info "Per-stream results: ${MUX_CSV_FILE}"
+    log_info "Kernel counter deltas: ${KSTAT_CSV_FILE}"
+    log_info "Queue-depth time series: ${QDEPTH_CSV_FILE}"
+    log_info "Per-core-type counters: ${CORES_CSV_FILE}"
+    log_info "Striping scaling: ${STRIPE_CSV_FILE}"
+    log_info "CPU steering: ${STEER_CSV_FILE}"
+    log_info "Manifest: ${MANIFEST_FILE}"
+    log_info "Journal: ${JOURNAL_FILE}"
+    local failed=$(awk '$2 == "done" { done[$3] = 1 } $2 == "fail" { fail[$3] = 1 }
+        END { for (t in fail) if (!(t in done)) n++; print n + 0 }' ${JOURNAL_FILE} 2>/dev/null)
+    if [ ${failed:-0} -gt 0 ]; then
+        log_warn "${failed} point(s) without a result; rerun them with: $0 --resume ${TIMESTAMP}"
+    fi
     log_info "=========================================="
 
     # Display summary
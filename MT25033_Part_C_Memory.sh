@@ -0,0 +1,229 @@
+#!/bin/bash
+# MT25033
+# MT25033_Part_C_Memory.sh
+# Memory per connection at high connection counts
+# Roll Number: MT25033
+#
+# This script:
+# 1. Sets up the network namespaces
+# 2. For each server (A1/A2/A3) and connection count (1k, 10k), opens that
+#    many slow connections (clients read once per second) under three
+#    configurations:
+#      default - system thread stack, one Message per connection thread
+#      stack   - small connection thread stacks (-T)
+#      lazy    - small stacks plus pooled buffers held only while sending (-L)
+# 3. Reads the server's RSS from its snapshots (-S) before the clients
+#    connect and once every connection is established, plus its virtual
+#    size (thread stacks are mostly reserved address space, not RSS)
+# 4. Stores RSS growth per connection in CSV format
+#
+# Usage: sudo ./MT25033_Part_C_Memory.sh
+
+set -e  # Exit on error
+
+# Configuration
+PORT=8080                             # Server port
+SERVER_IP="10.0.0.1"                  # Server IP in namespace
+CLIENT_IP="10.0.0.2"                  # Client IP in namespace
+MSG_SIZE=16384                        # Message size (bytes)
+CONN_COUNTS=(1000 10000)              # Connections to hold open
+CONNS_PER_CLIENT=1000                 # Threads per client process
+READ_DELAY_US=1000000                 # Client pause between receives
+STACK_KB=64                           # Small thread stack for -T
+SETTLE_TIMEOUT=120                    # Seconds to wait for all connections
+HOLD=5                                # Seconds to hold once all are connected
+
+CONFIGS=(default stack lazy)
+
+# Output directory for results
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Memory_${TIMESTAMP}.csv"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+log_info() {
+    echo -e "${GREEN}[INFO]${NC} $1"
+}
+
+log_warn() {
+    echo -e "${YELLOW}[WARN]${NC} $1"
+}
+
+log_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+# Check if running as root (needed for namespaces and raised limits)
+check_root() {
+    if [ "$EUID" -ne 0 ]; then
+        log_error "This script must be run as root for network namespaces"
+        log_info "Usage: sudo $0"
+        exit 1
+    fi
+}
+
+# Set up network namespaces
+setup_namespaces() {
+    log_info "Setting up network namespaces..."
+
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+
+    ip netns add server_ns
+    ip netns add client_ns
+
+    ip link add veth-server type veth peer name veth-client
+
+    ip link set veth-server netns server_ns
+    ip link set veth-client netns client_ns
+
+    ip netns exec server_ns ip addr add ${SERVER_IP}/24 dev veth-server
+    ip netns exec server_ns ip link set veth-server up
+    ip netns exec server_ns ip link set lo up
+
+    ip netns exec client_ns ip addr add ${CLIENT_IP}/24 dev veth-client
+    ip netns exec client_ns ip link set veth-client up
+    ip netns exec client_ns ip link set lo up
+
+    # Room for 10k connections: accept backlog in the server namespace
+    ip netns exec server_ns sysctl -qw net.core.somaxconn=16384 || true
+
+    log_info "Network namespaces configured"
+}
+
+# Clean up network namespaces
+cleanup_namespaces() {
+    log_info "Cleaning up network namespaces..."
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+}
+
+# Initialize CSV file with headers
+init_csv() {
+    mkdir -p ${OUTPUT_DIR}
+    echo "implementation,config,connections,established,rss_base_kb,rss_kb,kb_per_conn,vsz_kb,threads" > ${CSV_FILE}
+    log_info "CSV file initialized: ${CSV_FILE}"
+}
+
+# Last snapshot field (1-based within the SNAP: payload) from a server log
+last_snap_field() {
+    grep "^SNAP:" $1 | tail -1 | sed 's/^SNAP: //' | cut -d',' -f$2
+}
+
+# Hold conns slow connections open against one server configuration
+run_memory() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+    local config=$4
+    local conns=$5
+
+    log_info "Running: ${impl_name}, config=${config}, connections=${conns}"
+
+    local tag="${impl_name}_${config}_${conns}"
+    local server_output="${OUTPUT_DIR}/mem_server_${tag}.txt"
+
+    local extra=""
+    case ${config} in
+        stack) extra="-T ${STACK_KB}" ;;
+        lazy)  extra="-T ${STACK_KB} -L" ;;
+    esac
+
+    local duration=$((SETTLE_TIMEOUT + HOLD + 10))
+    ip netns exec server_ns ./${server_bin} -p ${PORT} -s ${MSG_SIZE} -d ${duration} \
+        -n $((conns + 100)) -S 1 ${extra} > ${server_output} 2>&1 &
+    local server_pid=$!
+
+    # Baseline RSS: first snapshot, before any client connects
+    local waited=0
+    while [ -z "$(last_snap_field ${server_output} 3)" ] && [ ${waited} -lt 10 ]; do
+        sleep 1
+        waited=$((waited + 1))
+    done
+    local rss_base=$(last_snap_field ${server_output} 3)
+
+    # Slow clients, CONNS_PER_CLIENT threads per process
+    local client_pids=()
+    local remaining=${conns}
+    while [ ${remaining} -gt 0 ]; do
+        local n=$(( remaining < CONNS_PER_CLIENT ? remaining : CONNS_PER_CLIENT ))
+        ip netns exec client_ns ./${client_bin} -i ${SERVER_IP} -p ${PORT} -s ${MSG_SIZE} \
+            -t ${n} -d $((duration - 5)) -W ${READ_DELAY_US} > /dev/null 2>&1 &
+        client_pids+=($!)
+        remaining=$((remaining - n))
+    done
+
+    # Wait until every connection is established, then let the buffers settle
+    waited=0
+    local active=0
+    while [ ${waited} -lt ${SETTLE_TIMEOUT} ]; do
+        active=$(last_snap_field ${server_output} 7)
+        if [ "${active:-0}" -ge ${conns} ]; then
+            break
+        fi
+        sleep 1
+        waited=$((waited + 1))
+    done
+    sleep ${HOLD}
+
+    local rss=$(last_snap_field ${server_output} 3)
+    local threads=$(last_snap_field ${server_output} 5)
+    active=$(last_snap_field ${server_output} 7)
+    # ip netns exec execs the server, so the pid is the server's own
+    local vsz=$(awk '/^VmSize:/ { print $2 }' /proc/${server_pid}/status 2>/dev/null)
+
+    kill ${client_pids[@]} 2>/dev/null || true
+    wait ${client_pids[@]} 2>/dev/null || true
+    kill -INT ${server_pid} 2>/dev/null || true
+    wait ${server_pid} 2>/dev/null || true
+
+    local per_conn=$(awk -v a=${rss:-0} -v b=${rss_base:-0} -v n=${active:-0} \
+        'BEGIN { if (n > 0) printf "%.1f", (a - b) / n; else print "" }')
+    echo "${impl_name},${config},${conns},${active},${rss_base},${rss},${per_conn},${vsz},${threads}" >> ${CSV_FILE}
+    log_info "  ${active}/${conns} connected, RSS ${rss_base} -> ${rss} KB, ${per_conn} KB per connection, VSZ ${vsz} KB"
+
+    if [ "${active:-0}" -lt ${conns} ]; then
+        log_warn "  Only ${active} of ${conns} connections were established"
+    fi
+
+    sleep 2
+}
+
+# Main execution
+main() {
+    log_info "PA02: Memory per connection (thread stacks, lazy buffers)"
+    log_info "Roll Number: MT25033"
+    log_info "=========================================="
+
+    check_root
+    make all > /dev/null
+    # One fd per connection: raise the open-file limit as far as allowed
+    ulimit -n 65536 2>/dev/null || ulimit -n $(ulimit -Hn)
+    log_info "Open file limit: $(ulimit -n)"
+    setup_namespaces
+    init_csv
+
+    for conns in "${CONN_COUNTS[@]}"; do
+        for config in "${CONFIGS[@]}"; do
+            run_memory "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client" "${config}" "${conns}"
+            run_memory "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client" "${config}" "${conns}"
+            run_memory "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client" "${config}" "${conns}"
+        done
+    done
+
+    log_info "=========================================="
+    log_info "Results saved to: ${CSV_FILE}"
+    log_info "=========================================="
+    column -t -s ',' ${CSV_FILE} 2>/dev/null || cat ${CSV_FILE}
+}
+
+# Trap to ensure cleanup on exit
+trap cleanup_namespaces EXIT
+
+# Run main
+main "$@"
@@ -0,0 +1,240 @@
+#!/bin/bash
+# MT25033
+# MT25033_Part_C_Priority.sh
+# Mixed-class isolation experiment: latency RPCs next to bulk streams
+# Roll Number: MT25033
+#
+# This script:
+# 1. Sets up the namespaces with a multi-queue veth pair
+# 2. Measures RPC latency (A5) on an idle link as the baseline
+# 3. Runs each bulk engine (A1/A2/A3, large messages) at SO_PRIORITY 2 (bulk)
+#    while A5 RPCs run at SO_PRIORITY 6 (interactive), for each qdisc:
+#      none   - one FIFO below the shaper, no isolation
+#      prio   - prio qdisc below the shaper, default priomap (6 -> band 0,
+#               2 -> band 2)
+#      mqprio - mqprio qdisc mapping the same priorities to separate queues,
+#               each queue shaped on its own (mqprio must be the root)
+# 4. Stores RPC tail latency and bulk throughput in CSV format
+#
+# veth has no transmit queue of its own and never pushes back, so an
+# unshaped root qdisc is dequeued as fast as packets arrive and no backlog
+# ever forms to reorder. Every mode therefore shapes egress below line rate
+# (SHAPE_RATE, htb at the root or tbf per mqprio queue), so the bulk streams
+# build a queue in the qdisc and the classes actually compete there.
+#
+# Usage: sudo ./MT25033_Part_C_Priority.sh
+
+set -e  # Exit on error
+
+# Configuration
+DURATION=10                           # Test duration in seconds
+BULK_PORT=8080                        # Bulk server port
+RPC_PORT=8081                         # RPC server port
+SERVER_IP="10.0.0.1"                  # Server IP in namespace
+CLIENT_IP="10.0.0.2"                  # Client IP in namespace
+
+BULK_MSG_SIZE=1048576                 # Bulk message size (1 MB)
+BULK_THREADS=4                        # Bulk connections
+BULK_PRIO=2                           # TC_PRIO_BULK
+RPC_MSG_SIZE=64                       # RPC request/response size
+RPC_THREADS=1                         # Outstanding RPCs
+RPC_PRIO=6                            # TC_PRIO_INTERACTIVE
+
+QDISCS=(none prio mqprio)
+SHAPE_RATE=${SHAPE_RATE:-2gbit}       # Egress rate limit, below veth speed
+SHAPE_BURST=${SHAPE_BURST:-256kb}     # tbf bucket (mqprio queues)
+
+# Output directory for results
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Priority_${TIMESTAMP}.csv"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+log_info() {
+    echo -e "${GREEN}[INFO]${NC} $1"
+}
+
+log_warn() {
+    echo -e "${YELLOW}[WARN]${NC} $1"
+}
+
+log_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+# Check if running as root (needed for namespaces and tc)
+check_root() {
+    if [ "$EUID" -ne 0 ]; then
+        log_error "This script must be run as root for network namespaces and tc"
+        log_info "Usage: sudo $0"
+        exit 1
+    fi
+}
+
+# Set up network namespaces with a multi-queue veth pair (needed by mqprio)
+setup_namespaces() {
+    log_info "Setting up network namespaces..."
+
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+
+    ip netns add server_ns
+    ip netns add client_ns
+
+    ip link add veth-server numtxqueues 3 numrxqueues 3 type veth \
+        peer name veth-client numtxqueues 3 numrxqueues 3
+
+    ip link set veth-server netns server_ns
+    ip link set veth-client netns client_ns
+
+    ip netns exec server_ns ip addr add ${SERVER_IP}/24 dev veth-server
+    ip netns exec server_ns ip link set veth-server up
+    ip netns exec server_ns ip link set lo up
+
+    ip netns exec client_ns ip addr add ${CLIENT_IP}/24 dev veth-client
+    ip netns exec client_ns ip link set veth-client up
+    ip netns exec client_ns ip link set lo up
+
+    log_info "Network namespaces configured (3 tx queues per veth)"
+}
+
+# Clean up network namespaces
+cleanup_namespaces() {
+    log_info "Cleaning up network namespaces..."
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+}
+
+# Install the shaped qdisc tree of one mode on both veth ends
+# Returns non-zero if the kernel rejects it, so the caller can skip that mode
+set_qdisc() {
+    local mode=$1
+    local ns dev q
+
+    for pair in "server_ns:veth-server" "client_ns:veth-client"; do
+        IFS=':' read -r ns dev <<< "$pair"
+        local tc="ip netns exec ${ns} tc"
+        ${tc} qdisc del dev ${dev} root 2>/dev/null || true
+        case ${mode} in
+            none|prio)
+                # htb at the root holds the backlog; the leaf decides the order
+                ${tc} qdisc add dev ${dev} root handle 1: htb default 1 || return 1
+                ${tc} class add dev ${dev} parent 1: classid 1:1 htb \
+                    rate ${SHAPE_RATE} ceil ${SHAPE_RATE} quantum 65536 || return 1
+                if [ "${mode}" = "prio" ]; then
+                    ${tc} qdisc add dev ${dev} parent 1:1 handle 10: prio || return 1
+                else
+                    ${tc} qdisc add dev ${dev} parent 1:1 handle 10: pfifo || return 1
+                fi
+                ;;
+            mqprio)
+                ${tc} qdisc add dev ${dev} root handle 1: mqprio num_tc 3 \
+                    map 1 2 2 2 1 2 0 0 1 1 1 1 1 1 1 1 queues 1@0 1@1 1@2 hw 0 || return 1
+                for q in 1 2 3; do
+                    ${tc} qdisc add dev ${dev} parent 1:${q} tbf rate ${SHAPE_RATE} \
+                        burst ${SHAPE_BURST} latency 100ms || return 1
+                done
+                ;;
+        esac
+    done
+    return 0
+}
+
+# Initialize CSV file with headers
+init_csv() {
+    mkdir -p ${OUTPUT_DIR}
+    echo "bulk_impl,bulk_msg_size,qdisc,shape_rate,bulk_prio,rpc_prio,bulk_gbps,rpc_rate,rpc_p50_us,rpc_p99_us,rpc_p999_us,rpc_max_us" > ${CSV_FILE}
+    log_info "CSV file initialized: ${CSV_FILE}"
+}
+
+# Run RPCs, optionally next to one bulk engine
+run_mixed() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+    local qdisc=$4
+
+    log_info "Running: bulk=${impl_name}, qdisc=${qdisc}"
+
+    local tag="${impl_name}_${qdisc}"
+    local rpc_output="${OUTPUT_DIR}/prio_rpc_${tag}.txt"
+    local bulk_output="${OUTPUT_DIR}/prio_bulk_${tag}.txt"
+    local bulk_gbps=""
+
+    local rpc_server_pid bulk_server_pid bulk_client_pid
+    ip netns exec server_ns ./MT25033_Part_A5_Server -p ${RPC_PORT} -s ${RPC_MSG_SIZE} \
+        -d $((DURATION + 2)) -P ${RPC_PRIO} > /dev/null 2>&1 &
+    rpc_server_pid=$!
+
+    if [ "${impl_name}" != "idle" ]; then
+        ip netns exec server_ns ./${server_bin} -p ${BULK_PORT} -s ${BULK_MSG_SIZE} \
+            -d $((DURATION + 2)) -P ${BULK_PRIO} > /dev/null 2>&1 &
+        bulk_server_pid=$!
+        sleep 1
+        ip netns exec client_ns ./${client_bin} -i ${SERVER_IP} -p ${BULK_PORT} -s ${BULK_MSG_SIZE} \
+            -t ${BULK_THREADS} -d $((DURATION + 1)) -P ${BULK_PRIO} > ${bulk_output} 2>&1 &
+        bulk_client_pid=$!
+    fi
+
+    # Let bulk traffic fill the queues before measuring RPCs
+    sleep 1
+    ip netns exec client_ns ./MT25033_Part_A5_Client -i ${SERVER_IP} -p ${RPC_PORT} -s ${RPC_MSG_SIZE} \
+        -t ${RPC_THREADS} -d ${DURATION} -P ${RPC_PRIO} > ${rpc_output} 2>&1
+
+    if [ "${impl_name}" != "idle" ]; then
+        wait ${bulk_client_pid} 2>/dev/null || true
+        kill ${bulk_server_pid} 2>/dev/null || true
+        wait ${bulk_server_pid} 2>/dev/null || true
+        bulk_gbps=$(grep "^CSV:" ${bulk_output} | tail -1 | cut -d',' -f4)
+    fi
+    kill ${rpc_server_pid} 2>/dev/null || true
+    wait ${rpc_server_pid} 2>/dev/null || true
+
+    # CSV: rpc,size,threads,rate,avg,bytes / LATCSV: rpc,p50,p99,p999,max
+    local rate=$(grep "^CSV:" ${rpc_output} | tail -1 | cut -d',' -f4)
+    local lat=$(grep "^LATCSV:" ${rpc_output} | tail -1 | cut -d',' -f2-)
+
+    echo "${impl_name},${BULK_MSG_SIZE},${qdisc},${SHAPE_RATE},${BULK_PRIO},${RPC_PRIO},${bulk_gbps},${rate},${lat}" >> ${CSV_FILE}
+    log_info "  RPC p50/p99/p99.9/max (µs): ${lat}, bulk: ${bulk_gbps:-n/a} Gbps"
+
+    sleep 1
+}
+
+# Main execution
+main() {
+    log_info "PA02: Mixed-class isolation (SO_PRIORITY + prio/mqprio qdisc)"
+    log_info "Roll Number: MT25033"
+    log_info "=========================================="
+
+    check_root
+    make all > /dev/null
+    setup_namespaces
+    init_csv
+
+    for qdisc in "${QDISCS[@]}"; do
+        if ! set_qdisc ${qdisc}; then
+            log_warn "qdisc ${qdisc} not supported here, skipping"
+            continue
+        fi
+        run_mixed "idle" "" "" "${qdisc}"
+        run_mixed "two_copy" "MT25033_Part_A1_Server" "MT25033_Part_A1_Client" "${qdisc}"
+        run_mixed "one_copy" "MT25033_Part_A2_Server" "MT25033_Part_A2_Client" "${qdisc}"
+        run_mixed "zero_copy" "MT25033_Part_A3_Server" "MT25033_Part_A3_Client" "${qdisc}"
+    done
+
+    log_info "=========================================="
+    log_info "Results saved to: ${CSV_FILE}"
+    log_info "=========================================="
+    column -t -s ',' ${CSV_FILE} 2>/dev/null || cat ${CSV_FILE}
+}
+
+# Trap to ensure cleanup on exit
+trap cleanup_namespaces EXIT
+
+# Run main
+main "$@"
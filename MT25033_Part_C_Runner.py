@@ -0,0 +1,787 @@
+#!/usr/bin/env python3
+"""
+MT25033_Part_C_Runner.py
+Declarative sweep runner for PA02: expands MT25033_Part_C_Spec.json into a job matrix
+Roll Number: MT25033
+
+The spec lists the values of each dimension:
+  engine       key of "engines" (server and client binary)
+  transport    address family: tcp (IPv4), tcp6 (IPv6), tcp46 (IPv4 client,
+               dual-stack IPv6 listener)
+  size         message size in bytes
+  threads      client threads per client process
+  connections  total client connections (connections / threads processes)
+  topology     veth (server_ns <-> client_ns) or loopback (both in server_ns)
+  sysctls      key of "sysctl_sets", applied for the job and undone after it
+  repeats      number of runs of every point
+"constraints" are Python expressions over the dimension names; a point is
+kept only if all of them are true. Points are deduplicated, repeated and
+shuffled with the spec's seed, so slow drift of the machine (thermal, page
+cache, background load) spreads over all points instead of biasing the
+last ones. A profile ("profiles") overrides top-level keys and individual
+dimensions.
+
+Usage:
+  python3 MT25033_Part_C_Runner.py expand [--profile P] [--seed N]
+      Print the job matrix as CSV
+  python3 MT25033_Part_C_Runner.py values <name> [--profile P]
+      Print a dimension or top-level value, space separated (for the shell scripts)
+  sudo python3 MT25033_Part_C_Runner.py run [--profile P] [--seed N] [--dry-run]
+                                            [--resume TS] [--attempts N] [--retry-budget N]
+      Run every job through 'MT25033_Part_C_Experiment.sh --job'
+All modes take --spec <file> (default MT25033_Part_C_Spec.json).
+
+A run journals every job as it completes or fails, in the experiment
+script's journal (results/MT25033_Part_B_Journal_<timestamp>.log, keys
+"job:<id>"). '--resume <timestamp>' continues that run: completed jobs are
+skipped and failed ones run again. Job ids depend only on the point, so
+points added to the spec since are run too. A failed job goes to the back
+of the queue, is tried at most --attempts times over all resumes, and one
+invocation retries at most --retry-budget times in total.
+
+  sudo python3 MT25033_Part_C_Runner.py tune [--size N] [--objective COL] [--minimize]
+                                             [--constraint EXPR ...] [--budget MIN] [--dry-run]
+      Search the knobs of the spec's "tune" section (engine, queue-depth
+      batch target, socket buffer sysctls, threads, core affinity) at one
+      message size with successive halving: every sampled configuration
+      runs for min_duration seconds, the best 1/eta go on to a run eta
+      times longer, and so on until one is left. The objective is any
+      numeric column of the results CSV (default gbps_per_core); rows that
+      break a constraint (default p99_us <= 2000) rank below all others.
+      As many configurations are sampled as the budget (minutes) allows.
+      Every trial goes to results/MT25033_Part_B_Tune_<timestamp>.csv; the
+      winner and its evidence to ..._best.json.
+
+  sudo python3 MT25033_Part_C_Runner.py slo [--percentile p99_us|p999_us] [--target US]
+                                            [--search binary|ramp] [--dry-run]
+      Capacity under a latency SLO, per engine and message size of the
+      spec's "slo" section. The servers run open loop (-O): messages start
+      on a fixed schedule and latency counts from the scheduled start, so
+      queueing behind a saturated sender is measured, not hidden. The
+      offered rate (messages/s over all connections) ramps up by
+      ramp_factor from rate_min; "binary" then bisects between the last
+      rate that held and the first that did not, down to "precision". A
+      rate holds if the percentile stays within the target and the clients
+      receive at least keep_up of the offered rate. Every trial (the
+      latency-throughput curve) goes to results/MT25033_Part_B_SLO_<timestamp>.csv
+      and the capacities to ..._capacity.csv.
+"""
+
+import argparse
+import csv
+import hashlib
+import itertools
+import json
+import os
+import random
+import subprocess
+import sys
+import time
+
+# ============================================================================
+# CONFIGURATION
+# ============================================================================
+
+SPEC_FILE = "MT25033_Part_C_Spec.json"
+EXPERIMENT = ["bash", "MT25033_Part_C_Experiment.sh"]
+OUTPUT_DIR = "results"
+JOURNAL = OUTPUT_DIR + "/MT25033_Part_B_Journal_{}.log"
+MAX_ATTEMPTS = 3
+RETRY_BUDGET = 20
+
+# Seconds per run on top of its duration (server start, client exit, pause)
+RUN_OVERHEAD = 5
+
+# Dimensions in job order; repeats is a count, not a list
+DIMENSIONS = ['engine', 'transport', 'size', 'threads', 'connections', 'topology', 'sysctls']
+TRANSPORTS = ['tcp', 'tcp6', 'tcp46']
+TOPOLOGIES = ['veth', 'loopback']
+
+# ============================================================================
+# SPEC
+# ============================================================================
+
+def load_spec(path, profile=None):
+    """Spec with the profile's overrides applied."""
+    with open(path) as f:
+        spec = json.load(f)
+
+    if profile:
+        profiles = spec.get('profiles', {})
+        if profile not in profiles:
+            raise ValueError(f"unknown profile '{profile}' (have: {', '.join(profiles) or 'none'})")
+        for key, value in profiles[profile].items():
+            if key == 'dimensions':
+                spec['dimensions'] = {**spec['dimensions'], **value}
+            else:
+                spec[key] = value
+
+    check_spec(spec)
+    return spec
+
+
+def check_spec(spec):
+    """Reject names the experiment script cannot run."""
+    dims = spec.get('dimensions', {})
+    missing = [d for d in DIMENSIONS + ['repeats'] if d not in dims]
+    if missing:
+        raise ValueError(f"spec lacks dimension(s): {', '.join(missing)}")
+    for d in DIMENSIONS:
+        if not isinstance(dims[d], list) or not dims[d]:
+            raise ValueError(f"dimension '{d}' must be a non-empty list")
+
+    known = {
+        'engine': spec.get('engines', {}),
+        'transport': TRANSPORTS,
+        'topology': TOPOLOGIES,
+        'sysctls': spec.get('sysctl_sets', {}),
+    }
+    for d, allowed in known.items():
+        for v in dims[d]:
+            if v not in allowed:
+                raise ValueError(f"unknown {d} '{v}' (have: {', '.join(allowed)})")
+    for d in ('size', 'threads', 'connections'):
+        for v in dims[d]:
+            if not isinstance(v, int) or v <= 0:
+                raise ValueError(f"{d} values must be positive integers, got {v!r}")
+    if not isinstance(dims['repeats'], int) or dims['repeats'] < 1:
+        raise ValueError("repeats must be a positive integer")
+
+
+def job_key(point):
+    """Stable identifier of a point (same dimensions -> same key)."""
+    text = json.dumps([point[d] for d in DIMENSIONS])
+    return hashlib.sha1(text.encode()).hexdigest()[:10]
+
+
+def expand(spec, seed=None):
+    """
+    Job list: cartesian product of the dimensions, filtered by the
+    constraints, deduplicated, repeated and shuffled.
+    Returns (jobs, stats) with stats = (product size, rejected, duplicates).
+    """
+    dims = spec['dimensions']
+    constraints = spec.get('constraints', [])
+    compiled = [(c, compile(c, '<constraint>', 'eval')) for c in constraints]
+
+    points = []
+    seen = set()
+    total = rejected = duplicates = 0
+    for values in itertools.product(*(dims[d] for d in DIMENSIONS)):
+        total += 1
+        point = dict(zip(DIMENSIONS, values))
+        try:
+            ok = all(eval(code, {'__builtins__': {}}, dict(point)) for _, code in compiled)
+        except Exception as e:
+            raise ValueError(f"constraint failed on {point}: {e}")
+        if not ok:
+            rejected += 1
+            continue
+        key = job_key(point)
+        if key in seen:
+            duplicates += 1
+            continue
+        seen.add(key)
+        points.append(point)
+
+    jobs = []
+    for point in points:
+        for rep in range(dims['repeats']):
+            job = dict(point)
+            job['repeat'] = rep
+            job['key'] = job_key(point)
+            job['id'] = f"{job['key']}_r{rep}"
+            jobs.append(job)
+
+    random.Random(spec.get('seed', 0) if seed is None else seed).shuffle(jobs)
+    return jobs, (total, rejected, duplicates)
+
+
+def variant_label(job):
+    """Variant column of the results CSV: everything not already a column."""
+    label = f"{job['topology']}_{job['sysctls']}_c{job['connections']}"
+    if job['transport'] != 'tcp':
+        label += f"_{job['transport']}"
+    return label
+
+
+def connect_address(job):
+    """Address the clients of a job connect to (as set_transport picks it)."""
+    loopback = job['topology'] == 'loopback'
+    if job['transport'] == 'tcp6':
+        return '::1' if loopback else 'fd00::1'
+    return '127.0.0.1' if loopback else '10.0.0.1'
+
+
+def job_command(spec, job, variant=None):
+    """Argument list of 'MT25033_Part_C_Experiment.sh --job' for one job."""
+    engine = spec['engines'][job['engine']]
+    args = EXPERIMENT + ['--job', job['engine'], engine['server'], engine['client'],
+                         job['transport'], str(job['size']), str(job['threads']),
+                         str(job['connections']), job['topology'], variant or variant_label(job),
+                         job['id']]
+    for key, value in spec['sysctl_sets'][job['sysctls']].items():
+        args.append(f"{key}={value}")
+    return args
+
+# ============================================================================
+# JOURNAL
+# ============================================================================
+
+def read_journal(path):
+    """Completed job ids and failed attempts per job id from a journal."""
+    done, failures = set(), {}
+    if not os.path.exists(path):
+        return done, failures
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) < 3 or not fields[2].startswith('job:'):
+                continue
+            job_id = fields[2][4:]
+            if fields[1] == 'done':
+                done.add(job_id)
+            elif fields[1] == 'fail':
+                failures[job_id] = failures.get(job_id, 0) + 1
+    return done, failures
+
+
+def journal_add(path, status, job_id, attempt):
+    """Same line format as the experiment script: <epoch> <status> <key> <attempt>."""
+    with open(path, 'a') as f:
+        f.write(f"{int(time.time())} {status} job:{job_id} {attempt}\n")
+        f.flush()
+        os.fsync(f.fileno())
+
+# ============================================================================
+# AUTO-TUNING
+# ============================================================================
+
+def tune_space(tune):
+    """All knob combinations; core types the machine lacks are dropped."""
+    knobs = dict(tune['knobs'])
+    if 'affinity' in knobs and not os.path.isdir('/sys/devices/cpu_atom'):
+        kept = [a for a in knobs['affinity'] if a not in ('core', 'atom', 'p', 'e')]
+        if len(kept) < len(knobs['affinity']):
+            print("[WARN] Not a hybrid CPU: affinity core/atom dropped")
+        knobs['affinity'] = kept or ['any']
+    names = list(knobs)
+    return [dict(zip(names, values)) for values in itertools.product(*(knobs[n] for n in names))]
+
+
+def tune_plan(n, tune):
+    """Rungs of successive halving from n configurations: [(configs, duration)]."""
+    rungs = []
+    duration = tune['min_duration']
+    while True:
+        rungs.append((n, duration))
+        if n == 1:
+            return rungs
+        n = max(1, -(-n // tune['eta']))
+        longer = min(duration * tune['eta'], tune['max_duration'])
+        if n == 1 and longer == duration:
+            return rungs            # Rerunning the winner would add nothing
+        duration = longer
+
+
+def tune_cost(n, tune):
+    return sum(k * (d + RUN_OVERHEAD) for k, d in tune_plan(n, tune))
+
+
+def config_id(config):
+    return hashlib.sha1(json.dumps(config, sort_keys=True).encode()).hexdigest()[:8]
+
+
+def config_job(spec, tune, config, rung):
+    """A config as a job of the experiment script, plus its program options."""
+    job = {'engine': config.get('engine', 'two_copy'), 'transport': 'tcp', 'size': tune['size'],
+           'threads': config.get('threads', 1), 'topology': tune.get('topology', 'veth'),
+           'sysctls': config.get('sysctls', 'default')}
+    job['connections'] = job['threads']
+    job['id'] = f"tune_{config_id(config)}_r{rung}"
+
+    server_opts, client_opts = [], []
+    if config.get('qdepth'):
+        server_opts.append(f"-Q {config['qdepth']}")
+    if config.get('affinity', 'any') != 'any':
+        server_opts.append(f"-A {config['affinity']}")
+        client_opts.append(f"-A {config['affinity']}")
+    return job, " ".join(server_opts), " ".join(client_opts)
+
+
+def numeric_row(row):
+    """CSV row with numbers converted; empty fields become None."""
+    out = {}
+    for key, value in row.items():
+        try:
+            out[key] = float(value) if value not in ('', None) else None
+        except ValueError:
+            out[key] = value
+    return out
+
+
+def result_row(path, variant, **match):
+    """Last results row of a variant, optionally also matching other columns
+    (None if the run left none)."""
+    if not os.path.exists(path):
+        return None
+    with open(path) as f:
+        rows = [r for r in csv.DictReader(f) if r.get('variant') == variant and
+                all(r.get(k) == str(v) for k, v in match.items())]
+    return numeric_row(rows[-1]) if rows else None
+
+
+def score(trial, tune):
+    """Sort key: feasible first, then by objective (missing = worst)."""
+    value = trial['objective']
+    if value is None:
+        return (0, 0, float('-inf'))
+    return (1, 1 if trial['feasible'] else 0, value if tune['maximize'] else -value)
+
+
+def cmd_tune(spec, args):
+    tune = dict(spec.get('tune', {}))
+    if not tune.get('knobs'):
+        print("[ERROR] Spec has no \"tune\" section with knobs")
+        return 1
+    for key, value in (('size', args.size), ('objective', args.objective),
+                       ('budget_min', args.budget)):
+        if value is not None:
+            tune[key] = value
+    if args.minimize:
+        tune['maximize'] = False
+    tune['constraints'] = tune.get('constraints', []) + (args.constraint or [])
+    tune.setdefault('maximize', True)
+    tune.setdefault('eta', 3)
+    tune.setdefault('min_duration', 2)
+    tune.setdefault('max_duration', 10)
+    tune.setdefault('budget_min', 30)
+    if tune['eta'] < 2:
+        print("[ERROR] eta must be at least 2")
+        return 1
+    for name in ('engine', 'sysctls'):
+        table = spec['engines'] if name == 'engine' else spec['sysctl_sets']
+        for value in tune['knobs'].get(name, []):
+            if value not in table:
+                print(f"[ERROR] Unknown {name} '{value}' in tune knobs")
+                return 1
+    constraints = [(c, compile(c, '<constraint>', 'eval')) for c in tune['constraints']]
+
+    # As many configurations as fit the budget
+    space = tune_space(tune)
+    budget_s = tune['budget_min'] * 60
+    n = 1
+    while n < len(space) and tune_cost(n + 1, tune) <= budget_s:
+        n += 1
+    rng = random.Random(spec.get('seed', 0) if args.seed is None else args.seed)
+    configs = rng.sample(space, n)
+
+    goal = f"{'max' if tune['maximize'] else 'min'} {tune['objective']}"
+    if constraints:
+        goal += " subject to " + " and ".join(c for c, _ in constraints)
+    print(f"[INFO] Tuning size={tune['size']}: {goal}")
+    print(f"[INFO] {n} of {len(space)} configurations; rungs (configs x seconds): " +
+          ", ".join(f"{k}x{d}" for k, d in tune_plan(n, tune)) +
+          f"; ~{tune_cost(n, tune) // 60} of {tune['budget_min']} min")
+    if args.dry_run:
+        for config in configs:
+            job, server_opts, client_opts = config_job(spec, tune, config, 0)
+            print(f"  {config_id(config)} {json.dumps(config)}  server: '{server_opts}' client: '{client_opts}'")
+        return 0
+
+    if os.geteuid() != 0:
+        print("[ERROR] Must be run as root for network namespaces and perf")
+        return 1
+    if subprocess.run(['make', 'all'], stdout=subprocess.DEVNULL).returncode != 0:
+        print("[ERROR] Build failed")
+        return 1
+
+    timestamp = time.strftime('%Y%m%d_%H%M%S')
+    results = f"{OUTPUT_DIR}/MT25033_Part_B_Results_{timestamp}.csv"
+    evidence = f"{OUTPUT_DIR}/MT25033_Part_B_Tune_{timestamp}.csv"
+    metrics = ['throughput_gbps', 'cpu_cores', 'gbps_per_core', 'p99_us', 'latency_us']
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    with open(evidence, 'w') as f:
+        f.write("rung,duration,config," + ",".join(tune['knobs']) + "," + ",".join(metrics) +
+                ",objective,feasible,promoted\n")
+
+    history = {}
+    rung = 0
+    for count, duration in tune_plan(n, tune):
+        configs = configs[:count]
+        print(f"[INFO] Rung {rung}: {len(configs)} configurations x {duration} s")
+        env = dict(os.environ, TIMESTAMP=timestamp, DURATION=str(duration))
+        trials = []
+        for config in configs:
+            job, server_opts, client_opts = config_job(spec, tune, config, rung)
+            variant = f"tune_{config_id(config)}_d{duration}"
+            env['JOB_SERVER_OPTS'] = server_opts
+            env['JOB_CLIENT_OPTS'] = client_opts
+            ok = subprocess.run(job_command(spec, job, variant), env=env).returncode == 0
+            row = result_row(results, variant) if ok else None
+
+            trial = {'config': config, 'rung': rung, 'duration': duration, 'row': row,
+                     'objective': None, 'feasible': False}
+            if row and isinstance(row.get(tune['objective']), float):
+                trial['objective'] = row[tune['objective']]
+                try:
+                    trial['feasible'] = all(eval(code, {'__builtins__': {}}, dict(row))
+                                            for _, code in constraints)
+                except TypeError:
+                    trial['feasible'] = False   # A constrained column is empty
+            trials.append(trial)
+            history.setdefault(config_id(config), []).append(trial)
+
+        trials.sort(key=lambda t: score(t, tune), reverse=True)
+        keep = max(1, -(-len(trials) // tune['eta']))
+        with open(evidence, 'a') as f:
+            for i, t in enumerate(trials):
+                row = t['row'] or {}
+                fields = [rung, duration, config_id(t['config'])] + \
+                         [t['config'].get(k, '') for k in tune['knobs']] + \
+                         ['' if row.get(m) is None else row[m] for m in metrics] + \
+                         ['' if t['objective'] is None else t['objective'],
+                          int(t['feasible']), int(i < keep and len(trials) > 1)]
+                f.write(",".join(str(v) for v in fields) + "\n")
+        for t in trials[:keep]:
+            print(f"[INFO]   {config_id(t['config'])} {tune['objective']}={t['objective']}"
+                  f"{'' if t['feasible'] else ' (infeasible)'} {json.dumps(t['config'])}")
+        configs = [t['config'] for t in trials]
+        rung += 1
+
+    best = trials[0]
+    if best['objective'] is None:
+        print("[ERROR] No configuration produced a result")
+        return 1
+    job, server_opts, client_opts = config_job(spec, tune, best['config'], 0)
+    engine = spec['engines'][job['engine']]
+    summary = {
+        'size': tune['size'],
+        'goal': goal,
+        'feasible': best['feasible'],
+        'config': best['config'],
+        'server': f"./{engine['server']} -s {tune['size']} {server_opts}".strip(),
+        'client': f"./{engine['client']} -i {connect_address(job)} "
+                  f"-s {tune['size']} -t {job['threads']} {client_opts}".strip(),
+        'sysctls': spec['sysctl_sets'][job['sysctls']],
+        'evidence': [{'rung': t['rung'], 'duration': t['duration'],
+                      **{m: (t['row'] or {}).get(m) for m in metrics}}
+                     for t in history[config_id(best['config'])]],
+        'trials': evidence,
+        'results': results,
+    }
+    best_path = evidence[:-len('.csv')] + "_best.json"
+    with open(best_path, 'w') as f:
+        json.dump(summary, f, indent=2)
+
+    print("[INFO] ==========================================")
+    print(f"[INFO] Best{'' if best['feasible'] else ' (no configuration met the constraints)'}: "
+          f"{json.dumps(best['config'])}")
+    print(f"[INFO]   {tune['objective']} = {best['objective']} after {best['duration']} s")
+    print(f"[INFO]   Server: {summary['server']}")
+    print(f"[INFO]   Client: {summary['client']}")
+    print(f"[INFO] Trials: {evidence}")
+    print(f"[INFO] Best configuration and evidence: {best_path}")
+    return 0 if best['feasible'] else 1
+
+# ============================================================================
+# SLO CAPACITY
+# ============================================================================
+
+def slo_trial(spec, slo, engine, size, rate, timestamp):
+    """Run one open-loop point; returns the trial dict (row None if it failed)."""
+    conns = slo['connections']
+    job = {'engine': engine, 'transport': 'tcp', 'size': size, 'threads': conns,
+           'connections': conns, 'topology': slo.get('topology', 'veth'), 'sysctls': 'default'}
+    job['id'] = f"slo_{job_key(job)}_{rate}"
+    variant = f"slo_r{rate}"
+    env = dict(os.environ, TIMESTAMP=timestamp, DURATION=str(slo['duration']),
+               JOB_SERVER_OPTS=f"-O {rate / conns:g}", JOB_CLIENT_OPTS="-m")
+    ok = subprocess.run(job_command(spec, job, variant), env=env).returncode == 0
+    results = f"{OUTPUT_DIR}/MT25033_Part_B_Results_{timestamp}.csv"
+    row = result_row(results, variant, implementation=engine, msg_size=size) if ok else None
+
+    trial = {'engine': engine, 'size': size, 'offered': rate, 'row': row, 'holds': False}
+    if row is None:
+        trial['reason'] = 'run failed'
+        return trial
+    latency, achieved = row.get(slo['percentile']), row.get('msg_rate')
+    if not isinstance(latency, float) or not isinstance(achieved, float):
+        trial['reason'] = 'no latency or rate recorded'
+    elif achieved < slo['keep_up'] * rate:
+        trial['reason'] = f"received {achieved:.0f} msg/s"
+    elif latency > slo['target_us']:
+        trial['reason'] = f"{slo['percentile']} {latency:.0f} µs"
+    else:
+        trial['holds'] = True
+        trial['reason'] = ''
+    return trial
+
+
+def slo_search(spec, slo, engine, size, timestamp, log):
+    """Highest offered rate that holds the SLO, and how exact it is."""
+    def run(rate):
+        rate = int(rate)
+        t = slo_trial(spec, slo, engine, size, rate, timestamp)
+        log(t)
+        row = t['row'] or {}
+        print(f"[INFO]   {engine} {size} B @ {rate} msg/s: "
+              f"{slo['percentile']}={row.get(slo['percentile'])} µs, received {row.get('msg_rate')} msg/s "
+              f"-> {'holds' if t['holds'] else 'violates (' + t['reason'] + ')'}", flush=True)
+        return t
+
+    # Ramp up until the SLO breaks
+    best, rate = None, slo['rate_min']
+    while rate <= slo['rate_max']:
+        t = run(rate)
+        if not t['holds']:
+            break
+        best = t
+        rate = max(rate + 1, int(rate * slo['ramp_factor']))
+    else:
+        return best, 'at least rate_max'
+    if best is None:
+        return None, 'below rate_min'
+    if slo['search'] == 'ramp':
+        return best, f"within x{slo['ramp_factor']}"
+
+    # Bisect between the last rate that held and the first that did not
+    lo, hi = best['offered'], int(rate)
+    while hi > lo * (1 + slo['precision']) and hi - lo > 1:
+        mid = (lo + hi) // 2
+        t = run(mid)
+        if t['holds']:
+            lo, best = mid, t
+        else:
+            hi = mid
+    return best, f"within {slo['precision']:.0%}"
+
+
+def cmd_slo(spec, args):
+    slo = dict(spec.get('slo', {}))
+    for key, value in (('percentile', args.percentile), ('target_us', args.target),
+                       ('search', args.search)):
+        if value is not None:
+            slo[key] = value
+    defaults = {'engines': ['two_copy', 'one_copy', 'zero_copy'], 'sizes': [1024], 'connections': 1,
+                'percentile': 'p99_us', 'target_us': 1000, 'search': 'binary', 'rate_min': 1000,
+                'rate_max': 1000000, 'ramp_factor': 2, 'precision': 0.05, 'keep_up': 0.95,
+                'duration': 5, 'topology': 'veth'}
+    for key, value in defaults.items():
+        slo.setdefault(key, value)
+    if slo['percentile'] not in ('p50_us', 'p99_us', 'p999_us'):
+        print("[ERROR] percentile must be p50_us, p99_us or p999_us")
+        return 1
+    if slo['search'] not in ('binary', 'ramp') or slo['ramp_factor'] <= 1 or slo['rate_min'] < 1:
+        print("[ERROR] search must be binary or ramp, with ramp_factor > 1 and rate_min >= 1")
+        return 1
+    for engine in slo['engines']:
+        if engine not in spec['engines']:
+            print(f"[ERROR] Unknown engine '{engine}' in slo")
+            return 1
+
+    ramp = []
+    rate = slo['rate_min']
+    while rate <= slo['rate_max']:
+        ramp.append(rate)
+        rate = max(rate + 1, int(rate * slo['ramp_factor']))
+    print(f"[INFO] Capacity at {slo['percentile']} <= {slo['target_us']} µs, "
+          f"{slo['connections']} connection(s), {slo['duration']} s per rate, {slo['search']} search")
+    print(f"[INFO] Ramp (msg/s): {' '.join(str(r) for r in ramp)}")
+    print(f"[INFO] {len(slo['engines'])} engines x {len(slo['sizes'])} sizes, at most "
+          f"~{len(slo['engines']) * len(slo['sizes']) * len(ramp) * (slo['duration'] + RUN_OVERHEAD) // 60} "
+          f"min for the ramps")
+    if args.dry_run:
+        return 0
+
+    if os.geteuid() != 0:
+        print("[ERROR] Must be run as root for network namespaces and perf")
+        return 1
+    if subprocess.run(['make', 'all'], stdout=subprocess.DEVNULL).returncode != 0:
+        print("[ERROR] Build failed")
+        return 1
+
+    timestamp = time.strftime('%Y%m%d_%H%M%S')
+    curve = f"{OUTPUT_DIR}/MT25033_Part_B_SLO_{timestamp}.csv"
+    capacity = curve[:-len('.csv')] + "_capacity.csv"
+    metrics = ['msg_rate', 'throughput_gbps', 'p50_us', 'p99_us', 'p999_us', 'cpu_cores']
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    with open(curve, 'w') as f:
+        f.write("engine,msg_size,connections,offered_rate," + ",".join(metrics) + ",holds,reason\n")
+
+    def log(t):
+        row = t['row'] or {}
+        with open(curve, 'a') as f:
+            f.write(",".join(str(v) for v in [t['engine'], t['size'], slo['connections'], t['offered']] +
+                             ['' if row.get(m) is None else row[m] for m in metrics] +
+                             [int(t['holds']), t['reason'].replace(',', ';')]) + "\n")
+
+    found = []
+    for engine in slo['engines']:
+        for size in slo['sizes']:
+            print(f"[INFO] Searching {engine}, {size} B")
+            best, bound = slo_search(spec, slo, engine, size, timestamp, log)
+            found.append((engine, size, best, bound))
+
+    with open(capacity, 'w') as f:
+        f.write(f"engine,msg_size,connections,percentile,target_us,capacity_msgs,capacity_gbps,"
+                f"latency_us,bound\n")
+        for engine, size, best, bound in found:
+            row = (best or {}).get('row') or {}
+            f.write(f"{engine},{size},{slo['connections']},{slo['percentile']},{slo['target_us']},"
+                    f"{best['offered'] if best else 0},{row.get('throughput_gbps', '')},"
+                    f"{row.get(slo['percentile'], '')},{bound}\n")
+
+    print("[INFO] ==========================================")
+    print(f"[INFO] Capacity at {slo['percentile']} <= {slo['target_us']} µs:")
+    for engine, size, best, bound in found:
+        if best:
+            row = best['row']
+            print(f"[INFO]   {engine:<18} {size:>8} B: {best['offered']:>9} msg/s "
+                  f"({row.get('throughput_gbps')} Gbps, {slo['percentile']} {row.get(slo['percentile'])} µs), {bound}")
+        else:
+            print(f"[INFO]   {engine:<18} {size:>8} B: none ({bound})")
+    print(f"[INFO] Latency-throughput curve: {curve}")
+    print(f"[INFO] Capacities: {capacity}")
+    return 0
+
+# ============================================================================
+# MODES
+# ============================================================================
+
+def cmd_expand(spec, seed):
+    jobs, (total, rejected, duplicates) = expand(spec, seed)
+    print("id," + ",".join(DIMENSIONS) + ",repeat,variant")
+    for job in jobs:
+        print(",".join([job['id']] + [str(job[d]) for d in DIMENSIONS] +
+                       [str(job['repeat']), variant_label(job)]))
+    print(f"# {len(jobs)} jobs: {total} points, {rejected} rejected by constraints, "
+          f"{duplicates} duplicates, {spec['dimensions']['repeats']} repeat(s)", file=sys.stderr)
+
+
+def cmd_values(spec, name):
+    if name in spec['dimensions']:
+        value = spec['dimensions'][name]
+    elif name in spec and not isinstance(spec[name], dict):
+        value = spec[name]
+    else:
+        raise ValueError(f"no dimension or value '{name}' in spec")
+    print(" ".join(str(v) for v in value) if isinstance(value, list) else value)
+
+
+def cmd_run(spec, seed, dry_run, resume=None, attempts=MAX_ATTEMPTS, budget=RETRY_BUDGET):
+    jobs, (total, rejected, duplicates) = expand(spec, seed)
+    print(f"[INFO] {len(jobs)} jobs ({total} points, {rejected} rejected, {duplicates} duplicates), "
+          f"~{len(jobs) * (spec['duration'] + RUN_OVERHEAD) // 60} min")
+
+    if dry_run:
+        for job in jobs:
+            print(" ".join(job_command(spec, job)))
+        return 0
+
+    if os.geteuid() != 0:
+        print("[ERROR] Must be run as root for network namespaces and perf")
+        return 1
+    if subprocess.run(['make', 'all'], stdout=subprocess.DEVNULL).returncode != 0:
+        print("[ERROR] Build failed")
+        return 1
+
+    # One timestamp, so every job appends to the same result files
+    env = dict(os.environ)
+    env['TIMESTAMP'] = resume or time.strftime('%Y%m%d_%H%M%S')
+    env['DURATION'] = str(spec['duration'])
+    journal = JOURNAL.format(env['TIMESTAMP'])
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+
+    done, failures = read_journal(journal)
+    if resume:
+        if not os.path.exists(journal):
+            print(f"[ERROR] No journal {journal} to resume from")
+            return 1
+        print(f"[INFO] Resuming {resume}: {sum(j['id'] in done for j in jobs)} of {len(jobs)} jobs done")
+
+    queue = [j for j in jobs if j['id'] not in done]
+    given_up = [j['id'] for j in queue if failures.get(j['id'], 0) >= attempts]
+    queue = [j for j in queue if failures.get(j['id'], 0) < attempts]
+    for job_id in given_up:
+        print(f"[WARN] Job {job_id} already failed {attempts} times, skipping")
+
+    ran = 0
+    while queue:
+        job = queue.pop(0)
+        attempt = failures.get(job['id'], 0) + 1
+        ran += 1
+        print(f"[INFO] Job {ran} ({len(queue)} queued): {job['id']} {job['engine']} size={job['size']} "
+              f"threads={job['threads']} connections={job['connections']} "
+              f"{job['topology']} {job['sysctls']}" + (f", attempt {attempt}" if attempt > 1 else ""),
+              flush=True)
+        if subprocess.run(job_command(spec, job), env=env).returncode == 0:
+            journal_add(journal, 'done', job['id'], attempt)
+            continue
+
+        journal_add(journal, 'fail', job['id'], attempt)
+        failures[job['id']] = attempt
+        if attempt >= attempts:
+            print(f"[WARN] Job {job['id']} failed {attempt} times, giving up on it")
+            given_up.append(job['id'])
+        elif budget <= 0:
+            print(f"[WARN] Job {job['id']} failed, retry budget used up")
+            given_up.append(job['id'])
+        else:
+            budget -= 1
+            print(f"[WARN] Job {job['id']} failed, retrying later ({budget} retries left)")
+            queue.append(job)
+
+    print(f"[INFO] Results saved to: {OUTPUT_DIR}/MT25033_Part_B_Results_{env['TIMESTAMP']}.csv")
+    print(f"[INFO] Journal: {journal}")
+    if given_up:
+        print(f"[WARN] {len(given_up)} job(s) without a result: {' '.join(given_up)}")
+        print(f"[WARN] Resume with the same spec options and --resume {env['TIMESTAMP']}")
+    return 1 if given_up else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Expand and run the PA02 sweep spec")
+    parser.add_argument('mode', choices=['expand', 'values', 'run', 'tune', 'slo'])
+    parser.add_argument('name', nargs='?', help="dimension or value name (values mode)")
+    parser.add_argument('--spec', default=SPEC_FILE)
+    parser.add_argument('--profile')
+    parser.add_argument('--seed', type=int, help="shuffle seed (default: the spec's)")
+    parser.add_argument('--dry-run', action='store_true', help="print the job commands only")
+    parser.add_argument('--resume', metavar='TIMESTAMP', help="continue the run with this timestamp")
+    parser.add_argument('--attempts', type=int, default=MAX_ATTEMPTS,
+                        help=f"attempts per job over all resumes (default {MAX_ATTEMPTS})")
+    parser.add_argument('--retry-budget', type=int, default=RETRY_BUDGET,
+                        help=f"retries per invocation (default {RETRY_BUDGET})")
+    parser.add_argument('--size', type=int, help="message size to tune for")
+    parser.add_argument('--objective', help="results column to optimise (tune)")
+    parser.add_argument('--minimize', action='store_true', help="minimise the objective (tune)")
+    parser.add_argument('--constraint', action='append', help="extra constraint on a result row (tune)")
+    parser.add_argument('--budget', type=float, help="tuning budget in minutes")
+    parser.add_argument('--percentile', help="latency column the SLO limits (slo)")
+    parser.add_argument('--target', type=float, help="SLO latency target in µs (slo)")
+    parser.add_argument('--search', choices=['binary', 'ramp'], help="capacity search (slo)")
+    args = parser.parse_args()
+
+    try:
+        spec = load_spec(args.spec, args.profile)
+        if args.mode == 'expand':
+            cmd_expand(spec, args.seed)
+        elif args.mode == 'values':
+            if not args.name:
+                parser.error("values needs a name")
+            cmd_values(spec, args.name)
+        elif args.mode == 'tune':
+            return cmd_tune(spec, args)
+        elif args.mode == 'slo':
+            return cmd_slo(spec, args)
+        else:
+            return cmd_run(spec, args.seed, args.dry_run, args.resume, args.attempts,
+                           args.retry_budget)
+    except (OSError, ValueError) as e:
+        print(f"{os.path.basename(sys.argv[0])}: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,223 @@
+#!/bin/bash
+# MT25033
+# MT25033_Part_C_Soak.sh
+# Long-duration soak test with resource snapshots and leak detection
+# Roll Number: MT25033
+#
+# This script:
+# 1. Sets up the network namespaces
+# 2. Runs each server (A1/A2/A3) for hours with resource snapshots (-S)
+# 3. Keeps reconnecting clients in rounds, cycling thread counts, so
+#    connection setup/teardown is exercised throughout
+# 4. Stores every SNAP: line (interval throughput, RSS, open fds, threads,
+#    zero-copy bytes still pinned, active connections) in CSV format
+# 5. Flags metrics that keep growing: after a warm-up of one full cycle of
+#    client rounds (allocator arenas and thread stacks settle there), a
+#    metric is flagged when its minimum over the last quarter of the run is
+#    above its maximum over the first quarter, which a steady server never does
+#
+# Usage: sudo ./MT25033_Part_C_Soak.sh [hours] [impl ...]
+#   hours  Soak length per server (default: 2; SOAK_SECONDS overrides)
+#   impl   two_copy, one_copy and/or zero_copy (default: all three)
+
+set -e  # Exit on error
+
+# Configuration
+SOAK_HOURS=${1:-2}                    # Hours per server
+SOAK_SECONDS=${SOAK_SECONDS:-$((SOAK_HOURS * 3600))}
+SNAP_INTERVAL=${SNAP_INTERVAL:-10}    # Seconds between snapshots
+ROUND_DURATION=30                     # Seconds per client round
+ROUND_GAP=2                           # Idle seconds between rounds
+PORT=8080                             # Server port
+SERVER_IP="10.0.0.1"                  # Server IP in namespace
+CLIENT_IP="10.0.0.2"                  # Client IP in namespace
+
+# The server fixes the message size; client rounds cycle the thread count
+MSG_SIZE=65536
+THREAD_COUNTS=(1 2 4 8)
+
+# Snapshots ignored by the growth check: one full cycle of rounds
+WARMUP_SECONDS=$(( ${#THREAD_COUNTS[@]} * (ROUND_DURATION + ROUND_GAP) ))
+
+# Output directory for results
+OUTPUT_DIR="results"
+TIMESTAMP=$(date +%Y%m%d_%H%M%S)
+CSV_FILE="${OUTPUT_DIR}/MT25033_Part_B_Soak_${TIMESTAMP}.csv"
+FLAG_FILE="${OUTPUT_DIR}/MT25033_Part_B_Soak_${TIMESTAMP}_flags.txt"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+log_info() {
+    echo -e "${GREEN}[INFO]${NC} $1"
+}
+
+log_warn() {
+    echo -e "${YELLOW}[WARN]${NC} $1"
+}
+
+log_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+# Check if running as root (needed for namespaces)
+check_root() {
+    if [ "$EUID" -ne 0 ]; then
+        log_error "This script must be run as root for network namespaces"
+        log_info "Usage: sudo $0 [hours] [impl ...]"
+        exit 1
+    fi
+}
+
+# Set up network namespaces
+setup_namespaces() {
+    log_info "Setting up network namespaces..."
+
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+
+    ip netns add server_ns
+    ip netns add client_ns
+
+    ip link add veth-server type veth peer name veth-client
+
+    ip link set veth-server netns server_ns
+    ip link set veth-client netns client_ns
+
+    ip netns exec server_ns ip addr add ${SERVER_IP}/24 dev veth-server
+    ip netns exec server_ns ip link set veth-server up
+    ip netns exec server_ns ip link set lo up
+
+    ip netns exec client_ns ip addr add ${CLIENT_IP}/24 dev veth-client
+    ip netns exec client_ns ip link set veth-client up
+    ip netns exec client_ns ip link set lo up
+
+    log_info "Network namespaces configured"
+}
+
+# Clean up network namespaces
+cleanup_namespaces() {
+    log_info "Cleaning up network namespaces..."
+    ip netns del server_ns 2>/dev/null || true
+    ip netns del client_ns 2>/dev/null || true
+}
+
+# Initialize CSV file with headers
+init_csv() {
+    mkdir -p ${OUTPUT_DIR}
+    echo "implementation,t_sec,gbps,rss_kb,open_fds,threads,zc_outstanding_bytes,active_conns" > ${CSV_FILE}
+    : > ${FLAG_FILE}
+    log_info "CSV file initialized: ${CSV_FILE}"
+}
+
+# Flag metrics whose last-quarter minimum exceeds their first-quarter maximum
+# Columns (SNAP order): 1 t_sec, 2 gbps, 3 rss_kb, 4 open_fds, 5 threads, 6 zc_outstanding_bytes
+check_growth() {
+    local impl_name=$1
+    local snap_file=$2
+
+    awk -F',' -v impl="${impl_name}" -v warmup=${WARMUP_SECONDS} '
+        $1 >= warmup { n++; for (c = 3; c <= 6; c++) v[n, c] = $c }
+        END {
+            split("rss_kb open_fds threads zc_outstanding_bytes", name, " ")
+            if (n < 8) {
+                printf "%s: only %d snapshots after warm-up, too few to judge growth\n", impl, n
+                exit
+            }
+            q = int(n / 4)
+            flagged = 0
+            for (c = 3; c <= 6; c++) {
+                first_max = v[1, c]; last_min = v[n, c]
+                for (i = 1; i <= q; i++) if (v[i, c] > first_max) first_max = v[i, c]
+                for (i = n - q + 1; i <= n; i++) if (v[i, c] < last_min) last_min = v[i, c]
+                if (last_min > first_max) {
+                    printf "%s: GROWING %s (first quarter max %s, last quarter min %s)\n",
+                           impl, name[c - 2], first_max, last_min
+                    flagged = 1
+                }
+            }
+            if (!flagged) printf "%s: steady (%d snapshots)\n", impl, n
+        }' ${snap_file} | tee -a ${FLAG_FILE}
+}
+
+# Soak one server with rounds of reconnecting clients
+run_soak() {
+    local impl_name=$1
+    local server_bin=$2
+    local client_bin=$3
+
+    local server_output="${OUTPUT_DIR}/soak_server_${impl_name}.txt"
+    local client_output="${OUTPUT_DIR}/soak_client_${impl_name}.txt"
+    local snap_file="${OUTPUT_DIR}/soak_snap_${impl_name}.txt"
+
+    log_info "Soaking ${impl_name} for ${SOAK_SECONDS}s (snapshots every ${SNAP_INTERVAL}s)"
+
+    # One server process handles every round
+    ip netns exec server_ns ./${server_bin} -p ${PORT} -s ${MSG_SIZE} -d ${SOAK_SECONDS} \
+        -S ${SNAP_INTERVAL} > ${server_output} 2>&1 &
+    local server_pid=$!
+    sleep 1
+
+    local end=$((SECONDS + SOAK_SECONDS - ROUND_DURATION))
+    local round=0
+    : > ${client_output}
+    while [ ${SECONDS} -lt ${end} ]; do
+        local threads=${THREAD_COUNTS[$((round % ${#THREAD_COUNTS[@]}))]}
+        ip netns exec client_ns ./${client_bin} -i ${SERVER_IP} -p ${PORT} -s ${MSG_SIZE} \
+            -t ${threads} -d ${ROUND_DURATION} >> ${client_output} 2>&1 || true
+        round=$((round + 1))
+        sleep ${ROUND_GAP}
+    done
+    log_info "  ${round} client rounds completed"
+
+    wait ${server_pid} 2>/dev/null || true
+
+    grep "^SNAP:" ${server_output} | sed 's/^SNAP: //' > ${snap_file} || true
+    sed "s/^/${impl_name},/" ${snap_file} >> ${CSV_FILE}
+    check_growth "${impl_name}" "${snap_file}"
+}
+
+# Main execution
+main() {
+    log_info "PA02: Soak test (leak detection over long runs)"
+    log_info "Roll Number: MT25033"
+    log_info "=========================================="
+
+    shift || true
+    local impls=("$@")
+    if [ ${#impls[@]} -eq 0 ]; then
+        impls=(two_copy one_copy zero_copy)
+    fi
+
+    check_root
+    make all > /dev/null
+    setup_namespaces
+    init_csv
+
+    for impl in "${impls[@]}"; do
+        case ${impl} in
+            two_copy)  run_soak two_copy MT25033_Part_A1_Server MT25033_Part_A1_Client ;;
+            one_copy)  run_soak one_copy MT25033_Part_A2_Server MT25033_Part_A2_Client ;;
+            zero_copy) run_soak zero_copy MT25033_Part_A3_Server MT25033_Part_A3_Client ;;
+            *) log_warn "Unknown implementation '${impl}', skipping" ;;
+        esac
+    done
+
+    log_info "=========================================="
+    log_info "Snapshots saved to: ${CSV_FILE}"
+    log_info "Growth check saved to: ${FLAG_FILE}"
+    log_info "=========================================="
+    if grep -q "GROWING" ${FLAG_FILE}; then
+        log_warn "Possible leak detected:"
+        grep "GROWING" ${FLAG_FILE}
+    fi
+}
+
+# Trap to ensure cleanup on exit
+trap cleanup_namespaces EXIT
+
+# Run main
+main "$@"
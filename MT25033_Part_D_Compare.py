@@ -0,0 +1,373 @@
+#!/usr/bin/env python3
+"""
+MT25033_Part_D_Compare.py
+Statistical A/B comparison of two result sets for PA02
+Roll Number: MT25033
+
+Compares a base and a new result set point by point. A point is a set of
+rows of MT25033_Part_B_Results_<timestamp>.csv with equal implementation,
+msg_size, threads, variant and build; its repeats are the samples. Key
+columns that hold one value in each set but a different one between them
+(two builds, two engines) are what is being compared, so they are left
+out of the key. For every point and metric:
+  - Mann-Whitney U test (exact for small samples without ties, normal
+    approximation with tie correction otherwise), two-sided;
+  - bootstrap 95% confidence interval of median(new) / median(base);
+  - p-values adjusted over all tests with Holm's method (--no-holm: raw).
+A change counts only if the adjusted p is below --alpha, the interval
+excludes 1 and the ratio differs from 1 by at least --min-effect.
+
+Metrics: throughput_gbps (higher is better), p99_us and cycles_per_byte
+(cycles / total_bytes, lower is better).
+
+Usage:
+  python3 MT25033_Part_D_Compare.py BASE.csv NEW.csv
+  python3 MT25033_Part_D_Compare.py RESULTS.csv --base implementation=two_copy \\
+                                                --new implementation=zero_copy
+  A set is a CSV path or a timestamp (results/MT25033_Part_B_Results_<ts>.csv).
+  --base / --new col=value (repeatable) keep only matching rows of a set.
+  --all prints every test, not only significant ones; --csv FILE writes them all.
+  --fail-on-regression exits with status 1 if any metric got significantly worse.
+"""
+
+import argparse
+import csv
+import math
+import os
+import random
+import sys
+
+# ============================================================================
+# CONFIGURATION
+# ============================================================================
+
+CSV_DIR = "results"
+KEY_COLUMNS = ['implementation', 'msg_size', 'threads', 'variant', 'build']
+
+# Metric -> True if higher is better
+METRICS = {'throughput_gbps': True, 'p99_us': False, 'cycles_per_byte': False}
+
+BOOTSTRAP_ROUNDS = 2000
+EXACT_LIMIT = 30            # Largest nA + nB for the exact U distribution
+SEED = 25033
+
+# ============================================================================
+# LOAD DATA
+# ============================================================================
+
+def resolve(name):
+    """A CSV path, or the results file of a timestamp."""
+    if os.path.exists(name):
+        return name
+    path = f"{CSV_DIR}/MT25033_Part_B_Results_{name}.csv"
+    if os.path.exists(path):
+        return path
+    raise FileNotFoundError(f"No result set '{name}' (nor {path})")
+
+
+def number(value):
+    try:
+        return float(value)
+    except (TypeError, ValueError):
+        return None
+
+
+def load_rows(path, filters):
+    """Rows of a results CSV matching every col=value filter, with derived metrics."""
+    with open(path) as f:
+        rows = list(csv.DictReader(f))
+    for col, value in filters:
+        if rows and col not in rows[0]:
+            raise KeyError(f"{path} has no column '{col}'")
+        rows = [r for r in rows if r.get(col) == value]
+    for r in rows:
+        cycles, total = number(r.get('cycles')), number(r.get('total_bytes'))
+        r['cycles_per_byte'] = cycles / total if cycles and total else None
+        for metric in METRICS:
+            if metric != 'cycles_per_byte':
+                r[metric] = number(r.get(metric))
+    return rows
+
+
+def parse_filters(items):
+    filters = []
+    for item in items or []:
+        if '=' not in item:
+            raise ValueError(f"Filter '{item}' is not col=value")
+        col, value = item.split('=', 1)
+        filters.append((col, value))
+    return filters
+
+
+def compared_columns(base, new):
+    """Key columns that are constant within each set but differ between them."""
+    out = []
+    for col in KEY_COLUMNS:
+        a = {r.get(col) for r in base}
+        b = {r.get(col) for r in new}
+        if len(a) == 1 and len(b) == 1 and a != b:
+            out.append(col)
+    return out
+
+
+def group(rows, key):
+    points = {}
+    for r in rows:
+        points.setdefault(tuple(r.get(c, '') for c in key), []).append(r)
+    return points
+
+# ============================================================================
+# STATISTICS
+# ============================================================================
+
+def median(xs):
+    s = sorted(xs)
+    n = len(s)
+    return s[n // 2] if n % 2 else (s[n // 2 - 1] + s[n // 2]) / 2
+
+
+def ranks(values):
+    """Mid-ranks (1-based) and the tie term sum(t^3 - t)."""
+    order = sorted(range(len(values)), key=lambda i: values[i])
+    r = [0.0] * len(values)
+    ties = 0
+    i = 0
+    while i < len(order):
+        j = i
+        while j + 1 < len(order) and values[order[j + 1]] == values[order[i]]:
+            j += 1
+        for k in range(i, j + 1):
+            r[order[k]] = (i + j) / 2 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+    return r, ties
+
+
+def u_distribution(n1, n2):
+    """Number of arrangements giving each U, for n1 and n2 samples without ties."""
+    # counts[m][n] built up row by row: f(m, n, u) = f(m-1, n, u-n) + f(m, n-1, u)
+    prev = [[1] for _ in range(n2 + 1)]         # m = 0: U is 0
+    for m in range(1, n1 + 1):
+        cur = [[1]]                             # n = 0: U is 0
+        for n in range(1, n2 + 1):
+            size = m * n + 1
+            f = [0] * size
+            for u, c in enumerate(prev[n]):     # last value from the first sample
+                f[u + n] += c
+            for u, c in enumerate(cur[n - 1]):  # last value from the second sample
+                f[u] += c
+            cur.append(f)
+        prev = cur
+    return prev[n2]
+
+
+def mann_whitney(a, b):
+    """Two-sided p-value of the Mann-Whitney U test."""
+    n1, n2 = len(a), len(b)
+    r, ties = ranks(a + b)
+    u1 = sum(r[:n1]) - n1 * (n1 + 1) / 2
+    u = min(u1, n1 * n2 - u1)
+
+    if ties == 0 and n1 + n2 <= EXACT_LIMIT:
+        dist = u_distribution(n1, n2)
+        total = sum(dist)
+        tail = sum(dist[:int(u) + 1]) / total
+        return min(1.0, 2 * tail)
+
+    n = n1 + n2
+    var = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)))
+    if var <= 0:
+        return 1.0                              # All values equal
+    z = (abs(u1 - n1 * n2 / 2) - 0.5) / math.sqrt(var)
+    return min(1.0, math.erfc(max(z, 0) / math.sqrt(2)))
+
+
+def min_p(n1, n2):
+    """Smallest two-sided exact p-value n1 and n2 samples can give."""
+    return min(1.0, 2 / math.comb(n1 + n2, n1))
+
+
+def bootstrap_ratio(a, b, rng):
+    """95% percentile interval of median(b) / median(a)."""
+    ratios = []
+    for _ in range(BOOTSTRAP_ROUNDS):
+        ma = median(rng.choices(a, k=len(a)))
+        mb = median(rng.choices(b, k=len(b)))
+        if ma > 0:
+            ratios.append(mb / ma)
+    if not ratios:
+        return None, None
+    ratios.sort()
+    return ratios[int(0.025 * (len(ratios) - 1))], ratios[int(0.975 * (len(ratios) - 1))]
+
+
+def holm(pvalues):
+    """Holm-adjusted p-values, in the input order."""
+    order = sorted(range(len(pvalues)), key=lambda i: pvalues[i])
+    adjusted = [1.0] * len(pvalues)
+    running = 0.0
+    for rank, i in enumerate(order):
+        running = max(running, min(1.0, (len(pvalues) - rank) * pvalues[i]))
+        adjusted[i] = running
+    return adjusted
+
+# ============================================================================
+# COMPARISON
+# ============================================================================
+
+def compare(base, new, key, alpha, min_effect, use_holm, seed):
+    """One result dict per (point, metric) with samples on both sides."""
+    rng = random.Random(seed)
+    base_points, new_points = group(base, key), group(new, key)
+    tests = []
+    for point in sorted(set(base_points) & set(new_points),
+                        key=lambda p: [(0, float(v)) if number(v) is not None else (1, v) for v in p]):
+        for metric, higher_better in METRICS.items():
+            a = [r[metric] for r in base_points[point] if r[metric] is not None]
+            b = [r[metric] for r in new_points[point] if r[metric] is not None]
+            if not a or not b:
+                continue
+            t = {'point': point, 'metric': metric, 'n_base': len(a), 'n_new': len(b),
+                 'base': median(a), 'new': median(b), 'p': None, 'lo': None, 'hi': None}
+            t['ratio'] = t['new'] / t['base'] if t['base'] else None
+            if len(a) >= 2 and len(b) >= 2:
+                t['p'] = mann_whitney(a, b)
+                t['lo'], t['hi'] = bootstrap_ratio(a, b, rng)
+            tests.append(t)
+
+    tested = [t for t in tests if t['p'] is not None]
+    adjusted = holm([t['p'] for t in tested]) if use_holm else [t['p'] for t in tested]
+    for t, p in zip(tested, adjusted):
+        t['p_adj'] = p
+
+    for t in tests:
+        t['verdict'] = ''
+        if t['p'] is None:
+            t['verdict'] = 'n<2'
+            continue
+        if t['ratio'] is None or t['lo'] is None:
+            continue
+        significant = (t['p_adj'] < alpha and (t['lo'] > 1 or t['hi'] < 1)
+                       and abs(t['ratio'] - 1) >= min_effect)
+        if significant:
+            up = t['ratio'] > 1
+            t['verdict'] = 'better' if up == METRICS[t['metric']] else 'worse'
+    return tests
+
+# ============================================================================
+# OUTPUT
+# ============================================================================
+
+def fmt(value, spec):
+    return '-' if value is None else format(value, spec)
+
+
+def print_table(tests, key, show_all):
+    rows = [t for t in tests if show_all or t['verdict'] in ('better', 'worse')]
+    if not rows:
+        return
+    header = ['point', 'metric', 'n', 'base', 'new', 'new/base', '95% CI', 'p (adj)', 'change']
+    table = [header]
+    for t in rows:
+        point = " ".join(f"{c}={v}" for c, v in zip(key, t['point']) if v != '')
+        ci = f"[{fmt(t['lo'], '.3f')}, {fmt(t['hi'], '.3f')}]" if t['lo'] is not None else '-'
+        table.append([point, t['metric'], f"{t['n_base']}/{t['n_new']}",
+                      fmt(t['base'], '.4g'), fmt(t['new'], '.4g'), fmt(t['ratio'], '.3f'),
+                      ci, fmt(t.get('p_adj'), '.3g'), t['verdict']])
+    widths = [max(len(row[i]) for row in table) for i in range(len(header))]
+    for i, row in enumerate(table):
+        print("  ".join(cell.ljust(w) for cell, w in zip(row, widths)).rstrip())
+        if i == 0:
+            print("  ".join('-' * w for w in widths))
+
+
+def write_csv(path, tests, key):
+    with open(path, 'w', newline='') as f:
+        w = csv.writer(f)
+        w.writerow(key + ['metric', 'n_base', 'n_new', 'median_base', 'median_new', 'ratio',
+                          'ci_low', 'ci_high', 'p', 'p_adj', 'change'])
+        for t in tests:
+            w.writerow(list(t['point']) + [t['metric'], t['n_base'], t['n_new'], t['base'], t['new'],
+                                           t['ratio'], t['lo'], t['hi'], t['p'], t.get('p_adj'),
+                                           t['verdict']])
+
+# ============================================================================
+# MAIN
+# ============================================================================
+
+def main():
+    parser = argparse.ArgumentParser(description="Statistical A/B comparison of two result sets")
+    parser.add_argument('sets', nargs='+', metavar='SET', help="base [and new] CSV or timestamp")
+    parser.add_argument('--base', action='append', metavar='COL=VALUE', help="filter on the base set")
+    parser.add_argument('--new', action='append', metavar='COL=VALUE', help="filter on the new set")
+    parser.add_argument('--alpha', type=float, default=0.05, help="significance level (default 0.05)")
+    parser.add_argument('--min-effect', type=float, default=0.0,
+                        help="smallest relative change to report, e.g. 0.02 (default 0)")
+    parser.add_argument('--no-holm', action='store_true', help="do not adjust for multiple tests")
+    parser.add_argument('--seed', type=int, default=SEED, help="bootstrap seed")
+    parser.add_argument('--all', action='store_true', help="print every test")
+    parser.add_argument('--csv', metavar='FILE', help="write every test to FILE")
+    parser.add_argument('--fail-on-regression', action='store_true',
+                        help="exit 1 if any metric got significantly worse")
+    args = parser.parse_args()
+
+    if len(args.sets) > 2:
+        parser.error("at most two result sets")
+    try:
+        base_path = resolve(args.sets[0])
+        new_path = resolve(args.sets[-1])
+        base = load_rows(base_path, parse_filters(args.base))
+        new = load_rows(new_path, parse_filters(args.new))
+    except (OSError, KeyError, ValueError) as e:
+        print(f"[ERROR] {e}")
+        return 2
+    if not base or not new:
+        print(f"[ERROR] No rows in the {'base' if not base else 'new'} set")
+        return 2
+
+    compared = compared_columns(base, new)
+    key = [c for c in KEY_COLUMNS if c not in compared]
+    if base_path == new_path and not compared and not (args.base or args.new):
+        print("[WARN] Base and new are the same rows; use --base/--new to select two sets")
+
+    print(f"Base: {base_path} ({len(base)} rows{', ' + ' '.join(args.base) if args.base else ''})")
+    print(f"New:  {new_path} ({len(new)} rows{', ' + ' '.join(args.new) if args.new else ''})")
+    if compared:
+        print("Comparing " + ", ".join(f"{c} {base[0].get(c)} -> {new[0].get(c)}" for c in compared))
+
+    tests = compare(base, new, key, args.alpha, args.min_effect, not args.no_holm, args.seed)
+    if not tests:
+        print("[ERROR] No common points (key: " + ", ".join(key) + ")")
+        return 2
+
+    points = len({t['point'] for t in tests})
+    tested = [t for t in tests if t['p'] is not None]
+    better = [t for t in tests if t['verdict'] == 'better']
+    worse = [t for t in tests if t['verdict'] == 'worse']
+    print(f"{points} common points, {len(tested)} of {len(tests)} metric comparisons tested "
+          f"(alpha {args.alpha}, {'raw p' if args.no_holm else 'Holm-adjusted'}"
+          f"{f', min effect {args.min_effect:.0%}' if args.min_effect else ''})")
+    print()
+    print_table(tests, key, args.all)
+    if better or worse:
+        print()
+    print(f"Significant: {len(better)} better, {len(worse)} worse, "
+          f"{len(tested) - len(better) - len(worse)} unchanged or inconclusive")
+
+    # Points whose sample sizes cannot reach significance at all
+    weak = {(t['n_base'], t['n_new']) for t in tested if min_p(t['n_base'], t['n_new']) >= args.alpha}
+    if weak:
+        print(f"[WARN] With {', '.join(f'{a}/{b}' for a, b in sorted(weak))} samples the U test "
+              f"cannot reach p < {args.alpha}; run more repeats (4 per side or more)")
+    if len(tested) < len(tests):
+        print(f"[WARN] {len(tests) - len(tested)} comparisons have fewer than 2 samples on a side")
+
+    if args.csv:
+        write_csv(args.csv, tests, key)
+        print(f"All tests written to {args.csv}")
+    return 1 if args.fail_on_regression and worse else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -10,6 +10,7 @@ matplotlib.use('Agg')  # Use non-interactive backend
 import matplotlib.pyplot as plt
 import numpy as np
 import pandas as pd
+import glob
 import os
 import sys
 
@@ -59,6 +60,15 @@ def load_data():
 
     return data
 
+def load_experiment():
+    """Latest combined CSV from MT25033_Part_C_Experiment.sh (or None)."""
+    paths = sorted(glob.glob(f'{CSV_DIR}/MT25033_Part_B_Results_*.csv'))
+    if not paths:
+        return None
+    df = pd.read_csv(paths[-1])
+    print(f"  Loaded experiment: {len(df)} rows from {paths[-1]}")
+    return df
+
 # ============================================================================
 # PLOTTING
 # ============================================================================
@@ -273,6 +283,108 @@ def plot_context_switches(data):
     print(f"    Saved: {path}")
 
 
+def plot_topdown(exp):
+    """Plot 7: Top-down level-1 breakdown and cache misses per KB, server and client."""
+    print("  Creating top-down plot...")
+
+    impls = {'two_copy': 'A1', 'one_copy': 'A2', 'zero_copy': 'A3'}
+    if exp is None or 'srv_retiring' not in exp.columns:
+        print("    Skipped: no experiment CSV with top-down columns")
+        return
+    d = exp[(exp['variant'] == 'base') & exp['implementation'].isin(impls.keys())]
+    d = d[d['threads'] == d['threads'].min()]
+    if d[['srv_retiring', 'cli_retiring']].isna().all().all() and \
+       d[['srv_l1d_mpkb', 'cli_l1d_mpkb']].isna().all().all():
+        print("    Skipped: top-down counters were not available on this machine")
+        return
+
+    categories = [('retiring', 'Retiring', '#2ecc71'), ('bad_spec', 'Bad speculation', '#e67e22'),
+                  ('fe_bound', 'Frontend bound', '#9b59b6'), ('be_bound', 'Backend bound', '#e74c3c')]
+    d = d.sort_values(['msg_size', 'implementation'])
+    labels = [f"{impls[r.implementation]}\n{get_size_label(r.msg_size)}" for r in d.itertuples()]
+    x = np.arange(len(d))
+
+    fig, axes = plt.subplots(2, 2, figsize=(16, 10))
+    for col, (side, title) in enumerate([('srv', 'Server (sender)'), ('cli', 'Client (receiver)')]):
+        # Stacked level-1 shares; hatched part of backend bound is memory bound
+        ax = axes[0, col]
+        bottom = np.zeros(len(d))
+        for key, name, color in categories:
+            values = d[f'{side}_{key}'].fillna(0).values
+            ax.bar(x, values, 0.6, bottom=bottom, label=name, color=color)
+            if key == 'be_bound':
+                mem = d[f'{side}_mem_bound'].fillna(0).values
+                ax.bar(x, mem, 0.6, bottom=bottom, fill=False, hatch='//',
+                       edgecolor='black', label='Memory bound')
+            bottom += values
+        ax.set_title(f'Top-down level 1: {title}')
+        ax.set_ylabel('% of pipeline slots')
+        ax.set_xticks(x)
+        ax.set_xticklabels(labels, fontsize=8)
+        ax.set_ylim(0, 100)
+        ax.legend(fontsize=8)
+
+        # L1D vs LLC misses per KB: LLC near 16/KB means streaming from DRAM
+        ax = axes[1, col]
+        ax.bar(x - 0.15, d[f'{side}_l1d_mpkb'].fillna(0).values, 0.3,
+               label='L1D read misses / KB', color='#3498db')
+        ax.bar(x + 0.15, d[f'{side}_llc_mpkb'].fillna(0).values, 0.3,
+               label='LLC read misses / KB', color='#34495e')
+        ax.axhline(16, color='gray', linestyle='--', linewidth=1, label='One miss per 64 B line')
+        ax.set_title(f'Cache misses per KB moved: {title}')
+        ax.set_ylabel('Misses per KB')
+        ax.set_xticks(x)
+        ax.set_xticklabels(labels, fontsize=8)
+        ax.legend(fontsize=8)
+        ax.grid(axis='y', alpha=0.3)
+
+    fig.suptitle('Top-Down Microarchitecture Breakdown per Copy Strategy\nMT25033')
+    plt.tight_layout()
+    path = f'{OUTPUT_DIR}/MT25033_Plot7_TopDown.png'
+    plt.savefig(path, dpi=150)
+    plt.close()
+    print(f"    Saved: {path}")
+
+
+def plot_energy(exp):
+    """Plot 8: Energy per GB and power next to throughput (RAPL)."""
+    print("  Creating energy plot...")
+
+    impls = {'two_copy': 'A1', 'one_copy': 'A2', 'zero_copy': 'A3'}
+    if exp is None or 'joules_per_gb' not in exp.columns or exp['joules_per_gb'].isna().all():
+        print("    Skipped: no RAPL energy in the experiment CSV")
+        return
+    d = exp[(exp['variant'] == 'base') & exp['implementation'].isin(impls.keys())]
+    d = d[d['threads'] == d['threads'].max()]
+
+    fig, axes = plt.subplots(1, 3, figsize=(16, 5))
+    markers = {'A1': 'o', 'A2': 's', 'A3': '^'}
+    for name, impl in impls.items():
+        r = d[d['implementation'] == name].sort_values('msg_size')
+        if len(r) == 0:
+            continue
+        x = range(len(r))
+        for ax, col in zip(axes, ['throughput_gbps', 'joules_per_gb', 'watts']):
+            ax.plot(x, r[col].values, f'{markers[impl]}-', linewidth=2, markersize=8,
+                    label=LABELS[impl], color=COLORS[impl])
+            ax.set_xticks(list(x))
+            ax.set_xticklabels([get_size_label(v) for v in r['msg_size'].values])
+
+    for ax, ylabel in zip(axes, ['Throughput (Gbps)', 'Energy per GB (J, package + DRAM)',
+                                 'Power (W, package + DRAM)']):
+        ax.set_xlabel('Message Size')
+        ax.set_ylabel(ylabel)
+        ax.grid(alpha=0.3)
+        ax.legend()
+    fig.suptitle(f'Energy per Copy Strategy ({int(d["threads"].max())} Threads)\nMT25033')
+
+    plt.tight_layout()
+    path = f'{OUTPUT_DIR}/MT25033_Plot8_Energy.png'
+    plt.savefig(path, dpi=150)
+    plt.close()
+    print(f"    Saved: {path}")
+
+
 def plot_summary(data):
     """Plot 6: Combined Summary (2x3 grid)."""
     print("  Creating summary plot...")
@@ -455,6 +567,18 @@ def main():
     except Exception as e:
         print(f"  ERROR in summary plot: {e}")
 
+    exp = load_experiment()
+
+    try:
+        plot_topdown(exp)
+    except Exception as e:
+        print(f"  ERROR in top-down plot: {e}")
+
+    try:
+        plot_energy(exp)
+    except Exception as e:
+        print(f"  ERROR in energy plot: {e}")
+
     print("\n" + "="*60)
     print("DONE! Check for PNG files:")
     print("="*60)
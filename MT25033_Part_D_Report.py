@@ -0,0 +1,469 @@
+#!/usr/bin/env python3
+"""
+MT25033_Part_D_Report.py
+Self-contained HTML report of one sweep for PA02
+Roll Number: MT25033
+
+Reads the files of one sweep timestamp from results/:
+  MT25033_Part_B_Results_<ts>.csv   results rows (required)
+  MT25033_Part_B_Manifest_<ts>.txt  machine and software (key=value)
+  MT25033_Part_B_Kstat_<ts>.csv     kernel counter deltas
+  MT25033_Part_B_Journal_<ts>.log   completed and failed points
+and writes results/MT25033_Part_B_Report_<ts>.html: one file with inline
+CSS and SVG and no scripts, so it opens anywhere and can be mailed around.
+
+Sections: environment; a matrix of throughput, latency percentiles, cycles
+per byte and Gbps per core per point (median over repeats); bar charts of
+throughput, p99 and cycles per byte against message size per engine;
+speedup heatmaps of every engine against the baseline (two_copy, i.e. A1);
+anomalies (zero-copy sends the kernel copied or never made, retransmits,
+softnet drops, failed or noisy points).
+
+Usage:
+  python3 MT25033_Part_D_Report.py [timestamp] [--baseline ENGINE] [-o FILE]
+  Without a timestamp the latest results file is used.
+"""
+
+import argparse
+import csv
+import glob
+import html
+import math
+import os
+import statistics
+import sys
+import time
+
+# ============================================================================
+# CONFIGURATION
+# ============================================================================
+
+CSV_DIR = "results"
+BASELINE = "two_copy"
+
+# Same colors as the plots for A1-A3; other engines take the rest in turn
+COLORS = {'two_copy': '#3498db', 'one_copy': '#2ecc71', 'zero_copy': '#e74c3c'}
+PALETTE = ['#9b59b6', '#f39c12', '#1abc9c', '#34495e', '#e67e22', '#7f8c8d', '#c0392b', '#16a085']
+
+# Anomaly thresholds
+NOISE_CV = 0.10             # Coefficient of variation of throughput over repeats
+ZC_COPIED_SHARE = 0.5       # Share of zero-copy sends the kernel copied
+
+# Matrix columns: (CSV column, heading, format)
+MATRIX = [
+    ('throughput_gbps', 'Gbps', '.3f'),
+    ('latency_us', 'avg µs', '.1f'),
+    ('p50_us', 'p50 µs', '.1f'),
+    ('p99_us', 'p99 µs', '.1f'),
+    ('p999_us', 'p99.9 µs', '.1f'),
+    ('cycles_per_byte', 'cycles/B', '.3f'),
+    ('gbps_per_core', 'Gbps/core', '.2f'),
+    ('retrans_segs', 'retrans', '.0f'),
+]
+
+CSS = """
+body { font-family: -apple-system, 'Segoe UI', Helvetica, Arial, sans-serif; margin: 2em auto;
+       max-width: 1200px; color: #2c3e50; }
+h1 { border-bottom: 2px solid #3498db; padding-bottom: .3em; }
+h2 { margin-top: 2em; border-bottom: 1px solid #ddd; padding-bottom: .2em; }
+table { border-collapse: collapse; font-size: 13px; margin: 1em 0; }
+th, td { border: 1px solid #ddd; padding: 3px 8px; text-align: right; }
+th { background: #f4f6f8; }
+td.l, th.l { text-align: left; }
+.note { color: #7f8c8d; font-size: 13px; }
+.warn { color: #c0392b; }
+svg { margin: .5em 1em .5em 0; }
+"""
+
+def get_size_label(size):
+    """Convert bytes to human readable."""
+    if size >= 1048576:
+        return f'{size//1048576}MB'
+    elif size >= 1024:
+        return f'{size//1024}KB'
+    return f'{size}B'
+
+# ============================================================================
+# LOAD DATA
+# ============================================================================
+
+def number(value):
+    try:
+        v = float(value)
+        return v if math.isfinite(v) else None
+    except (TypeError, ValueError):
+        return None
+
+
+def latest_timestamp():
+    paths = sorted(glob.glob(f'{CSV_DIR}/MT25033_Part_B_Results_*.csv'))
+    if not paths:
+        return None
+    return os.path.basename(paths[-1])[len('MT25033_Part_B_Results_'):-len('.csv')]
+
+
+def load_results(path):
+    """Rows with numeric columns converted and cycles per byte derived."""
+    with open(path) as f:
+        rows = list(csv.DictReader(f))
+    for r in rows:
+        for key, value in list(r.items()):
+            if key not in ('implementation', 'variant', 'build'):
+                r[key] = number(value)
+        r['msg_size'] = int(r['msg_size'] or 0)
+        r['threads'] = int(r['threads'] or 0)
+        cycles, total = r.get('cycles'), r.get('total_bytes')
+        r['cycles_per_byte'] = cycles / total if cycles and total else None
+    return rows
+
+
+def load_manifest(path):
+    manifest = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                if '=' in line:
+                    key, value = line.rstrip('\n').split('=', 1)
+                    manifest[key] = value
+    return manifest
+
+
+def load_kstat(path):
+    """Summed deltas per (implementation, msg_size, threads, variant) and counter."""
+    deltas = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for r in csv.DictReader(f):
+                key = (r['implementation'], int(r['msg_size']), int(r['threads']), r['variant'])
+                counter = f"{r['side']}:{r['counter']}"
+                deltas.setdefault(key, {})
+                deltas[key][counter] = deltas[key].get(counter, 0) + (number(r['delta']) or 0)
+    return deltas
+
+
+def load_journal(path):
+    """Tags that failed at least once and never completed."""
+    done, failed = set(), set()
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) >= 3:
+                    (done if parts[1] == 'done' else failed).add(parts[2])
+    return sorted(failed - done)
+
+
+def points(rows):
+    """Rows grouped by (implementation, msg_size, threads, variant), sorted."""
+    out = {}
+    for r in rows:
+        out.setdefault((r['implementation'], r['msg_size'], r['threads'], r['variant']), []).append(r)
+    return dict(sorted(out.items()))
+
+
+def med(rows, column):
+    values = [r[column] for r in rows if r.get(column) is not None]
+    return statistics.median(values) if values else None
+
+# ============================================================================
+# SVG
+# ============================================================================
+
+def color(engine, engines):
+    if engine in COLORS:
+        return COLORS[engine]
+    others = [e for e in engines if e not in COLORS]
+    return PALETTE[others.index(engine) % len(PALETTE)]
+
+
+def nice_max(value):
+    """Round an axis maximum up to 1, 2 or 5 times a power of ten."""
+    if value <= 0:
+        return 1
+    mag = 10 ** math.floor(math.log10(value))
+    for step in (1, 2, 5, 10):
+        if value <= step * mag:
+            return step * mag
+    return 10 * mag
+
+
+def svg_bars(title, categories, series, engines, unit):
+    """Grouped bar chart: one group per category, one bar per series."""
+    width, height = 560, 300
+    left, right, top, bottom = 60, 140, 30, 40
+    plot_w, plot_h = width - left - right, height - top - bottom
+    values = [v for vs in series.values() for v in vs if v is not None]
+    if not values or not categories:
+        return ''
+    ymax = nice_max(max(values))
+
+    out = [f'<svg xmlns="http://www.w3.org/2000/svg" width="{width}" height="{height}" '
+           f'font-family="sans-serif" font-size="11">',
+           f'<text x="{width / 2 - right / 2}" y="16" text-anchor="middle" font-size="13" '
+           f'font-weight="bold">{html.escape(title)}</text>']
+    for i in range(6):
+        y = top + plot_h - plot_h * i / 5
+        out.append(f'<line x1="{left}" y1="{y:.1f}" x2="{left + plot_w}" y2="{y:.1f}" stroke="#eee"/>')
+        out.append(f'<text x="{left - 5}" y="{y + 4:.1f}" text-anchor="end">{ymax * i / 5:g}</text>')
+    out.append(f'<text x="14" y="{top + plot_h / 2}" text-anchor="middle" '
+               f'transform="rotate(-90 14 {top + plot_h / 2})">{html.escape(unit)}</text>')
+
+    group_w = plot_w / len(categories)
+    bar_w = group_w * 0.8 / max(1, len(series))
+    for c, category in enumerate(categories):
+        x0 = left + c * group_w + group_w * 0.1
+        out.append(f'<text x="{left + (c + 0.5) * group_w:.1f}" y="{top + plot_h + 15}" '
+                   f'text-anchor="middle">{html.escape(category)}</text>')
+        for s, (name, vs) in enumerate(series.items()):
+            v = vs[c]
+            if v is None:
+                continue
+            h = plot_h * min(v, ymax) / ymax
+            out.append(f'<rect x="{x0 + s * bar_w:.1f}" y="{top + plot_h - h:.1f}" width="{bar_w:.1f}" '
+                       f'height="{h:.1f}" fill="{color(name, engines)}"><title>{html.escape(name)} '
+                       f'{html.escape(category)}: {v:.4g} {html.escape(unit)}</title></rect>')
+    out.append(f'<line x1="{left}" y1="{top + plot_h}" x2="{left + plot_w}" y2="{top + plot_h}" stroke="#555"/>')
+
+    for s, name in enumerate(series):
+        y = top + 10 + s * 16
+        out.append(f'<rect x="{left + plot_w + 10}" y="{y - 9}" width="10" height="10" '
+                   f'fill="{color(name, engines)}"/>')
+        out.append(f'<text x="{left + plot_w + 25}" y="{y}">{html.escape(name)}</text>')
+    out.append('</svg>')
+    return '\n'.join(out)
+
+
+def heat_color(ratio):
+    """Red below 1, white at 1, green above; saturates at 0.5x and 2x."""
+    if ratio is None:
+        return '#f4f6f8'
+    t = max(-1.0, min(1.0, math.log2(ratio)))
+    if t >= 0:
+        r, g, b = 255 - int(t * 180), 255 - int(t * 60), 255 - int(t * 180)
+    else:
+        r, g, b = 255 + int(t * 40), 255 + int(t * 180), 255 + int(t * 180)
+    return f'#{r:02x}{g:02x}{b:02x}'
+
+
+def svg_heatmap(title, sizes, threads, cells):
+    """Speedup grid: rows are message sizes, columns thread counts."""
+    cell_w, cell_h, left, top = 70, 26, 70, 44
+    width, height = left + cell_w * len(threads) + 10, top + cell_h * len(sizes) + 10
+    out = [f'<svg xmlns="http://www.w3.org/2000/svg" width="{width}" height="{height}" '
+           f'font-family="sans-serif" font-size="11">',
+           f'<text x="4" y="14" font-size="13" font-weight="bold">{html.escape(title)}</text>']
+    for j, t in enumerate(threads):
+        out.append(f'<text x="{left + (j + 0.5) * cell_w}" y="{top - 6}" text-anchor="middle">{t} thr</text>')
+    for i, size in enumerate(sizes):
+        y = top + i * cell_h
+        out.append(f'<text x="{left - 6}" y="{y + cell_h / 2 + 4}" text-anchor="end">{get_size_label(size)}</text>')
+        for j, t in enumerate(threads):
+            ratio = cells.get((size, t))
+            x = left + j * cell_w
+            out.append(f'<rect x="{x}" y="{y}" width="{cell_w}" height="{cell_h}" '
+                       f'fill="{heat_color(ratio)}" stroke="#fff"/>')
+            if ratio is not None:
+                out.append(f'<text x="{x + cell_w / 2}" y="{y + cell_h / 2 + 4}" '
+                           f'text-anchor="middle">{ratio:.2f}x</text>')
+    out.append('</svg>')
+    return '\n'.join(out)
+
+# ============================================================================
+# SECTIONS
+# ============================================================================
+
+def fmt(value, spec):
+    return '' if value is None else format(value, spec)
+
+
+def section_environment(manifest, rows, ts):
+    out = ['<h2>Environment</h2>']
+    if not manifest:
+        out.append(f'<p class="note">No manifest for {html.escape(ts)} '
+                   '(sweeps before manifests were recorded).</p>')
+    else:
+        out.append('<table>')
+        for key, value in manifest.items():
+            out.append(f'<tr><th class="l">{html.escape(key)}</th><td class="l">{html.escape(value)}</td></tr>')
+        out.append('</table>')
+    builds = sorted({r['build'] for r in rows if r.get('build')})
+    repeats = max(len(v) for v in points(rows).values())
+    out.append(f'<p class="note">{len(rows)} rows, {len(points(rows))} points, up to {repeats} '
+               f'repeats per point{", builds " + ", ".join(builds) if builds else ""}. '
+               'Values are medians over repeats.</p>')
+    return '\n'.join(out)
+
+
+def section_matrix(pts, columns):
+    out = ['<h2>Results</h2>', '<table>',
+           '<tr><th class="l">engine</th><th>size</th><th>threads</th><th class="l">variant</th><th>n</th>' +
+           ''.join(f'<th>{html.escape(head)}</th>' for col, head, _ in columns) + '</tr>']
+    for (engine, size, threads, variant), rs in pts.items():
+        out.append(f'<tr><td class="l">{html.escape(engine)}</td><td>{get_size_label(size)}</td>'
+                   f'<td>{threads}</td><td class="l">{html.escape(variant)}</td><td>{len(rs)}</td>' +
+                   ''.join(f'<td>{fmt(med(rs, col), spec)}</td>' for col, head, spec in columns) + '</tr>')
+    out.append('</table>')
+    return '\n'.join(out)
+
+
+def main_variant(pts):
+    """Variant with the most points (the one the charts are drawn for)."""
+    counts = {}
+    for (_, _, _, variant) in pts:
+        counts[variant] = counts.get(variant, 0) + 1
+    return max(counts, key=lambda v: (counts[v], v == 'base'))
+
+
+def section_charts(pts, engines, variant):
+    out = ['<h2>Charts</h2>',
+           f'<p class="note">Variant <b>{html.escape(variant)}</b>, one chart row per thread count.</p>']
+    sel = {k: v for k, v in pts.items() if k[3] == variant}
+    sizes = sorted({k[1] for k in sel})
+    for threads in sorted({k[2] for k in sel}):
+        for col, title, unit in (('throughput_gbps', 'Throughput', 'Gbps'),
+                                 ('p99_us', 'p99 latency', 'µs'),
+                                 ('cycles_per_byte', 'Cycles per byte', 'cycles/B')):
+            series = {}
+            for engine in engines:
+                vs = [med(sel[(engine, s, threads, variant)], col) if (engine, s, threads, variant) in sel else None
+                      for s in sizes]
+                if any(v is not None for v in vs):
+                    series[engine] = vs
+            if series:
+                out.append(svg_bars(f'{title}, {threads} threads', [get_size_label(s) for s in sizes],
+                                    series, engines, unit))
+        out.append('<br>')
+    return '\n'.join(out)
+
+
+def section_speedup(pts, engines, baseline):
+    out = ['<h2>Speedup against ' + html.escape(baseline) + '</h2>']
+    if baseline not in engines:
+        out.append(f'<p class="note">No {html.escape(baseline)} rows in this sweep.</p>')
+        return '\n'.join(out)
+    out.append('<p class="note">Median throughput of each engine divided by the baseline\'s at the '
+               'same size, threads and variant. Green is faster, red slower.</p>')
+    variants = sorted({k[3] for k in pts}, key=lambda v: (v != 'base', v))
+    for variant in variants:
+        sizes = sorted({k[1] for k in pts if k[3] == variant})
+        threads = sorted({k[2] for k in pts if k[3] == variant})
+        maps = []
+        for engine in engines:
+            if engine == baseline:
+                continue
+            cells = {}
+            for s in sizes:
+                for t in threads:
+                    a, b = pts.get((baseline, s, t, variant)), pts.get((engine, s, t, variant))
+                    base, new = (med(a, 'throughput_gbps') if a else None,
+                                 med(b, 'throughput_gbps') if b else None)
+                    if base and new is not None:
+                        cells[(s, t)] = new / base
+            if cells:
+                maps.append(svg_heatmap(f'{engine} ({variant})', sizes, threads, cells))
+        out.extend(maps)
+    return '\n'.join(out)
+
+
+def anomalies(pts, kstat, failed):
+    """(point, issue) pairs."""
+    found = []
+    for key, rs in pts.items():
+        engine = key[0]
+        label = f'{engine} {get_size_label(key[1])} {key[2]} threads {key[3]}'
+        gbps = [r['throughput_gbps'] for r in rs if r.get('throughput_gbps') is not None]
+        if not gbps or max(gbps) == 0:
+            found.append((label, 'no throughput recorded'))
+        elif len(gbps) > 1 and statistics.mean(gbps) > 0:
+            cv = statistics.stdev(gbps) / statistics.mean(gbps)
+            if cv > NOISE_CV:
+                found.append((label, f'noisy: throughput varies {cv:.0%} over {len(gbps)} repeats'))
+
+        if engine.startswith('zero_copy') and 'zc_sends' in rs[0]:
+            sends, copied = med(rs, 'zc_sends'), med(rs, 'zc_copied')
+            if not sends:
+                found.append((label, 'zero-copy fallback: no zero-copy sends completed'))
+            elif copied and copied / sends >= ZC_COPIED_SHARE:
+                found.append((label, f'zero-copy fallback: kernel copied {copied / sends:.0%} '
+                                     f'of {sends:.0f} sends'))
+
+        runs = f" in {len(rs)} runs" if len(rs) > 1 else ""
+        retrans = sum(r.get('retrans_segs') or 0 for r in rs)
+        if retrans:
+            found.append((label, f'{retrans:.0f} retransmitted segments{runs}'))
+        drops = sum(r.get('softnet_drops') or 0 for r in rs)
+        if drops:
+            found.append((label, f'{drops:.0f} softnet drops{runs}'))
+        counters = kstat.get(key, {})
+        for counter in ('client:Tcp.RetransSegs', 'client:Softnet.dropped', 'server:TcpExt.TCPTimeouts'):
+            if counters.get(counter):
+                found.append((label, f'{counter} {counters[counter]:.0f}{runs}'))
+    for tag in failed:
+        found.append((tag, 'failed and never completed (see the journal)'))
+    return found
+
+
+def section_anomalies(found):
+    out = ['<h2>Anomalies</h2>']
+    if not found:
+        out.append('<p class="note">None found.</p>')
+        return '\n'.join(out)
+    out.append('<table><tr><th class="l">point</th><th class="l">issue</th></tr>')
+    for label, issue in found:
+        out.append(f'<tr><td class="l">{html.escape(label)}</td><td class="l warn">{html.escape(issue)}</td></tr>')
+    out.append('</table>')
+    return '\n'.join(out)
+
+# ============================================================================
+# MAIN
+# ============================================================================
+
+def main():
+    parser = argparse.ArgumentParser(description="Self-contained HTML report of one sweep")
+    parser.add_argument('timestamp', nargs='?', help="sweep timestamp (default: latest)")
+    parser.add_argument('--baseline', default=BASELINE, help=f"engine speedups are relative to (default {BASELINE})")
+    parser.add_argument('-o', '--output', help="output file (default results/MT25033_Part_B_Report_<ts>.html)")
+    args = parser.parse_args()
+
+    ts = args.timestamp or latest_timestamp()
+    results = f'{CSV_DIR}/MT25033_Part_B_Results_{ts}.csv'
+    if not ts or not os.path.exists(results):
+        print(f"[ERROR] No results file {results if ts else 'in ' + CSV_DIR}")
+        return 1
+    rows = load_results(results)
+    if not rows:
+        print(f"[ERROR] {results} has no rows")
+        return 1
+
+    manifest = load_manifest(f'{CSV_DIR}/MT25033_Part_B_Manifest_{ts}.txt')
+    kstat = load_kstat(f'{CSV_DIR}/MT25033_Part_B_Kstat_{ts}.csv')
+    failed = load_journal(f'{CSV_DIR}/MT25033_Part_B_Journal_{ts}.log')
+    pts = points(rows)
+    engines = sorted({k[0] for k in pts}, key=lambda e: (e not in COLORS, list(COLORS).index(e)
+                                                         if e in COLORS else 0, e))
+    columns = [c for c in MATRIX if any(r.get(c[0]) is not None for r in rows)]
+    found = anomalies(pts, kstat, failed)
+
+    body = [
+        f'<h1>PA02 Network I/O sweep {html.escape(ts)}</h1>',
+        f'<p class="note">MT25033 &middot; generated {time.strftime("%Y-%m-%d %H:%M")} from '
+        f'{html.escape(results)} &middot; {len(found)} anomalies</p>',
+        section_environment(manifest, rows, ts),
+        section_matrix(pts, columns),
+        section_charts(pts, engines, main_variant(pts)),
+        section_speedup(pts, engines, args.baseline),
+        section_anomalies(found),
+    ]
+    page = ('<!DOCTYPE html>\n<html lang="en"><head><meta charset="utf-8">'
+            f'<title>MT25033 sweep {html.escape(ts)}</title><style>{CSS}</style></head>\n<body>\n' +
+            '\n'.join(body) + '\n</body></html>\n')
+
+    output = args.output or f'{CSV_DIR}/MT25033_Part_B_Report_{ts}.html'
+    with open(output, 'w') as f:
+        f.write(page)
+    print(f"Report: {output} ({len(pts)} points, {len(found)} anomalies)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())